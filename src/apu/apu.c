@@ -0,0 +1,457 @@
+// The Golden Rule: Include your own header first.
+#include "apu/apu.h"
+
+#include <stddef.h>
+#include <string.h>
+#include "bus/bus.h"
+#include "cpu/cpu.h"
+#include "scheduler/scheduler.h"
+
+// --- NTSC Tables ---
+static const u8 length_table[32] = {
+    10, 254, 20, 2, 40, 4, 80, 6, 160, 8, 60, 10, 14, 12, 26, 14,
+    12, 16, 24, 18, 48, 20, 96, 22, 192, 24, 72, 26, 16, 28, 32, 30,
+};
+static const u8 duty_table[4][8] = {
+    { 0, 1, 0, 0, 0, 0, 0, 0 }, { 0, 1, 1, 0, 0, 0, 0, 0 },
+    { 0, 1, 1, 1, 1, 0, 0, 0 }, { 1, 0, 0, 1, 1, 1, 1, 1 },
+};
+static const u8 triangle_table[32] = {
+    15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0,
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+};
+static const u16 noise_periods[16] = { 4, 8, 16, 32, 64, 96, 128, 160, 202, 254, 380, 508, 762, 1016, 2034, 4068 };
+static const u16 dmc_rates[16] = { 428, 380, 340, 320, 286, 254, 226, 214, 190, 160, 142, 128, 106, 84, 72, 54 };
+
+// Frame sequencer steps, in CPU cycles from the start of a sequence. The 4-step sequence
+// repeats every 29830 cycles and raises the frame IRQ on its last step; the 5-step sequence
+// repeats every 37282 cycles and has an empty fourth step.
+static const u32 frame_steps[5] = { 7457, 14913, 22371, 29829, 37281 };
+#define APU_FRAME_PERIOD_4 29830
+#define APU_FRAME_PERIOD_5 37282
+
+// --- Mixer ---
+// The linear approximation of the 2A03's output network, per unit of each channel's level.
+// Keeping the mix linear lets every channel add its own steps independently.
+static const float mix_scale[APU_CHANNEL_COUNT] = { 0.00752f, 0.00752f, 0.00851f, 0.00494f, 0.00335f };
+
+static inline void apu_output(APU* apu, ApuChannel channel, u8 level, u64 cycle) {
+    u8 old = apu->synth.levels[channel];
+    if (level == old || apu->synth.muted) { return; }
+    apu->synth.levels[channel] = level;
+    apu_synth_add(&apu->synth, cycle, (float)((int)level - (int)old) * mix_scale[channel]);
+}
+
+// --- Channel Levels ---
+static inline u8 envelope_level(const ApuEnvelope* env) { return env->constant ? env->volume : env->decay; }
+
+static inline u16 pulse_sweep_target(const ApuPulse* p, int index) {
+    u16 change = p->period >> p->sweep_shift;
+    if (!p->sweep_negate) { return (u16)(p->period + change); }
+    // Pulse 1 negates in one's complement, pulse 2 in two's complement.
+    return (u16)(p->period - change - (index == 0 ? 1 : 0));
+}
+
+static inline bool pulse_muted(const ApuPulse* p, int index) {
+    return p->period < 8 || (!p->sweep_negate && pulse_sweep_target(p, index) > 0x7FF);
+}
+
+static inline bool pulse_audible(const ApuPulse* p, int index) {
+    return p->length && !pulse_muted(p, index) && envelope_level(&p->envelope);
+}
+
+static inline u8 pulse_level(const ApuPulse* p, int index) {
+    return (pulse_audible(p, index) && duty_table[p->duty][p->step]) ? envelope_level(&p->envelope) : 0;
+}
+
+static inline bool noise_audible(const ApuNoise* n) { return n->length && envelope_level(&n->envelope); }
+static inline u8 noise_level(const ApuNoise* n) { return (noise_audible(n) && !(n->lfsr & 1)) ? envelope_level(&n->envelope) : 0; }
+
+// Re-evaluates every channel's level, e.g. after a register write or a frame sequencer step.
+static void apu_update_levels(APU* apu, u64 cycle) {
+    apu_output(apu, APU_PULSE1, pulse_level(&apu->pulse[0], 0), cycle);
+    apu_output(apu, APU_PULSE2, pulse_level(&apu->pulse[1], 1), cycle);
+    apu_output(apu, APU_TRIANGLE, triangle_table[apu->triangle.step], cycle);
+    apu_output(apu, APU_NOISE, noise_level(&apu->noise), cycle);
+    apu_output(apu, APU_DMC, apu->dmc.output, cycle);
+}
+
+// --- Channel Timers ---
+// Each runs its channel's timer over [apu->cycle, end). A timer whose channel cannot change
+// level is advanced in one step.
+static u64 timer_skip(u64* next, u64 end, u64 period) {
+    if (*next >= end) { return 0; }
+    u64 clocks = (end - *next + period - 1) / period;
+    *next += clocks * period;
+    return clocks;
+}
+
+static void apu_run_pulse(APU* apu, int index, u64 end) {
+    ApuPulse* p = &apu->pulse[index];
+    u64 period = ((u64)p->period + 1) * 2;
+    if (!pulse_audible(p, index)) {
+        p->step = (u8)((p->step + timer_skip(&p->next, end, period)) & 7);
+        return;
+    }
+    u8 volume = envelope_level(&p->envelope);
+    const u8* duty = duty_table[p->duty];
+    for (; p->next < end; p->next += period) {
+        p->step = (p->step + 1) & 7;
+        apu_output(apu, (ApuChannel)(APU_PULSE1 + index), duty[p->step] ? volume : 0, p->next);
+    }
+}
+
+static void apu_run_triangle(APU* apu, u64 end) {
+    ApuTriangle* t = &apu->triangle;
+    u64 period = (u64)t->period + 1;
+    // A halted sequencer holds its level. Periods below 2 are ultrasonic; holding the level
+    // there avoids the pop real hardware makes.
+    if (!t->length || !t->linear || t->period < 2) {
+        timer_skip(&t->next, end, period);
+        return;
+    }
+    for (; t->next < end; t->next += period) {
+        t->step = (t->step + 1) & 31;
+        apu_output(apu, APU_TRIANGLE, triangle_table[t->step], t->next);
+    }
+}
+
+static inline void noise_clock(ApuNoise* n) {
+    u16 feedback = (n->lfsr ^ (n->lfsr >> (n->mode ? 6 : 1))) & 1;
+    n->lfsr = (u16)((n->lfsr >> 1) | (feedback << 14));
+}
+
+static void apu_run_noise(APU* apu, u64 end) {
+    ApuNoise* n = &apu->noise;
+    u64 period = n->period;
+    if (!noise_audible(n)) {
+        // The shift register keeps running; only its phase is lost, which is inaudible.
+        u64 clocks = timer_skip(&n->next, end, period);
+        for (u64 i = 0; i < clocks && i < 64; ++i) { noise_clock(n); }
+        return;
+    }
+    u8 volume = envelope_level(&n->envelope);
+    for (; n->next < end; n->next += period) {
+        noise_clock(n);
+        apu_output(apu, APU_NOISE, (n->lfsr & 1) ? 0 : volume, n->next);
+    }
+}
+
+// Reads the next sample byte into the empty buffer. The DMA halts the CPU for four cycles.
+static void apu_dmc_fetch(APU* apu, Bus* bus) {
+    ApuDmc* d = &apu->dmc;
+    if (d->buffer_full || !d->bytes_remaining) { return; }
+    d->buffer = bus_read(bus, d->address);
+    d->buffer_full = 1;
+    d->address = d->address == 0xFFFF ? 0x8000 : (u16)(d->address + 1);
+    if (--d->bytes_remaining == 0) {
+        if (d->loop) {
+            d->address = d->sample_address;
+            d->bytes_remaining = d->sample_length;
+        } else if (d->irq_enabled) {
+            d->irq = 1;
+            cpu_set_irq(bus->cpu, IRQ_DMC, true);
+        }
+    }
+    bus->cpu->cycles += 4;
+}
+
+static void apu_run_dmc(APU* apu, Bus* bus, u64 end) {
+    ApuDmc* d = &apu->dmc;
+    for (; d->next < end; d->next += d->rate) {
+        if (!d->silence) {
+            if (d->shift & 1) { if (d->output <= 125) { d->output += 2; } }
+            else if (d->output >= 2) { d->output -= 2; }
+            d->shift >>= 1;
+            apu_output(apu, APU_DMC, d->output, d->next);
+        }
+        if (--d->bits_remaining == 0) {
+            d->bits_remaining = 8;
+            d->silence = !d->buffer_full;
+            d->shift = d->buffer;
+            d->buffer_full = 0;
+            apu_dmc_fetch(apu, bus);
+        }
+    }
+}
+
+// --- Frame Sequencer ---
+static void envelope_clock(ApuEnvelope* env, bool loop) {
+    if (env->start) {
+        env->start = 0;
+        env->decay = 15;
+        env->divider = env->volume;
+    } else if (env->divider) {
+        env->divider--;
+    } else {
+        env->divider = env->volume;
+        if (env->decay) { env->decay--; }
+        else if (loop) { env->decay = 15; }
+    }
+}
+
+static void apu_quarter_frame(APU* apu) {
+    envelope_clock(&apu->pulse[0].envelope, apu->pulse[0].halt);
+    envelope_clock(&apu->pulse[1].envelope, apu->pulse[1].halt);
+    envelope_clock(&apu->noise.envelope, apu->noise.halt);
+    ApuTriangle* t = &apu->triangle;
+    if (t->linear_reload) { t->linear = t->linear_period; }
+    else if (t->linear) { t->linear--; }
+    if (!t->control) { t->linear_reload = 0; }
+}
+
+static void apu_half_frame(APU* apu) {
+    for (int i = 0; i < 2; ++i) {
+        ApuPulse* p = &apu->pulse[i];
+        if (p->length && !p->halt) { p->length--; }
+        if (!p->sweep_divider && p->sweep_enabled && p->sweep_shift && !pulse_muted(p, i)) {
+            p->period = pulse_sweep_target(p, i);
+        }
+        if (!p->sweep_divider || p->sweep_reload) {
+            p->sweep_divider = p->sweep_period;
+            p->sweep_reload = 0;
+        } else {
+            p->sweep_divider--;
+        }
+    }
+    if (apu->triangle.length && !apu->triangle.control) { apu->triangle.length--; }
+    if (apu->noise.length && !apu->noise.halt) { apu->noise.length--; }
+}
+
+static inline u64 apu_frame_next(const APU* apu) { return apu->frame_start + frame_steps[apu->frame_step]; }
+
+static void apu_clock_frame(APU* apu, Bus* bus) {
+    u64 cycle = apu_frame_next(apu);
+    switch (apu->frame_step) {
+        case 0: case 2: apu_quarter_frame(apu); break;
+        case 1: apu_quarter_frame(apu); apu_half_frame(apu); break;
+        case 3:
+            if (apu->five_step) { break; }
+            apu_quarter_frame(apu);
+            apu_half_frame(apu);
+            if (!apu->irq_inhibit) {
+                apu->frame_irq = 1;
+                cpu_set_irq(bus->cpu, IRQ_APU_FRAME, true);
+            }
+            break;
+        case 4: apu_quarter_frame(apu); apu_half_frame(apu); break;
+    }
+    apu_update_levels(apu, cycle);
+    if (++apu->frame_step == (apu->five_step ? 5 : 4)) {
+        apu->frame_step = 0;
+        apu->frame_start += apu->five_step ? APU_FRAME_PERIOD_5 : APU_FRAME_PERIOD_4;
+    }
+}
+
+// --- Scheduling ---
+// Events only make sure the APU is caught up in time: the frame IRQ and every DMC fetch
+// (which stalls the CPU and may raise the DMC IRQ) then happen on their exact cycle.
+static void apu_schedule(APU* apu, Bus* bus) {
+    if (!apu->five_step && !apu->irq_inhibit && !apu->frame_irq) {
+        scheduler_schedule(bus->sched, EVENT_APU_FRAME_IRQ, apu->frame_start + frame_steps[3]);
+    } else {
+        scheduler_cancel(bus->sched, EVENT_APU_FRAME_IRQ);
+    }
+    const ApuDmc* d = &apu->dmc;
+    if (d->bytes_remaining) {
+        // The buffer is refilled by the bit clock that starts the next output byte.
+        u64 fetch = d->next + (u64)(d->bits_remaining - 1) * d->rate;
+        scheduler_schedule(bus->sched, EVENT_APU_DMC, fetch + 1);
+    } else {
+        scheduler_cancel(bus->sched, EVENT_APU_DMC);
+    }
+}
+
+void apu_catch_up(APU* apu, Bus* bus, u64 cycle) {
+    if (cycle <= apu->cycle) { return; }
+    while (apu->cycle < cycle) {
+        u64 step = apu_frame_next(apu);
+        u64 end = step < cycle ? step : cycle;
+        apu_run_pulse(apu, 0, end);
+        apu_run_pulse(apu, 1, end);
+        apu_run_triangle(apu, end);
+        apu_run_noise(apu, end);
+        apu_run_dmc(apu, bus, end);
+        apu->cycle = end;
+        if (end == step) { apu_clock_frame(apu, bus); }
+        // Long unobserved stretches (front ends that never end a frame) are split into batches.
+        if (apu_synth_pending(&apu->synth, end) > APU_SYNTH_SPAN / 2) { apu_synth_end(&apu->synth, end); }
+    }
+    apu_schedule(apu, bus);
+}
+
+// --- Initialization ---
+void apu_init(APU* apu) {
+    memset(apu, 0, sizeof(APU));
+    apu_synth_init(&apu->synth, 0);
+}
+
+void apu_reset(APU* apu, Bus* bus) {
+    u64 cycle = bus->cpu->cycles;
+    memset(&apu->pulse, 0, sizeof(APU) - offsetof(APU, pulse));
+    apu->pulse[0].next = apu->pulse[1].next = cycle + 2;
+    apu->triangle.next = cycle + 1;
+    apu->noise.period = noise_periods[0];
+    apu->noise.lfsr = 1;
+    apu->noise.next = cycle + apu->noise.period;
+    apu->dmc.rate = dmc_rates[0];
+    apu->dmc.bits_remaining = 8;
+    apu->dmc.silence = 1;
+    apu->dmc.next = cycle + apu->dmc.rate;
+    apu->frame_start = cycle;
+    apu->cycle = cycle;
+    apu_synth_init(&apu->synth, cycle);
+    apu_schedule(apu, bus);
+}
+
+void apu_set_muted(APU* apu, bool muted) { apu->synth.muted = muted; }
+
+void apu_sync(APU* apu) {
+    apu_synth_end(&apu->synth, apu->synth.base);
+    apu->synth.base = apu->cycle;
+    apu_update_levels(apu, apu->cycle);
+}
+
+// --- CPU-facing Registers ---
+u8 apu_read_status(APU* apu, Bus* bus) {
+    apu_catch_up(apu, bus, bus->cpu->cycles);
+    u8 status = (apu->pulse[0].length ? 0x01 : 0) | (apu->pulse[1].length ? 0x02 : 0) |
+                (apu->triangle.length ? 0x04 : 0) | (apu->noise.length ? 0x08 : 0) |
+                (apu->dmc.bytes_remaining ? 0x10 : 0) | (apu->frame_irq ? 0x40 : 0) | (apu->dmc.irq ? 0x80 : 0);
+    if (apu->frame_irq) {
+        apu->frame_irq = 0;
+        cpu_set_irq(bus->cpu, IRQ_APU_FRAME, false);
+        apu_schedule(apu, bus);
+    }
+    return status;
+}
+
+static void envelope_write(ApuEnvelope* env, u8 data) {
+    env->constant = (data >> 4) & 1;
+    env->volume = data & 0x0F;
+}
+
+void apu_write(APU* apu, Bus* bus, u16 address, u8 data) {
+    u64 cycle = bus->cpu->cycles;
+    apu_catch_up(apu, bus, cycle);
+    switch (address) {
+        case 0x4000: case 0x4004: {
+            ApuPulse* p = &apu->pulse[(address >> 2) & 1];
+            p->duty = data >> 6;
+            p->halt = (data >> 5) & 1;
+            envelope_write(&p->envelope, data);
+            break;
+        }
+        case 0x4001: case 0x4005: {
+            ApuPulse* p = &apu->pulse[(address >> 2) & 1];
+            p->sweep_enabled = data >> 7;
+            p->sweep_period = (data >> 4) & 7;
+            p->sweep_negate = (data >> 3) & 1;
+            p->sweep_shift = data & 7;
+            p->sweep_reload = 1;
+            break;
+        }
+        case 0x4002: case 0x4006: {
+            ApuPulse* p = &apu->pulse[(address >> 2) & 1];
+            p->period = (p->period & 0x700) | data;
+            break;
+        }
+        case 0x4003: case 0x4007: {
+            int index = (address >> 2) & 1;
+            ApuPulse* p = &apu->pulse[index];
+            p->period = (u16)((p->period & 0xFF) | ((data & 7) << 8));
+            if (apu->enabled & (1 << index)) { p->length = length_table[data >> 3]; }
+            p->step = 0;
+            p->envelope.start = 1;
+            break;
+        }
+        case 0x4008:
+            apu->triangle.control = data >> 7;
+            apu->triangle.linear_period = data & 0x7F;
+            break;
+        case 0x400A: apu->triangle.period = (apu->triangle.period & 0x700) | data; break;
+        case 0x400B:
+            apu->triangle.period = (u16)((apu->triangle.period & 0xFF) | ((data & 7) << 8));
+            if (apu->enabled & 0x04) { apu->triangle.length = length_table[data >> 3]; }
+            apu->triangle.linear_reload = 1;
+            break;
+        case 0x400C:
+            apu->noise.halt = (data >> 5) & 1;
+            envelope_write(&apu->noise.envelope, data);
+            break;
+        case 0x400E:
+            apu->noise.mode = data >> 7;
+            apu->noise.period = noise_periods[data & 0x0F];
+            break;
+        case 0x400F:
+            if (apu->enabled & 0x08) { apu->noise.length = length_table[data >> 3]; }
+            apu->noise.envelope.start = 1;
+            break;
+        case 0x4010:
+            apu->dmc.irq_enabled = data >> 7;
+            apu->dmc.loop = (data >> 6) & 1;
+            apu->dmc.rate = dmc_rates[data & 0x0F];
+            if (!apu->dmc.irq_enabled && apu->dmc.irq) {
+                apu->dmc.irq = 0;
+                cpu_set_irq(bus->cpu, IRQ_DMC, false);
+            }
+            break;
+        case 0x4011: apu->dmc.output = data & 0x7F; break;
+        case 0x4012: apu->dmc.sample_address = (u16)(0xC000 | (data << 6)); break;
+        case 0x4013: apu->dmc.sample_length = (u16)((data << 4) + 1); break;
+        case 0x4015:
+            apu->enabled = data & 0x0F;
+            if (!(data & 0x01)) { apu->pulse[0].length = 0; }
+            if (!(data & 0x02)) { apu->pulse[1].length = 0; }
+            if (!(data & 0x04)) { apu->triangle.length = 0; }
+            if (!(data & 0x08)) { apu->noise.length = 0; }
+            if (!(data & 0x10)) {
+                apu->dmc.bytes_remaining = 0;
+            } else if (!apu->dmc.bytes_remaining) {
+                apu->dmc.address = apu->dmc.sample_address;
+                apu->dmc.bytes_remaining = apu->dmc.sample_length;
+                apu_dmc_fetch(apu, bus);
+            }
+            apu->dmc.irq = 0;
+            cpu_set_irq(bus->cpu, IRQ_DMC, false);
+            break;
+        case 0x4017:
+            apu->five_step = data >> 7;
+            apu->irq_inhibit = (data >> 6) & 1;
+            if (apu->irq_inhibit && apu->frame_irq) {
+                apu->frame_irq = 0;
+                cpu_set_irq(bus->cpu, IRQ_APU_FRAME, false);
+            }
+            apu->frame_start = cycle;
+            apu->frame_step = 0;
+            // The 5-step mode clocks the quarter and half frame units right away.
+            if (apu->five_step) {
+                apu_quarter_frame(apu);
+                apu_half_frame(apu);
+            }
+            break;
+    }
+    apu_update_levels(apu, cycle);
+    apu_schedule(apu, bus);
+}
+
+// --- Output ---
+void apu_end_frame(APU* apu, Bus* bus) {
+    apu_catch_up(apu, bus, bus->cpu->cycles);
+    apu_synth_end(&apu->synth, apu->cycle);
+}
+
+u32 apu_read_samples(APU* apu, s16* out, u32 max) {
+    ApuSynth* synth = &apu->synth;
+    u32 count = synth->sample_count < max ? synth->sample_count : max;
+    memcpy(out, synth->samples, count * sizeof(s16));
+    memmove(synth->samples, &synth->samples[count], (synth->sample_count - count) * sizeof(s16));
+    synth->sample_count -= count;
+    return count;
+}
+
+const s16* apu_drain_samples(APU* apu, u32* count) {
+    *count = apu->synth.sample_count;
+    apu->synth.sample_count = 0;
+    return apu->synth.samples;
+}
\ No newline at end of file
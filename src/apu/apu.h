@@ -0,0 +1,158 @@
+#ifndef MYNES_C_APU_H
+#define MYNES_C_APU_H
+
+#include "common/types.h"
+
+// Forward declare Bus. APU functions will receive it as a parameter.
+typedef struct Bus Bus;
+
+// --- Output ---
+// Mono signed 16-bit samples at APU_SAMPLE_RATE. They collect in the APU until the front end
+// drains them with apu_read_samples(); whatever does not fit is dropped.
+#define APU_CPU_CLOCK 1789773 // NTSC: 21.477272 MHz master clock / 12
+#define APU_SAMPLE_RATE 48000
+#define APU_SAMPLE_BUFFER 8192 // About 10 frames
+
+// --- Band-limited Synthesis ---
+// Channels are not sampled. Every change of a channel's level is added to the output as a
+// band-limited step (a windowed-sinc kernel, picked from APU_SYNTH_PHASES sub-sample
+// positions) at its exact position on the 48 kHz timeline, and the steps are summed into
+// samples when a batch is finished. That band-limits and resamples in one pass, and its cost
+// follows the number of level changes rather than the CPU clock.
+#define APU_SYNTH_PHASES 32
+#define APU_SYNTH_TAPS 16
+#define APU_SYNTH_SPAN 2048 // Samples a batch may cover before it is finished early
+
+typedef enum { APU_PULSE1, APU_PULSE2, APU_TRIANGLE, APU_NOISE, APU_DMC, APU_CHANNEL_COUNT } ApuChannel;
+
+typedef struct ApuSynth {
+    float kernel[APU_SYNTH_PHASES][APU_SYNTH_TAPS]; // Step derivative per phase; taps sum to 1
+    u64 factor;     // Output samples per CPU cycle, 32.32 fixed point
+    u64 base;       // CPU cycle at which the current batch starts
+    u64 frac;       // Sample position of 'base' within accum[0], 0.32 fixed point
+    float accum[APU_SYNTH_SPAN + APU_SYNTH_TAPS]; // Pending step contributions
+    float integrator;
+    float hp_in, hp_out; // DC-blocking high-pass filter state
+    u8 levels[APU_CHANNEL_COUNT]; // Level each channel last contributed
+    bool muted;     // Nothing is added or finished; the output stays where it was
+
+    s16 samples[APU_SAMPLE_BUFFER];
+    u32 sample_count;
+    u64 dropped;    // Samples discarded because the buffer was full
+} ApuSynth;
+
+// --- Channels ---
+typedef struct ApuEnvelope {
+    u8 volume;      // Constant volume, or the divider period
+    u8 constant;
+    u8 start;
+    u8 divider;
+    u8 decay;
+} ApuEnvelope;
+
+typedef struct ApuPulse {
+    ApuEnvelope envelope;
+    u8 duty, step;
+    u8 length, halt; // Halt also loops the envelope
+    u8 sweep_enabled, sweep_period, sweep_negate, sweep_shift, sweep_reload, sweep_divider;
+    u16 period;      // 11-bit timer period
+    u64 next;        // CPU cycle of the next sequencer step
+} ApuPulse;
+
+typedef struct ApuTriangle {
+    u8 length, control; // Control halts the length counter and keeps reloading the linear one
+    u8 linear, linear_period, linear_reload;
+    u8 step;
+    u16 period;
+    u64 next;
+} ApuTriangle;
+
+typedef struct ApuNoise {
+    ApuEnvelope envelope;
+    u8 length, halt;
+    u8 mode;         // Short (93-step) sequence
+    u16 period;      // In CPU cycles
+    u16 lfsr;
+    u64 next;
+} ApuNoise;
+
+typedef struct ApuDmc {
+    u8 irq_enabled, loop, irq;
+    u8 output;       // 7-bit level
+    u16 rate;        // CPU cycles per output bit
+    u16 sample_address;
+    u16 sample_length;
+    u16 address;     // Next byte to fetch
+    u16 bytes_remaining;
+    u8 buffer, buffer_full;
+    u8 shift, bits_remaining, silence;
+    u64 next;        // CPU cycle of the next output bit
+} ApuDmc;
+
+typedef struct APU {
+    ApuSynth synth; // Host-side output; not part of the machine state
+
+    // --- Machine State ---
+    // Everything from here on is plain fixed-width data, saved as raw bytes (see savestate.h).
+    ApuPulse pulse[2];
+    ApuTriangle triangle;
+    ApuNoise noise;
+    ApuDmc dmc;
+    u8 enabled;       // $4015 bits 0-3: channels whose length counters may load
+    u8 five_step;     // Frame sequencer mode ($4017 bit 7)
+    u8 irq_inhibit;   // $4017 bit 6
+    u8 frame_irq;
+    u8 frame_step;    // Next step of the frame sequencer
+    u64 frame_start;  // CPU cycle at which the current sequence started
+
+    // --- Catch-up Timing ---
+    // Like the PPU, the APU is advanced in bulk by apu_catch_up() when it is observed.
+    u64 cycle;
+} APU;
+
+// --- Function Prototypes ---
+void apu_init(APU* apu);
+// Silences every channel and restarts the frame sequencer at the CPU's current cycle.
+void apu_reset(APU* apu, Bus* bus);
+
+// $4000-$4013, $4015 and $4017. Both catch the APU up first.
+u8 apu_read_status(APU* apu, Bus* bus);
+void apu_write(APU* apu, Bus* bus, u16 address, u8 data);
+
+/**
+ * @brief Advances the APU to CPU cycle 'cycle'.
+ * Runs each channel on its own between frame sequencer steps, so the cost depends on how
+ * often the channels change level rather than on the number of cycles.
+ */
+void apu_catch_up(APU* apu, Bus* bus, u64 cycle);
+
+// Catches up to the CPU and turns everything synthesised so far into samples. Called once
+// per frame.
+void apu_end_frame(APU* apu, Bus* bus);
+
+// Copies up to 'max' finished samples into 'out' and removes them. Returns the number copied.
+u32 apu_read_samples(APU* apu, s16* out, u32 max);
+// Removes every finished sample without copying: returns where they are and sets '*count'.
+// They stay there until the APU next produces samples.
+const s16* apu_drain_samples(APU* apu, u32* count);
+
+// Re-derives the host-side timing after the machine state was restored wholesale.
+void apu_sync(APU* apu);
+
+// While muted the channels run as usual but nothing reaches the output, not even their level
+// changes. Meant for frames that are run and then rolled back with a save state (run-ahead):
+// unmute before restoring, and the output carries on as if they never happened.
+void apu_set_muted(APU* apu, bool muted);
+
+// --- Synthesis (apu_synth.c) ---
+void apu_synth_init(ApuSynth* synth, u64 cycle);
+// Adds a step of 'delta' (full scale is about 1.0) at CPU cycle 'cycle' (>= synth->base).
+void apu_synth_add(ApuSynth* synth, u64 cycle, float delta);
+// Finishes every sample that lies before 'cycle' and starts the next batch there.
+void apu_synth_end(ApuSynth* synth, u64 cycle);
+// Samples the current batch would cover if it ended at 'cycle'.
+static inline u32 apu_synth_pending(const ApuSynth* synth, u64 cycle) {
+    return (u32)((synth->frac + (cycle - synth->base) * synth->factor) >> 32);
+}
+
+#endif // MYNES_C_APU_H
\ No newline at end of file
@@ -0,0 +1,78 @@
+// The Golden Rule: Include your own header first.
+#include "apu/apu.h"
+
+#include <math.h>
+#include <string.h>
+
+#define APU_SYNTH_PHASE_BITS 5 // log2(APU_SYNTH_PHASES)
+#define APU_SYNTH_CUTOFF 0.9   // Kernel bandwidth, as a fraction of the output Nyquist rate
+#define APU_SYNTH_HIGHPASS 0.996f // One-pole DC blocker, about 30 Hz at 48 kHz
+#define APU_SYNTH_GAIN 32000.0f
+
+// Builds the kernel: a Blackman-windowed sinc, sampled at every tap for each sub-sample
+// phase. Summing (integrating) it over the taps turns a delta into a band-limited step that
+// settles APU_SYNTH_TAPS / 2 samples after its position.
+static void apu_synth_build_kernel(ApuSynth* synth) {
+    const double pi = 3.14159265358979323846;
+    const double half = APU_SYNTH_TAPS / 2;
+    for (int phase = 0; phase < APU_SYNTH_PHASES; ++phase) {
+        double sum = 0.0;
+        double taps[APU_SYNTH_TAPS];
+        for (int k = 0; k < APU_SYNTH_TAPS; ++k) {
+            double x = (k - half + 1) - (double)phase / APU_SYNTH_PHASES;
+            double arg = pi * APU_SYNTH_CUTOFF * x;
+            double sinc = x == 0.0 ? 1.0 : sin(arg) / arg;
+            double window = 0.42 + 0.5 * cos(pi * x / half) + 0.08 * cos(2.0 * pi * x / half);
+            taps[k] = sinc * window;
+            sum += taps[k];
+        }
+        // Every phase must add exactly 'delta' in total, or steps would leave DC behind.
+        for (int k = 0; k < APU_SYNTH_TAPS; ++k) { synth->kernel[phase][k] = (float)(taps[k] / sum); }
+    }
+}
+
+void apu_synth_init(ApuSynth* synth, u64 cycle) {
+    memset(synth, 0, sizeof(ApuSynth));
+    apu_synth_build_kernel(synth);
+    synth->factor = (u64)((double)APU_SAMPLE_RATE / APU_CPU_CLOCK * 4294967296.0 + 0.5);
+    synth->base = cycle;
+}
+
+void apu_synth_add(ApuSynth* synth, u64 cycle, float delta) {
+    u64 pos = synth->frac + (cycle - synth->base) * synth->factor;
+    u32 index = (u32)(pos >> 32);
+    const float* kernel = synth->kernel[(pos >> (32 - APU_SYNTH_PHASE_BITS)) & (APU_SYNTH_PHASES - 1)];
+    float* out = &synth->accum[index];
+    for (int k = 0; k < APU_SYNTH_TAPS; ++k) { out[k] += delta * kernel[k]; }
+}
+
+void apu_synth_end(ApuSynth* synth, u64 cycle) {
+    if (synth->muted) { return; }
+    u64 pos = synth->frac + (cycle - synth->base) * synth->factor;
+    u32 count = (u32)(pos >> 32);
+    float level = synth->integrator;
+    float hp_in = synth->hp_in;
+    float hp_out = synth->hp_out;
+    for (u32 i = 0; i < count; ++i) {
+        level += synth->accum[i];
+        hp_out = level - hp_in + APU_SYNTH_HIGHPASS * hp_out;
+        hp_in = level;
+        if (synth->sample_count == APU_SAMPLE_BUFFER) {
+            synth->dropped++;
+            continue;
+        }
+        float sample = hp_out * APU_SYNTH_GAIN;
+        if (sample > 32767.0f) { sample = 32767.0f; }
+        if (sample < -32768.0f) { sample = -32768.0f; }
+        synth->samples[synth->sample_count++] = (s16)sample;
+    }
+    synth->integrator = level;
+    synth->hp_in = hp_in;
+    synth->hp_out = hp_out;
+
+    // Steps near the end of the batch spill into the next one.
+    memmove(synth->accum, &synth->accum[count], APU_SYNTH_TAPS * sizeof(float));
+    memset(&synth->accum[APU_SYNTH_TAPS], 0, count * sizeof(float));
+    synth->frac = pos & 0xFFFFFFFFu;
+    synth->base = cycle;
+}
\ No newline at end of file
@@ -3,44 +3,152 @@
 
 #include <string.h>
 // The bus needs the full definitions to call component functions.
+#include "apu/apu.h"
 #include "cartridge/cartridge.h"
+#include "controller/controller.h"
 #include "cpu/cpu.h"
+#include "mapper/mapper.h"
 #include "ppu/ppu.h"
+#include "scheduler/scheduler.h"
 
 void bus_init(Bus* bus) {
     memset(bus->ram, 0, RAM_SIZE);
+    memset(bus->read_pages, 0, sizeof(bus->read_pages));
+    memset(bus->write_pages, 0, sizeof(bus->write_pages));
+    memset(bus->code_pages, 0, sizeof(bus->code_pages));
+    memset(bus->code_writes, 0, sizeof(bus->code_writes));
     bus->cart = NULL;
+    bus->mapper = NULL;
     bus->cpu = NULL;
     bus->ppu = NULL;
+    bus->apu = NULL;
+    bus->sched = NULL;
+    bus->oam_dma_page = 0;
+
+    // $0000-$1FFF: 2 KB of internal RAM, mirrored four times.
+    for (u32 mirror = 0; mirror < 0x2000; mirror += RAM_SIZE) {
+        bus_map_pages(bus, (u16)mirror, RAM_SIZE, bus->ram, true);
+    }
+}
+
+// --- Code Write Tracking ---
+// Restores direct writes to every alias of a tracked host page and drops its blocks.
+static void bus_untrack_code(Bus* bus, const u8* host) {
+    for (u32 i = 0; i < BUS_PAGE_COUNT; ++i) {
+        if (bus->code_pages[i] == host) {
+            bus->write_pages[i] = bus->code_pages[i];
+            bus->code_pages[i] = NULL;
+        }
+    }
+#if CPU_BLOCK_CACHE
+    if (bus->cpu) { cpu_invalidate_blocks(bus->cpu, host); }
+#endif
+}
+
+void bus_track_code_page(Bus* bus, u32 page) {
+    u8* host = bus->write_pages[page];
+    if (!host) { return; } // ROM, or already tracked
+    // RAM is mirrored, so every page that writes the same memory must be parked.
+    for (u32 i = 0; i < BUS_PAGE_COUNT; ++i) {
+        if (bus->write_pages[i] == host) {
+            bus->code_pages[i] = host;
+            bus->write_pages[i] = NULL;
+        }
+    }
+}
+
+void bus_flush_code(Bus* bus) {
+    for (u32 i = 0; i < BUS_PAGE_COUNT; ++i) {
+        if (bus->code_pages[i]) {
+            bus->write_pages[i] = bus->code_pages[i];
+            bus->code_pages[i] = NULL;
+        }
+    }
+    memset(bus->code_writes, 0, sizeof(bus->code_writes));
+#if CPU_BLOCK_CACHE
+    if (bus->cpu) { cpu_invalidate_blocks(bus->cpu, NULL); }
+#endif
+}
+
+void bus_map_pages(Bus* bus, u16 address, u32 size, u8* memory, bool writable) {
+    u32 first = address >> BUS_PAGE_SHIFT;
+    u32 count = size >> BUS_PAGE_SHIFT;
+    for (u32 i = 0; i < count && first + i < BUS_PAGE_COUNT; ++i) {
+        u8* page = memory ? memory + (i << BUS_PAGE_SHIFT) : NULL;
+        // Remapping a tracked page (or adding a writable alias of one) must not leave
+        // decoded code behind that writes could silently change.
+        if (bus->code_pages[first + i]) { bus_untrack_code(bus, bus->code_pages[first + i]); }
+        if (writable && page) {
+            for (u32 j = 0; j < BUS_PAGE_COUNT; ++j) {
+                if (bus->code_pages[j] == page) { bus_untrack_code(bus, page); break; }
+            }
+        }
+        bus->read_pages[first + i] = page;
+        bus->write_pages[first + i] = writable ? page : NULL;
+    }
 }
 
 void bus_connect_cartridge(Bus* bus, Cartridge* cart) { bus->cart = cart; }
+void bus_connect_mapper(Bus* bus, Mapper* mapper) { bus->mapper = mapper; }
 void bus_connect_cpu(Bus* bus, CPU* cpu) { bus->cpu = cpu; }
 void bus_connect_ppu(Bus* bus, PPU* ppu) { bus->ppu = ppu; }
+void bus_connect_apu(Bus* bus, APU* apu) { bus->apu = apu; }
+void bus_connect_controllers(Bus* bus, Controller* pads) { bus->pads = pads; }
+void bus_connect_scheduler(Bus* bus, Scheduler* sched) { bus->sched = sched; }
 
-u8 bus_read(Bus* bus, u16 address) {
-    if (address <= 0x1FFF) {
-        return bus->ram[address & 0x07FF];
-    }
+u8 bus_read_io(Bus* bus, u16 address) {
     if (address >= 0x2000 && address <= 0x3FFF) {
-        return ppu_read(bus->ppu, address);
+        return ppu_read(bus->ppu, bus, address);
     }
-    if (address >= 0x8000) {
-        if (bus->cart) {
-            u16 mapped_addr = (address - 0x8000);
-            if (bus->cart->prg_rom_len == 16384) {
-                mapped_addr %= 16384;
-            }
-            return bus->cart->prg_rom[mapped_addr];
-        }
+    if (address == 0x4015) { return apu_read_status(bus->apu, bus); }
+    if ((address == 0x4016 || address == 0x4017) && bus->pads) {
+        // Only bit 0 is driven; the rest is open bus, which still holds the $40 of the address.
+        return 0x40 | controller_read(&bus->pads[address & 1]);
     }
     return 0;
 }
 
-void bus_write(Bus* bus, u16 address, u8 data) {
-    if (address <= 0x1FFF) {
-        bus->ram[address & 0x07FF] = data;
-    } else if (address >= 0x2000 && address <= 0x3FFF) {
-        ppu_write(bus->ppu, address, data);
+void bus_write_io(Bus* bus, u16 address, u8 data) {
+#if CPU_BLOCK_CACHE
+    // Any slow-path write may remap banks or rewrite code: end the running block.
+    if (bus->cpu) { bus->cpu->block_cache.exit = true; }
+#endif
+    u8* code = bus->code_pages[address >> BUS_PAGE_SHIFT];
+    if (code) {
+        u32 page = address >> BUS_PAGE_SHIFT;
+        if (bus->code_writes[page] < BUS_CODE_WRITE_LIMIT) { bus->code_writes[page]++; }
+        bus_untrack_code(bus, code);
+        code[address & (BUS_PAGE_SIZE - 1)] = data;
+        return;
+    }
+    if (address >= 0x2000 && address <= 0x3FFF) {
+        ppu_write(bus->ppu, bus, address, data);
+    } else if (address == 0x4014) {
+        // The transfer starts once the writing instruction has finished.
+        bus->oam_dma_page = data;
+        scheduler_schedule(bus->sched, EVENT_OAM_DMA, bus->cpu->cycles);
+    } else if (address == 0x4016) {
+        if (bus->pads) {
+            controller_write(&bus->pads[0], data);
+            controller_write(&bus->pads[1], data);
+        }
+    } else if ((address >= 0x4000 && address <= 0x4013) || address == 0x4015 || address == 0x4017) {
+        apu_write(bus->apu, bus, address, data);
+    } else if (address >= 0x8000 && bus->mapper) {
+        // Bank, mirroring and IRQ counter changes take effect from this cycle on: the PPU
+        // must have drawn (and clocked A12 for) everything before it with the old setup.
+        ppu_catch_up(bus->ppu, bus, bus->cpu->cycles);
+        mapper_write(bus->mapper, address, data);
+    }
+}
+
+void bus_oam_dma(Bus* bus) {
+    // Lines already due must be drawn (sprite 0 hit and overflow included) with the old OAM.
+    ppu_catch_up(bus->ppu, bus, bus->cpu->cycles);
+    u16 base = (u16)bus->oam_dma_page << 8;
+    for (u16 i = 0; i < 256; ++i) {
+        bus->ppu->oam[(u8)(bus->ppu->oamaddr + i)] = bus_read(bus, base + i);
     }
+    // 513 cycles, plus one alignment cycle when the DMA starts on an odd CPU cycle.
+    bus->cpu->cycles += 513 + (bus->cpu->cycles & 1);
 }
\ No newline at end of file
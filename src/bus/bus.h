@@ -2,27 +2,93 @@
 #define MYNES_C_BUS_H
 
 #include "common/types.h"
+#include "profile/profile.h"
 
 // Forward declare all components that connect to the bus
 typedef struct Cartridge Cartridge;
+typedef struct APU APU;
+typedef struct Controller Controller;
 typedef struct CPU CPU;
 typedef struct PPU PPU;
+typedef struct Scheduler Scheduler;
+typedef struct Mapper Mapper;
 
 #define RAM_SIZE 2048
 
+// --- Page Table ---
+// The CPU address space is split into 256 pages of 256 bytes. Each page either points
+// straight at the host memory backing it (RAM mirrors, PRG banks) or is NULL, in which
+// case the access falls back to the I/O handlers ($2000-$3FFF, $4000-$401F, open bus).
+#define BUS_PAGE_SHIFT 8
+#define BUS_PAGE_SIZE (1 << BUS_PAGE_SHIFT)
+#define BUS_PAGE_COUNT (0x10000 >> BUS_PAGE_SHIFT)
+
 typedef struct Bus {
     u8 ram[RAM_SIZE];
+    u8* read_pages[BUS_PAGE_COUNT];
+    u8* write_pages[BUS_PAGE_COUNT];
+    // RAM pages holding decoded CPU code. Their write_pages entry is parked here (and set to
+    // NULL) so the first write takes the slow path, which drops the stale blocks.
+    u8* code_pages[BUS_PAGE_COUNT];
+    u8 code_writes[BUS_PAGE_COUNT]; // Saturating count of such writes; busy pages stop being cached
     Cartridge* cart;
+    Mapper* mapper;
     CPU* cpu;
     PPU* ppu;
+    APU* apu;
+    Controller* pads; // Ports 1 and 2
+    Scheduler* sched;
+    u8 oam_dma_page; // Source page latched by the last $4014 write
 } Bus;
 
 // --- Function Prototypes ---
 void bus_init(Bus* bus);
 void bus_connect_cartridge(Bus* bus, Cartridge* cart);
+// PRG banks are mapped by the mapper itself on mapper_reset() and on every bank switch.
+void bus_connect_mapper(Bus* bus, Mapper* mapper);
 void bus_connect_cpu(Bus* bus, CPU* cpu);
 void bus_connect_ppu(Bus* bus, PPU* ppu);
-u8 bus_read(Bus* bus, u16 address);
-void bus_write(Bus* bus, u16 address, u8 data);
+void bus_connect_apu(Bus* bus, APU* apu);
+void bus_connect_controllers(Bus* bus, Controller* pads); // An array of two
+void bus_connect_scheduler(Bus* bus, Scheduler* sched);
+
+/**
+ * @brief Points the pages covering [address, address + size) at host memory.
+ * The mapping is resolved once here, so later accesses are a single indexed load.
+ * @param memory Host memory backing the range, or NULL to route it to the I/O handlers.
+ * @param writable Whether CPU writes go straight to memory (RAM) or to the handlers (ROM).
+ */
+void bus_map_pages(Bus* bus, u16 address, u32 size, u8* memory, bool writable);
+
+// --- Code Write Tracking ---
+#define BUS_CODE_WRITE_LIMIT 16
+
+// Called when CPU code is decoded from 'page': if the page is RAM, its writes are tracked.
+void bus_track_code_page(Bus* bus, u32 page);
+// Whether code on 'page' may be cached (pages rewritten too often are interpreted).
+static inline bool bus_code_cacheable(const Bus* bus, u32 page) { return bus->code_writes[page] < BUS_CODE_WRITE_LIMIT; }
+// Stops all tracking and drops every decoded block, e.g. after RAM was restored wholesale.
+void bus_flush_code(Bus* bus);
+
+// Slow paths for pages without a direct mapping.
+u8 bus_read_io(Bus* bus, u16 address);
+void bus_write_io(Bus* bus, u16 address, u8 data);
+
+// Performs the OAM DMA latched by $4014: copies one page into OAM and stalls the CPU.
+void bus_oam_dma(Bus* bus);
+
+static inline u8 bus_read(Bus* bus, u16 address) {
+    PROFILE_READ(address);
+    const u8* page = bus->read_pages[address >> BUS_PAGE_SHIFT];
+    if (page) { return page[address & (BUS_PAGE_SIZE - 1)]; }
+    return bus_read_io(bus, address);
+}
+
+static inline void bus_write(Bus* bus, u16 address, u8 data) {
+    PROFILE_WRITE(address);
+    u8* page = bus->write_pages[address >> BUS_PAGE_SHIFT];
+    if (page) { page[address & (BUS_PAGE_SIZE - 1)] = data; return; }
+    bus_write_io(bus, address, data);
+}
 
 #endif // MYNES_C_BUS_H
\ No newline at end of file
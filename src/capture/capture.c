@@ -0,0 +1,387 @@
+// The Golden Rule: Include your own header first.
+#include "capture/capture.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef _WIN32
+#include <io.h>
+#endif
+#include "apu/apu.h"
+#include "common/hash.h"
+#include "ppu/ppu.h"
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+#define CAPTURE_PIXELS (PPU_SCREEN_WIDTH * PPU_SCREEN_HEIGHT)
+#define CAPTURE_FILE_BUFFER (1u << 20)
+#define CAPTURE_WAV_HEADER_SIZE 44
+// A slot keeps collecting sound while its pictures are dropped, as long as another frame's
+// worth (800 samples) still fits; after that the emulation thread waits instead.
+#define CAPTURE_AUDIO_HEADROOM 1024
+// NTSC frame rate as an exact fraction: 236.25 MHz / 11 / 4 / 89341.5 dots.
+#define CAPTURE_FPS_NUM 39375000
+#define CAPTURE_FPS_DEN 655171
+
+// --- Output Files ---
+// Plain file descriptors with their own buffer rather than stdio, so stdout can be taken
+// over by descriptor without POSIX stdio extensions.
+typedef struct CaptureFile {
+    int fd;             // -1 when unused
+    u8* buffer;
+    u32 used;
+    bool failed;
+    u64 bytes;          // Bytes accepted, buffered or not
+} CaptureFile;
+
+static bool capture_file_open(CaptureFile* file, const char* path) {
+    memset(file, 0, sizeof(CaptureFile));
+    file->fd = -1;
+    if (strcmp(path, "-") == 0) {
+        // Keep the real stdout for the stream and point descriptor 1 at stderr, so stray
+        // messages cannot end up inside it.
+        fflush(stdout);
+        file->fd = dup(STDOUT_FILENO);
+        if (file->fd >= 0) { dup2(STDERR_FILENO, STDOUT_FILENO); }
+#ifdef _WIN32
+        if (file->fd >= 0) { _setmode(file->fd, _O_BINARY); }
+#endif
+    } else {
+        file->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0644);
+    }
+    if (file->fd < 0) {
+        perror(path);
+        return false;
+    }
+    file->buffer = (u8*)malloc(CAPTURE_FILE_BUFFER);
+    if (!file->buffer) {
+        fprintf(stderr, "Failed to allocate the capture buffer.\n");
+        close(file->fd);
+        file->fd = -1;
+        return false;
+    }
+    return true;
+}
+
+static void capture_file_flush(CaptureFile* file) {
+    for (u32 done = 0; done < file->used && !file->failed;) {
+        ssize_t n = write(file->fd, file->buffer + done, file->used - done);
+        if (n > 0) { done += (u32)n; }
+        else if (n < 0 && errno == EINTR) { continue; }
+        else {
+            perror("Capture write failed");
+            file->failed = true;
+        }
+    }
+    file->used = 0;
+}
+
+static void capture_file_write(CaptureFile* file, const void* data, size_t size) {
+    const u8* bytes = (const u8*)data;
+    file->bytes += size;
+    while (size && !file->failed) {
+        u32 n = CAPTURE_FILE_BUFFER - file->used;
+        if (n > size) { n = (u32)size; }
+        memcpy(file->buffer + file->used, bytes, n);
+        file->used += n;
+        bytes += n;
+        size -= n;
+        if (file->used == CAPTURE_FILE_BUFFER) { capture_file_flush(file); }
+    }
+}
+
+// Flushes and closes. Returns false if anything failed to write.
+static bool capture_file_close(CaptureFile* file) {
+    if (file->fd < 0) { return true; }
+    capture_file_flush(file);
+    if (close(file->fd) != 0) { file->failed = true; }
+    free(file->buffer);
+    file->fd = -1;
+    return !file->failed;
+}
+
+// --- WAV ---
+static void put_le16(u8* p, u32 v) { p[0] = (u8)v; p[1] = (u8)(v >> 8); }
+static void put_le32(u8* p, u32 v) { put_le16(p, v); put_le16(p + 2, v >> 16); }
+
+// Mono 16-bit PCM at APU_SAMPLE_RATE. A stream that cannot seek back keeps the 'unknown'
+// sizes written up front, which players and encoders accept.
+static void wav_header(u8 header[CAPTURE_WAV_HEADER_SIZE], u64 data_bytes) {
+    u32 data = data_bytes > 0xFFFFFFFFu - 36 ? 0xFFFFFFFFu - 36 : (u32)data_bytes;
+    memcpy(header, "RIFF", 4);
+    put_le32(header + 4, 36 + data);
+    memcpy(header + 8, "WAVEfmt ", 8);
+    put_le32(header + 16, 16);
+    put_le16(header + 20, 1);                     // PCM
+    put_le16(header + 22, 1);                     // Mono
+    put_le32(header + 24, APU_SAMPLE_RATE);
+    put_le32(header + 28, APU_SAMPLE_RATE * 2);   // Bytes per second
+    put_le16(header + 32, 2);                     // Bytes per sample frame
+    put_le16(header + 34, 16);
+    memcpy(header + 36, "data", 4);
+    put_le32(header + 40, data);
+}
+
+// --- Queue ---
+typedef struct CaptureSlot {
+    u32 pixels[CAPTURE_PIXELS];
+    s16 samples[APU_SAMPLE_BUFFER];
+    u32 sample_count;
+    u64 frame;          // Number of the frame in 'pixels'
+} CaptureSlot;
+
+struct Capture {
+    CaptureOptions options;
+    CaptureFile video;
+    CaptureFile audio;
+
+    // Slots [tail, head) are queued for the writer; slot 'head' is being drawn into. All
+    // counters are guarded by 'lock'.
+    CaptureSlot* slots;
+    u32 slot_count;
+    u64 head;
+    u64 tail;
+    bool closing;
+    pthread_mutex_t lock;
+    pthread_cond_t queued;   // Signalled when a slot is queued or on close
+    pthread_cond_t freed;    // Signalled when the writer finishes a slot
+    pthread_t writer;
+    CaptureStats stats;
+
+    u8* scratch;             // Writer-owned conversion buffer
+};
+
+static double capture_now(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// --- Writer Thread ---
+// BT.601 limited range, chroma from the average of each 2x2 block.
+static void capture_convert_yuv420(const u32* pixels, u8* out) {
+    u8* y_plane = out;
+    u8* u_plane = out + CAPTURE_PIXELS;
+    u8* v_plane = u_plane + CAPTURE_PIXELS / 4;
+    for (u32 i = 0; i < CAPTURE_PIXELS; ++i) {
+        u32 p = pixels[i];
+        int r = (p >> 16) & 0xFF, g = (p >> 8) & 0xFF, b = p & 0xFF;
+        y_plane[i] = (u8)(16 + ((66 * r + 129 * g + 25 * b + 128) >> 8));
+    }
+    for (u32 y = 0; y < PPU_SCREEN_HEIGHT; y += 2) {
+        for (u32 x = 0; x < PPU_SCREEN_WIDTH; x += 2) {
+            const u32* row = &pixels[y * PPU_SCREEN_WIDTH + x];
+            u32 quad[4] = { row[0], row[1], row[PPU_SCREEN_WIDTH], row[PPU_SCREEN_WIDTH + 1] };
+            int r = 0, g = 0, b = 0;
+            for (int k = 0; k < 4; ++k) {
+                r += (quad[k] >> 16) & 0xFF;
+                g += (quad[k] >> 8) & 0xFF;
+                b += quad[k] & 0xFF;
+            }
+            r = (r + 2) >> 2; g = (g + 2) >> 2; b = (b + 2) >> 2;
+            u32 c = (y / 2) * (PPU_SCREEN_WIDTH / 2) + x / 2;
+            u_plane[c] = (u8)(128 + ((-38 * r - 74 * g + 112 * b + 128) >> 8));
+            v_plane[c] = (u8)(128 + ((112 * r - 94 * g - 18 * b + 128) >> 8));
+        }
+    }
+}
+
+static void capture_write_slot(Capture* capture, const CaptureSlot* slot) {
+    CaptureFile* video = &capture->video;
+    u8* scratch = capture->scratch;
+    switch (video->fd >= 0 ? capture->options.video_format : CAPTURE_VIDEO_NONE) {
+        case CAPTURE_VIDEO_Y4M:
+            capture_file_write(video, "FRAME\n", 6);
+            capture_convert_yuv420(slot->pixels, scratch);
+            capture_file_write(video, scratch, CAPTURE_PIXELS * 3 / 2);
+            break;
+        case CAPTURE_VIDEO_RGB:
+            for (u32 i = 0; i < CAPTURE_PIXELS; ++i) {
+                scratch[i * 3 + 0] = (u8)(slot->pixels[i] >> 16);
+                scratch[i * 3 + 1] = (u8)(slot->pixels[i] >> 8);
+                scratch[i * 3 + 2] = (u8)slot->pixels[i];
+            }
+            capture_file_write(video, scratch, CAPTURE_PIXELS * 3);
+            break;
+        case CAPTURE_VIDEO_HASH: {
+            char line[48];
+            int n = snprintf(line, sizeof(line), "%llu %016llx\n", (unsigned long long)slot->frame,
+                             (unsigned long long)fnv1a64(slot->pixels, sizeof(slot->pixels)));
+            capture_file_write(video, line, (size_t)n);
+            break;
+        }
+        default: break;
+    }
+    if (capture->audio.fd >= 0) {
+        for (u32 i = 0; i < slot->sample_count; ++i) { put_le16(scratch + i * 2, (u16)slot->samples[i]); }
+        capture_file_write(&capture->audio, scratch, slot->sample_count * 2);
+    }
+}
+
+static void* capture_writer(void* arg) {
+    Capture* capture = (Capture*)arg;
+    pthread_mutex_lock(&capture->lock);
+    for (;;) {
+        while (capture->tail == capture->head && !capture->closing) { pthread_cond_wait(&capture->queued, &capture->lock); }
+        if (capture->tail == capture->head) { break; }
+        CaptureSlot* slot = &capture->slots[capture->tail % capture->slot_count];
+        pthread_mutex_unlock(&capture->lock);
+
+        capture_write_slot(capture, slot);
+
+        pthread_mutex_lock(&capture->lock);
+        capture->stats.frames_written++;
+        capture->stats.samples_written += slot->sample_count;
+        capture->stats.bytes_written = capture->video.bytes + capture->audio.bytes;
+        capture->stats.failed = capture->video.failed || capture->audio.failed;
+        capture->tail++;
+        pthread_cond_signal(&capture->freed);
+    }
+    pthread_mutex_unlock(&capture->lock);
+    return NULL;
+}
+
+// --- Emulation Side ---
+Capture* capture_open(const CaptureOptions* options) {
+    if (options->video_path && options->audio_path && strcmp(options->video_path, "-") == 0 &&
+        strcmp(options->audio_path, "-") == 0) {
+        fprintf(stderr, "Video and audio cannot both go to stdout.\n");
+        return NULL;
+    }
+    Capture* capture = (Capture*)calloc(1, sizeof(Capture));
+    if (!capture) { return NULL; }
+    capture->options = *options;
+    capture->video.fd = -1;
+    capture->audio.fd = -1;
+    capture->slot_count = options->queue_frames ? options->queue_frames : CAPTURE_DEFAULT_QUEUE;
+    if (capture->slot_count < 2) { capture->slot_count = 2; }
+    capture->slots = (CaptureSlot*)calloc(capture->slot_count, sizeof(CaptureSlot));
+    capture->scratch = (u8*)malloc(CAPTURE_PIXELS * 3);
+    bool ok = capture->slots && capture->scratch;
+    if (!ok) { fprintf(stderr, "Failed to allocate the capture queue.\n"); }
+
+    if (ok && options->video_path && options->video_format != CAPTURE_VIDEO_NONE) {
+        ok = capture_file_open(&capture->video, options->video_path);
+        if (ok && options->video_format == CAPTURE_VIDEO_Y4M) {
+            char header[96];
+            int n = snprintf(header, sizeof(header), "YUV4MPEG2 W%d H%d F%d:%d Ip A1:1 C420jpeg\n",
+                             PPU_SCREEN_WIDTH, PPU_SCREEN_HEIGHT, CAPTURE_FPS_NUM, CAPTURE_FPS_DEN);
+            capture_file_write(&capture->video, header, (size_t)n);
+        }
+    }
+    if (ok && options->audio_path) {
+        ok = capture_file_open(&capture->audio, options->audio_path);
+        u8 header[CAPTURE_WAV_HEADER_SIZE];
+        wav_header(header, 0xFFFFFFFFu);
+        if (ok) { capture_file_write(&capture->audio, header, sizeof(header)); }
+    }
+    if (ok) {
+        pthread_mutex_init(&capture->lock, NULL);
+        pthread_cond_init(&capture->queued, NULL);
+        pthread_cond_init(&capture->freed, NULL);
+        ok = pthread_create(&capture->writer, NULL, capture_writer, capture) == 0;
+        if (!ok) {
+            fprintf(stderr, "Failed to start the capture writer.\n");
+            pthread_cond_destroy(&capture->freed);
+            pthread_cond_destroy(&capture->queued);
+            pthread_mutex_destroy(&capture->lock);
+        }
+    }
+    if (!ok) {
+        capture_file_close(&capture->video);
+        capture_file_close(&capture->audio);
+        free(capture->scratch);
+        free(capture->slots);
+        free(capture);
+        return NULL;
+    }
+    return capture;
+}
+
+u32* capture_framebuffer(Capture* capture) { return capture->slots[capture->head % capture->slot_count].pixels; }
+
+u32* capture_frame(Capture* capture, const s16* samples, u32 count) {
+    CaptureSlot* slot = &capture->slots[capture->head % capture->slot_count];
+    // A slot whose picture was dropped still carries the audio of that frame.
+    u32 room = APU_SAMPLE_BUFFER - slot->sample_count;
+    u32 kept = count < room ? count : room;
+    memcpy(&slot->samples[slot->sample_count], samples, kept * sizeof(s16));
+    slot->sample_count += kept;
+
+    pthread_mutex_lock(&capture->lock);
+    slot->frame = capture->stats.frames++;
+    capture->stats.samples_dropped += count - kept;
+    // Queueing this slot must leave one free to draw the next frame into.
+    if (capture->head + 1 - capture->tail >= capture->slot_count) {
+        if (capture->options.drop_when_full && APU_SAMPLE_BUFFER - slot->sample_count >= CAPTURE_AUDIO_HEADROOM) {
+            capture->stats.frames_dropped++;
+            pthread_mutex_unlock(&capture->lock);
+            return slot->pixels;
+        }
+        double start = capture_now();
+        capture->stats.stalls++;
+        while (capture->head + 1 - capture->tail >= capture->slot_count) { pthread_cond_wait(&capture->freed, &capture->lock); }
+        capture->stats.stall_seconds += capture_now() - start;
+    }
+    capture->head++;
+    u32 queued = (u32)(capture->head - capture->tail);
+    if (queued > capture->stats.max_queued) { capture->stats.max_queued = queued; }
+    pthread_cond_signal(&capture->queued);
+    pthread_mutex_unlock(&capture->lock);
+
+    CaptureSlot* next = &capture->slots[capture->head % capture->slot_count];
+    next->sample_count = 0;
+    return next->pixels;
+}
+
+void capture_stats(Capture* capture, CaptureStats* stats) {
+    pthread_mutex_lock(&capture->lock);
+    *stats = capture->stats;
+    pthread_mutex_unlock(&capture->lock);
+}
+
+bool capture_close(Capture* capture, CaptureStats* stats) {
+    pthread_mutex_lock(&capture->lock);
+    // A slot still holding sound had its last picture dropped: queue it after all, so the
+    // sound reaches the WAV. There is always room for it, as nothing is drawn after it.
+    if (capture->slots[capture->head % capture->slot_count].sample_count) {
+        capture->head++;
+        capture->stats.frames_dropped--;
+    }
+    capture->closing = true;
+    pthread_cond_signal(&capture->queued);
+    pthread_mutex_unlock(&capture->lock);
+    pthread_join(capture->writer, NULL);
+
+    // Now that the length is known, fill in the WAV sizes if the file can seek back.
+    CaptureFile* audio = &capture->audio;
+    if (audio->fd >= 0) {
+        capture_file_flush(audio);
+        u8 header[CAPTURE_WAV_HEADER_SIZE];
+        wav_header(header, audio->bytes - CAPTURE_WAV_HEADER_SIZE);
+        if (!audio->failed && lseek(audio->fd, 0, SEEK_SET) == 0) {
+            capture_file_write(audio, header, sizeof(header));
+            audio->bytes -= sizeof(header); // Rewritten, not added
+        }
+    }
+    bool ok = capture_file_close(&capture->video);
+    ok = capture_file_close(audio) && ok;
+
+    capture->stats.bytes_written = capture->video.bytes + capture->audio.bytes;
+    capture->stats.failed = !ok;
+    if (stats) { *stats = capture->stats; }
+    pthread_cond_destroy(&capture->freed);
+    pthread_cond_destroy(&capture->queued);
+    pthread_mutex_destroy(&capture->lock);
+    free(capture->scratch);
+    free(capture->slots);
+    free(capture);
+    return ok;
+}
\ No newline at end of file
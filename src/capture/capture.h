@@ -0,0 +1,74 @@
+#ifndef MYNES_C_CAPTURE_H
+#define MYNES_C_CAPTURE_H
+
+#include "common/types.h"
+
+// --- Frame and Audio Capture ---
+// Streams every frame of a headless run to disk (or a pipe) without the emulation thread ever
+// touching the disk. The PPU draws straight into a slot of a bounded queue; capture_frame()
+// hands the slot, with the frame's audio, to a writer thread and returns the next free slot
+// to draw into, so pixels are never copied on the emulation side. The writer converts and
+// writes them: YUV 4:2:0 (Y4M) or RGB24, or just one hash per frame, plus a WAV of the sound.
+//
+// When the writer falls behind and the queue is full, the emulation thread either waits for
+// it (backpressure, the default: nothing is lost) or drops the picture and keeps going. The
+// sound of dropped frames is kept, so the WAV stays continuous; after about ten dropped
+// pictures in a row the slot's sound buffer is full and the thread waits after all. Both
+// stalls and drops are counted.
+//
+// A path of "-" means stdout. stdout is then the capture's alone: from capture_open() on,
+// anything else the process prints there is sent to stderr instead.
+typedef enum {
+    CAPTURE_VIDEO_NONE,
+    CAPTURE_VIDEO_Y4M,   // YUV4MPEG2, 4:2:0, BT.601 limited range, at the NTSC frame rate
+    CAPTURE_VIDEO_RGB,   // Raw RGB24 frames, no header
+    CAPTURE_VIDEO_HASH,  // One text line per frame: frame number and FNV-1a 64 of its ARGB pixels
+} CaptureVideoFormat;
+
+#define CAPTURE_DEFAULT_QUEUE 16 // Frames; each slot takes about 260 KB
+
+typedef struct CaptureOptions {
+    const char* video_path;  // NULL for none
+    CaptureVideoFormat video_format;
+    const char* audio_path;  // WAV, NULL for none
+    u32 queue_frames;        // Queue slots, at least 2 (0 for CAPTURE_DEFAULT_QUEUE)
+    bool drop_when_full;     // Drop pictures instead of waiting for the writer
+} CaptureOptions;
+
+typedef struct CaptureStats {
+    u64 frames;          // Frames handed to capture_frame()
+    u64 frames_written;
+    u64 frames_dropped;  // Pictures dropped on a full queue
+    u64 samples_written;
+    u64 samples_dropped; // Audio that did not fit a slot (more than APU_SAMPLE_BUFFER at once)
+    u64 stalls;          // Times the emulation thread waited for the writer
+    double stall_seconds;
+    u32 max_queued;      // Deepest the queue got
+    u64 bytes_written;
+    bool failed;         // A write failed; the rest of the capture was discarded
+} CaptureStats;
+
+typedef struct Capture Capture;
+
+// --- Function Prototypes ---
+
+// Opens the outputs and starts the writer. Returns NULL (with a message on stderr) on failure.
+Capture* capture_open(const CaptureOptions* options);
+
+// The buffer to draw the first frame into (PPU_SCREEN_WIDTH x PPU_SCREEN_HEIGHT ARGB pixels).
+u32* capture_framebuffer(Capture* capture);
+
+/**
+ * @brief Queues the frame just drawn into the current buffer and the audio that came with it.
+ * @return The buffer to draw the next frame into (point the PPU at it).
+ */
+u32* capture_frame(Capture* capture, const s16* samples, u32 count);
+
+// A snapshot of the counters, safe to take while capturing.
+void capture_stats(Capture* capture, CaptureStats* stats);
+
+// Writes out everything queued, finishes the files and stops the writer. Fills 'stats' if
+// not NULL. Returns false if anything failed to write.
+bool capture_close(Capture* capture, CaptureStats* stats);
+
+#endif // MYNES_C_CAPTURE_H
\ No newline at end of file
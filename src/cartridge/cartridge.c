@@ -1,89 +1,292 @@
 #include "cartridge/cartridge.h"
-#include <stdlib.h> // For malloc, free
+#include <stdlib.h> // For malloc, calloc, free
 #include <string.h> // For memcmp
 
-bool cartridge_load(Cartridge* cart, const char* path) {
-    FILE* file = fopen(path, "rb"); // Open in binary read mode
-    if (!file) {
-        perror("Failed to open ROM file");
-        return false;
+// --- CHR Tile Cache ---
+// Expands one tile's two bitplanes into 64 pixel bytes, row by row.
+static void chr_decode_tile(const u8* src, u8* dst) {
+    for (int row = 0; row < 8; ++row) {
+        u8 lo = src[row];
+        u8 hi = src[row + 8];
+        for (int x = 0; x < 8; ++x) {
+            int bit = 7 - x;
+            *dst++ = (u8)(((lo >> bit) & 1) | (((hi >> bit) & 1) << 1));
+        }
     }
+}
 
-    // Read the header
-    iNESHeader header;
-    if (fread(&header, sizeof(iNESHeader), 1, file) != 1) {
-        fprintf(stderr, "Failed to read iNES header.\n");
-        fclose(file);
-        return false;
+static u8* chr_decode_all(const u8* chr, u32 len) {
+    u32 tiles = len / CHR_TILE_BYTES;
+    u8* decoded = (u8*)malloc((size_t)tiles * CHR_DECODED_TILE_BYTES);
+    if (!decoded) { return NULL; }
+    for (u32 tile = 0; tile < tiles; ++tile) {
+        chr_decode_tile(&chr[tile * CHR_TILE_BYTES], &decoded[tile * CHR_DECODED_TILE_BYTES]);
     }
+    return decoded;
+}
 
-    // Verify the magic number
-    const char magic[4] = {'N', 'E', 'S', 0x1A};
-    if (memcmp(header.magic, magic, 4) != 0) {
-        fprintf(stderr, "Invalid .nes file: incorrect magic number.\n");
-        fclose(file);
-        return false;
-    }
+static void cartridge_decode_tile(Cartridge* cart, u32 tile) {
+    chr_decode_tile(&cart->chr_rom[tile * CHR_TILE_BYTES], &cart->chr_tiles[tile * CHR_DECODED_TILE_BYTES]);
+}
 
-    // Calculate ROM sizes
-    cart->prg_rom_len = header.prg_rom_size * 16384; // 16 * 1024
-    cart->chr_rom_len = header.chr_rom_size * 8192;  // 8 * 1024
+void cartridge_write_chr(Cartridge* cart, u32 offset, u8 data) {
+    if (!cart->chr_is_ram || cart->chr_rom[offset] == data) { return; }
+    cart->chr_rom[offset] = data;
+    u32 tile = offset / CHR_TILE_BYTES;
+    cart->chr_dirty[tile / 64] |= 1ULL << (tile % 64);
+    cart->chr_any_dirty = true;
+}
 
-    // Extract mapper ID
-    cart->mapper_id = (header.flags7 & 0xF0) | (header.flags6 >> 4);
+void cartridge_invalidate_chr(Cartridge* cart) {
+    if (!cart->chr_is_ram) { return; }
+    u32 tiles = cart->chr_rom_len / CHR_TILE_BYTES;
+    memset(cart->chr_dirty, 0xFF, (tiles + 63) / 64 * sizeof(u64));
+    cart->chr_any_dirty = true;
+}
 
-    printf("Cartridge Loaded:\n");
-    printf("  PRG ROM size: %u KB\n", cart->prg_rom_len / 1024);
-    printf("  CHR ROM size: %u KB\n", cart->chr_rom_len / 1024);
-    printf("  Mapper ID: %u\n", cart->mapper_id);
+void cartridge_load_chr_ram(Cartridge* cart, const u8* data) {
+    if (!cart->chr_is_ram) { return; }
+    u32 tiles = cart->chr_rom_len / CHR_TILE_BYTES;
+    for (u32 tile = 0; tile < tiles; ++tile) {
+        u8* bytes = &cart->chr_rom[tile * CHR_TILE_BYTES];
+        const u8* from = &data[tile * CHR_TILE_BYTES];
+        if (memcmp(bytes, from, CHR_TILE_BYTES) == 0) { continue; }
+        memcpy(bytes, from, CHR_TILE_BYTES);
+        cart->chr_dirty[tile / 64] |= 1ULL << (tile % 64);
+        cart->chr_any_dirty = true;
+    }
+}
 
-    // Allocate memory for ROM data
-    cart->prg_rom = (u8*)malloc(cart->prg_rom_len);
-    if (!cart->prg_rom) {
-        fprintf(stderr, "Failed to allocate memory for PRG ROM.\n");
-        fclose(file);
-        return false;
+void cartridge_refresh_chr(Cartridge* cart) {
+    if (!cart->chr_any_dirty) { return; }
+    u32 words = (cart->chr_rom_len / CHR_TILE_BYTES + 63) / 64;
+    for (u32 w = 0; w < words; ++w) {
+        u64 bits = cart->chr_dirty[w];
+        for (u32 bit = 0; bits; ++bit, bits >>= 1) {
+            if (bits & 1) { cartridge_decode_tile(cart, w * 64 + bit); }
+        }
+        cart->chr_dirty[w] = 0;
     }
+    cart->chr_any_dirty = false;
+}
 
-    // Load PRG ROM
-    if (fread(cart->prg_rom, cart->prg_rom_len, 1, file) != 1) {
-        fprintf(stderr, "Failed to read PRG ROM data.\n");
-        free(cart->prg_rom);
-        fclose(file);
-        return false;
+// --- Header Parsing ---
+// NES 2.0 ROM sizes: a 12-bit count of units, or, when the high nibble is $F, 2^E * (2M + 1)
+// bytes with the exponent and multiplier packed into the low byte. Returns false for sizes of
+// 4 GB and up, which no file can hold.
+static bool nes2_rom_size(u8 lsb, u8 msb_nibble, u32 unit, u64* size) {
+    if (msb_nibble != 0x0F) {
+        *size = (u64)((msb_nibble << 8) | lsb) * unit;
+        return true;
     }
+    if ((lsb >> 2) >= 32) { return false; }
+    *size = ((u64)1 << (lsb >> 2)) * (u64)((lsb & 3) * 2 + 1);
+    return true;
+}
 
-    // Load CHR ROM if it exists
-    if (cart->chr_rom_len > 0) {
-        cart->chr_rom = (u8*)malloc(cart->chr_rom_len);
-        if (!cart->chr_rom) {
-            fprintf(stderr, "Failed to allocate memory for CHR ROM.\n");
-            free(cart->prg_rom);
-            fclose(file);
-            return false;
-        }
-        if (fread(cart->chr_rom, cart->chr_rom_len, 1, file) != 1) {
-            fprintf(stderr, "Failed to read CHR ROM data.\n");
-            free(cart->prg_rom);
-            free(cart->chr_rom);
-            fclose(file);
+static u32 nes2_ram_size(u8 shift) { return shift ? 64u << shift : 0; }
+
+bool rom_parse_header(const u8* data, size_t len, RomInfo* info) {
+    static const char magic[4] = {'N', 'E', 'S', 0x1A};
+    if (len < INES_HEADER_SIZE || memcmp(data, magic, 4) != 0) { return false; }
+    const iNESHeader* h = (const iNESHeader*)data;
+    memset(info, 0, sizeof(RomInfo));
+
+    // NES 2.0 is flagged by bits 2-3 of flags 7 == 2. Plain iNES leaves bytes 12-15 zero; if
+    // they are not, the tail was overwritten by an old ripper's signature and flags 7 is junk.
+    bool tail_clean = h->timing == 0 && h->system_type == 0 && h->misc_roms == 0 && h->expansion_device == 0;
+    if ((h->flags7 & 0x0C) == 0x08) { info->format = ROM_FORMAT_NES2; }
+    else if ((h->flags7 & 0x0C) == 0 && tail_clean) { info->format = ROM_FORMAT_INES; }
+    else { info->format = ROM_FORMAT_ARCHAIC; }
+
+    info->has_trainer = (h->flags6 & 0x04) != 0;
+    info->has_battery = (h->flags6 & 0x02) != 0;
+    // Flags 6: bit 0 selects vertical mirroring, bit 3 four-screen VRAM.
+    if (h->flags6 & 0x08) { info->mirroring = MIRROR_FOUR_SCREEN; }
+    else { info->mirroring = (h->flags6 & 0x01) ? MIRROR_VERTICAL : MIRROR_HORIZONTAL; }
+
+    u64 prg_len, chr_len;
+    if (info->format == ROM_FORMAT_NES2) {
+        info->mapper_id = (u16)(((h->mapper_msb & 0x0F) << 8) | (h->flags7 & 0xF0) | (h->flags6 >> 4));
+        info->submapper = h->mapper_msb >> 4;
+        if (!nes2_rom_size(h->prg_rom_size, h->rom_size_msb & 0x0F, 16384, &prg_len) ||
+            !nes2_rom_size(h->chr_rom_size, h->rom_size_msb >> 4, 8192, &chr_len)) {
             return false;
         }
+        info->prg_ram_len = nes2_ram_size(h->prg_ram_shift & 0x0F);
+        info->prg_nvram_len = nes2_ram_size(h->prg_ram_shift >> 4);
+        info->chr_ram_len = nes2_ram_size(h->chr_ram_shift & 0x0F);
+        info->chr_nvram_len = nes2_ram_size(h->chr_ram_shift >> 4);
+        info->timing = (RomTiming)(h->timing & 0x03);
+        info->console_type = h->flags7 & 0x03;
+        info->misc_roms = h->misc_roms & 0x03;
+        info->expansion_device = h->expansion_device & 0x3F;
     } else {
-        cart->chr_rom = NULL;
+        bool ines = info->format == ROM_FORMAT_INES;
+        info->mapper_id = ines ? (u16)((h->flags7 & 0xF0) | (h->flags6 >> 4)) : (u16)(h->flags6 >> 4);
+        info->console_type = ines ? (h->flags7 & 0x03) : 0;
+        info->timing = (ines && (h->rom_size_msb & 0x01)) ? ROM_TIMING_PAL : ROM_TIMING_NTSC;
+        prg_len = (u64)h->prg_rom_size * 16384;
+        chr_len = (u64)h->chr_rom_size * 8192;
+        // iNES 1.0 can barely describe RAM: byte 8 is the PRG RAM size in 8 KB units, where 0
+        // (like in archaic files) means the 8 KB nearly every board has.
+        u32 prg_ram = (ines && h->mapper_msb) ? h->mapper_msb * 8192u : 8192u;
+        if (info->has_battery) { info->prg_nvram_len = prg_ram; }
+        else { info->prg_ram_len = prg_ram; }
+        info->chr_ram_len = chr_len ? 0 : CHR_RAM_SIZE;
     }
 
-    fclose(file);
+    info->rom_offset = INES_HEADER_SIZE + (info->has_trainer ? INES_TRAINER_SIZE : 0);
+    if (len < info->rom_offset) { return false; }
+    u64 available = (u64)len - info->rom_offset;
+    if (prg_len == 0 || prg_len > available || chr_len > available - prg_len) { return false; }
+    info->prg_rom_len = (u32)prg_len;
+    info->chr_rom_len = (u32)chr_len;
     return true;
 }
 
-void cartridge_free(Cartridge* cart) {
-    if (cart->prg_rom) {
-        free(cart->prg_rom);
-        cart->prg_rom = NULL;
+const char* rom_format_name(RomFormat format) {
+    switch (format) {
+        case ROM_FORMAT_NES2: return "NES 2.0";
+        case ROM_FORMAT_INES: return "iNES";
+        default: return "iNES (archaic)";
+    }
+}
+
+// --- ROM Images ---
+static void rom_image_free(RomImage* image) {
+    free(image->chr_tiles);
+    file_map_close(&image->file);
+    free(image);
+}
+
+// Sets up an image around its file contents, which it then owns (even on failure).
+static RomImage* rom_image_open(RomImage* image, const char* name) {
+    // Read and validate the header
+    RomInfo* info = &image->info;
+    if (!rom_parse_header(image->file.data, image->file.size, info)) {
+        fprintf(stderr, "Invalid .nes file (bad header or truncated): %s\n", name);
+        rom_image_free(image);
+        return NULL;
     }
-    if (cart->chr_rom) {
+
+    // The ROM banks are used in place: the mapping is read-only, and the bus never maps
+    // PRG ROM pages as writable.
+    u8* rom = (u8*)image->file.data + info->rom_offset;
+    image->trainer = info->has_trainer ? image->file.data + INES_HEADER_SIZE : NULL;
+    image->prg_rom = rom;
+    image->prg_rom_len = info->prg_rom_len;
+    image->chr_rom = info->chr_rom_len ? rom + info->prg_rom_len : NULL;
+    image->chr_rom_len = info->chr_rom_len;
+    image->mapper_id = info->mapper_id;
+    image->mirroring = info->mirroring;
+
+    if (image->chr_rom_len > 0) {
+        image->chr_tiles = chr_decode_all(image->chr_rom, image->chr_rom_len);
+        if (!image->chr_tiles) {
+            fprintf(stderr, "Failed to allocate the CHR tile cache.\n");
+            rom_image_free(image);
+            return NULL;
+        }
+    }
+    atomic_init(&image->refs, 1);
+    return image;
+}
+
+RomImage* rom_image_load(const char* path) {
+    RomImage* image = (RomImage*)calloc(1, sizeof(RomImage));
+    if (!image) { return NULL; }
+    if (!file_map_open(&image->file, path)) {
+        free(image);
+        return NULL;
+    }
+    return rom_image_open(image, path);
+}
+
+RomImage* rom_image_load_memory(const u8* data, size_t size, const char* name) {
+    RomImage* image = (RomImage*)calloc(1, sizeof(RomImage));
+    if (!image) { return NULL; }
+    if (!file_map_copy(&image->file, data, size)) {
+        free(image);
+        return NULL;
+    }
+    return rom_image_open(image, name);
+}
+
+void rom_image_retain(RomImage* image) { atomic_fetch_add_explicit(&image->refs, 1, memory_order_relaxed); }
+
+void rom_image_release(RomImage* image) {
+    if (image && atomic_fetch_sub_explicit(&image->refs, 1, memory_order_acq_rel) == 1) { rom_image_free(image); }
+}
+
+// --- Cartridges ---
+// The RAM to give a board that declares 'declared' bytes: rounded up to a power of two, at
+// least 'min' and at most 'max'.
+static u32 cartridge_ram_size(const char* what, u32 declared, u32 min, u32 max) {
+    u32 size = min;
+    while (size < declared && size < max) { size <<= 1; }
+    if (declared > max) {
+        fprintf(stderr, "Warning: %u KB of %s is more than the board can use; using %u KB.\n", declared / 1024, what,
+                max / 1024);
+    }
+    return size;
+}
+
+bool cartridge_attach(Cartridge* cart, RomImage* image) {
+    memset(cart, 0, sizeof(Cartridge));
+    rom_image_retain(image); // Taken first: cartridge_free() on a failure path gives it back
+    cart->image = image;
+    cart->prg_rom = image->prg_rom;
+    cart->prg_rom_len = image->prg_rom_len;
+    cart->trainer = image->trainer;
+    cart->mapper_id = image->mapper_id;
+    cart->mirroring = image->mirroring;
+    const RomInfo* info = &image->info;
+    cart->prg_ram_len = cartridge_ram_size("PRG RAM", info->prg_ram_len + info->prg_nvram_len, PRG_RAM_SIZE, PRG_RAM_MAX_SIZE);
+
+    if (image->chr_rom_len > 0) {
+        cart->chr_rom = image->chr_rom;
+        cart->chr_rom_len = image->chr_rom_len;
+        cart->chr_tiles = image->chr_tiles;
+        cart->chr_is_ram = false;
+    } else {
+        // No CHR ROM: the board carries CHR RAM instead.
+        u32 size = cartridge_ram_size("CHR RAM", info->chr_ram_len + info->chr_nvram_len, CHR_RAM_SIZE, CHR_RAM_MAX_SIZE);
+        u32 tiles = size / CHR_TILE_BYTES;
+        cart->chr_rom = (u8*)calloc(1, size);
+        cart->chr_tiles = (u8*)calloc(tiles, CHR_DECODED_TILE_BYTES); // All-zero RAM decodes to zeros
+        cart->chr_dirty = (u64*)calloc((tiles + 63) / 64, sizeof(u64));
+        cart->chr_rom_len = size;
+        cart->chr_is_ram = true;
+        if (!cart->chr_rom || !cart->chr_tiles || !cart->chr_dirty) {
+            fprintf(stderr, "Failed to allocate memory for CHR RAM.\n");
+            cartridge_free(cart);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool cartridge_load(Cartridge* cart, const char* path) {
+    RomImage* image = rom_image_load(path);
+    if (!image) { return false; }
+    bool ok = cartridge_attach(cart, image);
+    rom_image_release(image); // The cartridge holds the only remaining reference
+    return ok;
+}
+
+void cartridge_free(Cartridge* cart) {
+    if (cart->chr_is_ram) {
         free(cart->chr_rom);
-        cart->chr_rom = NULL;
+        free(cart->chr_tiles);
+        free(cart->chr_dirty);
+    }
+    cart->chr_rom = NULL;
+    cart->chr_tiles = NULL;
+    cart->chr_dirty = NULL;
+    cart->prg_rom = NULL;
+    if (cart->image) {
+        rom_image_release(cart->image);
+        cart->image = NULL;
     }
 }
\ No newline at end of file
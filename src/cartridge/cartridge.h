@@ -2,42 +2,159 @@
 #define MYNES_C_CARTRIDGE_H
 
 #include "common/types.h"
+#include "common/file_map.h"
 #include <stdio.h>
+#include <stdatomic.h>
 
-// --- iNES File Header Structure ---
-// This struct directly maps to the 16-byte header of an iNES file.
+// --- iNES / NES 2.0 File Header Structure ---
+// This struct directly maps to the 16-byte header of an iNES file. Bytes 8-15 are the NES 2.0
+// extension; in iNES 1.0 files only bytes 8 (PRG RAM) and 9 (TV system) carry meaning.
 #pragma pack(push, 1) // Ensure no padding is added by the compiler
 typedef struct {
-    char magic[4];      // Should be "NES\x1A"
-    u8 prg_rom_size;    // Size of PRG ROM in 16 KB units
-    u8 chr_rom_size;    // Size of CHR ROM in 8 KB units (0 means CHR RAM)
-    u8 flags6;
-    u8 flags7;
-    u8 flags8_prg_ram;
-    u8 flags9;
-    u8 flags10;
-    u8 reserved[5];
+    char magic[4];        // Should be "NES\x1A"
+    u8 prg_rom_size;      // Size of PRG ROM in 16 KB units (NES 2.0: low byte)
+    u8 chr_rom_size;      // Size of CHR ROM in 8 KB units, 0 means CHR RAM (NES 2.0: low byte)
+    u8 flags6;            // Mapper low nibble, four-screen, trainer, battery, mirroring
+    u8 flags7;            // Mapper middle nibble, NES 2.0 signature (bits 2-3), console type
+    u8 mapper_msb;        // NES 2.0: submapper (high nibble), mapper bits 8-11 (low nibble)
+    u8 rom_size_msb;      // NES 2.0: CHR (high nibble) and PRG (low nibble) ROM size bits 8-11
+    u8 prg_ram_shift;     // NES 2.0: PRG NVRAM (high) and PRG RAM (low) as 64 << shift bytes
+    u8 chr_ram_shift;     // NES 2.0: CHR NVRAM (high) and CHR RAM (low) as 64 << shift bytes
+    u8 timing;            // NES 2.0: CPU/PPU timing (bits 0-1)
+    u8 system_type;       // NES 2.0: Vs. System type or extended console type
+    u8 misc_roms;         // NES 2.0: number of miscellaneous ROMs (bits 0-1)
+    u8 expansion_device;  // NES 2.0: default expansion device (bits 0-5)
 } iNESHeader;
 #pragma pack(pop)
 
+#define INES_HEADER_SIZE 16
+#define INES_TRAINER_SIZE 512
+
+// --- Nametable Mirroring ---
+typedef enum {
+    MIRROR_HORIZONTAL, MIRROR_VERTICAL, MIRROR_SINGLE_LOW, MIRROR_SINGLE_HIGH, MIRROR_FOUR_SCREEN,
+} Mirroring;
+
+// --- Parsed Header ---
+typedef enum {
+    ROM_FORMAT_INES,     // iNES 1.0
+    ROM_FORMAT_NES2,     // NES 2.0
+    ROM_FORMAT_ARCHAIC,  // iNES with garbage in bytes 7-15 (e.g. "DiskDude!"): only flags 6 is trusted
+} RomFormat;
+
+typedef enum { ROM_TIMING_NTSC, ROM_TIMING_PAL, ROM_TIMING_MULTI, ROM_TIMING_DENDY } RomTiming;
+
+typedef struct RomInfo {
+    RomFormat format;
+    u16 mapper_id;         // 12 bits in NES 2.0, 8 in iNES
+    u8 submapper;
+    Mirroring mirroring;
+    bool has_battery;
+    bool has_trainer;      // 512 bytes loaded at $7000, stored between header and PRG ROM
+    u32 prg_rom_len;
+    u32 chr_rom_len;
+    u32 prg_ram_len;       // Volatile PRG RAM at $6000 (iNES: assumed 8 KB)
+    u32 prg_nvram_len;     // Battery-backed PRG RAM
+    u32 chr_ram_len;
+    u32 chr_nvram_len;
+    RomTiming timing;
+    u8 console_type;       // 0 NES/Famicom, 1 Vs. System, 2 PlayChoice-10, 3 extended
+    u8 misc_roms;
+    u8 expansion_device;
+    u32 rom_offset;        // File offset of PRG ROM (after the header and trainer)
+} RomInfo;
+
+// Board RAM. A NES 2.0 header gives the sizes; iNES boards get the usual 8 KB of each. Larger
+// declarations are cut down to what the supported boards can address (SXROM: 32 KB of PRG
+// RAM), with a warning.
+#define CHR_RAM_SIZE 8192
+#define CHR_RAM_MAX_SIZE 0x8000
+#define PRG_RAM_SIZE 0x2000 // The $6000-$7FFF window; larger PRG RAM is banked into it
+#define PRG_RAM_MAX_SIZE 0x8000
+
+// --- Pre-decoded CHR ---
+// Each 16-byte 2-bitplane tile is expanded to 8 rows of 8 pixels, one byte (0-3) per pixel,
+// so the renderer can copy tile rows instead of shifting bitplanes.
+#define CHR_TILE_BYTES 16
+#define CHR_DECODED_TILE_BYTES 64
+
+// --- ROM Image ---
+// The immutable contents of a .nes file: PRG ROM, CHR ROM and its decoded tiles. The file is
+// memory-mapped and PRG/CHR point straight into the mapping (read-only pages: nothing is
+// copied, and untouched banks are never read from disk). Images are reference counted and
+// never written after loading, so any number of emulator instances on any number of threads
+// can share one.
+typedef struct RomImage {
+    FileMap file;
+    RomInfo info;
+    u8* prg_rom;             // Into 'file'; must not be written
+    u32 prg_rom_len;
+    u8* chr_rom;             // Into 'file'; NULL when the board has CHR RAM instead
+    u32 chr_rom_len;
+    const u8* trainer;       // Into 'file', or NULL
+    u8* chr_tiles;           // Decoded CHR ROM tiles
+    u16 mapper_id;
+    Mirroring mirroring;
+    _Atomic int refs;
+} RomImage;
+
 // --- Cartridge Structure ---
-// This holds the loaded game data.
-typedef struct {
-    u8* prg_rom; // Pointer to the start of PRG ROM data
+// One instance's view of a ROM image. PRG and CHR ROM point into the shared image; CHR RAM
+// and its decoded tiles belong to the instance.
+typedef struct Cartridge {
+    RomImage* image;
+
+    u8* prg_rom; // Pointer to the start of PRG ROM data (shared, read-only)
     u32 prg_rom_len;
 
-    u8* chr_rom; // Pointer to the start of CHR ROM data
+    u8* chr_rom; // Pointer to the start of CHR ROM data (or CHR RAM)
     u32 chr_rom_len;
+    bool chr_is_ram; // No CHR ROM in the image: chr_rom is chr_rom_len bytes of writable CHR RAM
+
+    u8* chr_tiles;      // chr_rom_len / 16 decoded tiles of CHR_DECODED_TILE_BYTES each
+    u64* chr_dirty;     // CHR RAM only: one bit per tile written since it was last decoded
+    bool chr_any_dirty;
 
-    u8 mapper_id;
-    // We will add more mapper-specific state here later.
+    const u8* trainer; // 512 bytes for $7000-$71FF, or NULL
+    u32 prg_ram_len;   // PRG RAM and NVRAM on the board: a power of two, at least the 8 KB window
+
+    u16 mapper_id;
+    Mirroring mirroring;
 } Cartridge;
 
 // --- Function Prototypes ---
 
+/**
+ * @brief Parses and validates an iNES / NES 2.0 header against the file it came from.
+ * @param data The file contents (at least the header).
+ * @param len The file size; the ROM sizes the header declares must fit in it.
+ * @return false if this is not a usable .nes file.
+ */
+bool rom_parse_header(const u8* data, size_t len, RomInfo* info);
+// "NES 2.0", "iNES" or "iNES (archaic)".
+const char* rom_format_name(RomFormat format);
+
+/**
+ * @brief Loads a .nes file into a new ROM image with one reference.
+ * @return The image, or NULL if the file could not be read.
+ */
+RomImage* rom_image_load(const char* path);
+// Same, from a .nes file already in memory. The image keeps its own copy of 'data'; 'name'
+// only appears in messages.
+RomImage* rom_image_load_memory(const u8* data, size_t size, const char* name);
+void rom_image_retain(RomImage* image);
+// Drops a reference; the image is freed with the last one.
+void rom_image_release(RomImage* image);
+
+/**
+ * @brief Attaches a cartridge to a shared image (taking a reference).
+ * Only CHR RAM, if the board has it, is allocated per cartridge.
+ */
+bool cartridge_attach(Cartridge* cart, RomImage* image);
+
 /**
  * @brief Loads a .nes file into the cartridge structure.
- * This function reads the header, allocates memory, and loads the ROM data.
+ * Shorthand for rom_image_load() + cartridge_attach() when nothing else shares the image.
  * @param cart A pointer to the Cartridge structure to fill.
  * @param path The file path to the .nes ROM file.
  * @return true if loading was successful, false otherwise.
@@ -45,7 +162,26 @@ typedef struct {
 bool cartridge_load(Cartridge* cart, const char* path);
 
 /**
- * @brief Frees the memory allocated for the cartridge's ROM data.
+ * @brief Writes a byte of CHR RAM and marks its tile for re-decoding.
+ * Writes are ignored when the cartridge has CHR ROM.
+ */
+void cartridge_write_chr(Cartridge* cart, u32 offset, u8 data);
+
+/**
+ * @brief Re-decodes every CHR RAM tile written since the last call.
+ * The renderer calls this before drawing a scanline; it is a no-op when nothing is dirty.
+ */
+void cartridge_refresh_chr(Cartridge* cart);
+
+// Marks every CHR tile for re-decoding, e.g. after CHR RAM was restored wholesale.
+void cartridge_invalidate_chr(Cartridge* cart);
+
+// Replaces the whole of CHR RAM (chr_rom_len bytes), marking only the tiles that changed.
+// Cheap when a state is restored over one it was captured from, as run-ahead does each frame.
+void cartridge_load_chr_ram(Cartridge* cart, const u8* data);
+
+/**
+ * @brief Frees the cartridge's own memory and releases its ROM image.
  * @param cart A pointer to the Cartridge structure.
  */
 void cartridge_free(Cartridge* cart);
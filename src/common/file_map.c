@@ -0,0 +1,122 @@
+// The Golden Rule: Include your own header first.
+#include "common/file_map.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Reads the whole file into the heap, for when it cannot be mapped.
+static bool file_map_read(FileMap* map, const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        perror(path);
+        return false;
+    }
+    u8* data = NULL;
+    size_t size = 0, capacity = 0;
+    for (;;) {
+        if (size == capacity) {
+            capacity = capacity ? capacity * 2 : 65536;
+            u8* grown = (u8*)realloc(data, capacity);
+            if (!grown) { break; }
+            data = grown;
+        }
+        size_t got = fread(data + size, 1, capacity - size, file);
+        size += got;
+        if (got == 0) { break; }
+    }
+    bool ok = !ferror(file) && size < capacity;
+    fclose(file);
+    if (!ok) {
+        fprintf(stderr, "Failed to read %s\n", path);
+        free(data);
+        return false;
+    }
+    map->data = data;
+    map->size = size;
+    map->mapped = false;
+    return true;
+}
+
+bool file_map_copy(FileMap* map, const void* data, size_t size) {
+    memset(map, 0, sizeof(FileMap));
+    u8* copy = (u8*)malloc(size ? size : 1);
+    if (!copy) {
+        fprintf(stderr, "Failed to allocate %zu bytes for a ROM image.\n", size);
+        return false;
+    }
+    memcpy(copy, data, size);
+    map->data = copy;
+    map->size = size;
+    map->mapped = false;
+    return true;
+}
+
+#ifdef _WIN32
+bool file_map_open(FileMap* map, const char* path) {
+    memset(map, 0, sizeof(FileMap));
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) { return file_map_read(map, path); }
+    LARGE_INTEGER size;
+    HANDLE mapping = NULL;
+    if (GetFileSizeEx(file, &size) && size.QuadPart > 0) { mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL); }
+    CloseHandle(file); // The mapping keeps the file open
+    const void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+    if (!view) {
+        if (mapping) { CloseHandle(mapping); }
+        return file_map_read(map, path);
+    }
+    map->data = (const u8*)view;
+    map->size = (size_t)size.QuadPart;
+    map->mapped = true;
+    map->handle = mapping;
+    return true;
+}
+
+void file_map_close(FileMap* map) {
+    if (map->mapped) {
+        UnmapViewOfFile(map->data);
+        CloseHandle(map->handle);
+    } else {
+        free((void*)map->data);
+    }
+    memset(map, 0, sizeof(FileMap));
+}
+#else
+bool file_map_open(FileMap* map, const char* path) {
+    memset(map, 0, sizeof(FileMap));
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror(path);
+        return false;
+    }
+    struct stat st;
+    void* view = MAP_FAILED;
+    // Empty files and non-regular files (pipes, devices) cannot be mapped.
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        view = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd); // The mapping keeps the file referenced
+    if (view == MAP_FAILED) { return file_map_read(map, path); }
+    map->data = (const u8*)view;
+    map->size = (size_t)st.st_size;
+    map->mapped = true;
+    return true;
+}
+
+void file_map_close(FileMap* map) {
+    if (map->mapped) { munmap((void*)map->data, map->size); }
+    else { free((void*)map->data); }
+    memset(map, 0, sizeof(FileMap));
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,26 @@
+#ifndef MYNES_C_FILE_MAP_H
+#define MYNES_C_FILE_MAP_H
+
+#include <stddef.h>
+#include "common/types.h"
+
+// --- Read-Only File Mapping ---
+// Maps a whole file into memory so its bytes can be used in place: nothing is copied, and
+// pages are only read from disk when touched (and are shared between processes through the
+// page cache). Falls back to reading into a heap buffer where a mapping is not possible.
+typedef struct FileMap {
+    const u8* data;
+    size_t size;
+    bool mapped;   // false: 'data' is a heap copy
+#ifdef _WIN32
+    void* handle;  // File mapping object
+#endif
+} FileMap;
+
+// Returns false (with a message on stderr) if the file cannot be opened or read.
+bool file_map_open(FileMap* map, const char* path);
+// Takes a heap copy of a file that is already in memory, so the caller's buffer may go away.
+bool file_map_copy(FileMap* map, const void* data, size_t size);
+void file_map_close(FileMap* map);
+
+#endif // MYNES_C_FILE_MAP_H
\ No newline at end of file
@@ -0,0 +1,231 @@
+// The Golden Rule: Include your own header first.
+#include "common/hash.h"
+
+#include <string.h>
+#if defined(__PCLMUL__) && defined(__SSE4_1__)
+#include <wmmintrin.h>
+#include <smmintrin.h>
+#endif
+#if defined(__SHA__) && defined(__SSSE3__)
+#include <immintrin.h>
+#endif
+
+// --- CRC32 ---
+static const u32 crc32_table[256] = {
+    0x00000000, 0x77073096, 0xEE0E612C, 0x990951BA, 0x076DC419, 0x706AF48F, 0xE963A535, 0x9E6495A3,
+    0x0EDB8832, 0x79DCB8A4, 0xE0D5E91E, 0x97D2D988, 0x09B64C2B, 0x7EB17CBD, 0xE7B82D07, 0x90BF1D91,
+    0x1DB71064, 0x6AB020F2, 0xF3B97148, 0x84BE41DE, 0x1ADAD47D, 0x6DDDE4EB, 0xF4D4B551, 0x83D385C7,
+    0x136C9856, 0x646BA8C0, 0xFD62F97A, 0x8A65C9EC, 0x14015C4F, 0x63066CD9, 0xFA0F3D63, 0x8D080DF5,
+    0x3B6E20C8, 0x4C69105E, 0xD56041E4, 0xA2677172, 0x3C03E4D1, 0x4B04D447, 0xD20D85FD, 0xA50AB56B,
+    0x35B5A8FA, 0x42B2986C, 0xDBBBC9D6, 0xACBCF940, 0x32D86CE3, 0x45DF5C75, 0xDCD60DCF, 0xABD13D59,
+    0x26D930AC, 0x51DE003A, 0xC8D75180, 0xBFD06116, 0x21B4F4B5, 0x56B3C423, 0xCFBA9599, 0xB8BDA50F,
+    0x2802B89E, 0x5F058808, 0xC60CD9B2, 0xB10BE924, 0x2F6F7C87, 0x58684C11, 0xC1611DAB, 0xB6662D3D,
+    0x76DC4190, 0x01DB7106, 0x98D220BC, 0xEFD5102A, 0x71B18589, 0x06B6B51F, 0x9FBFE4A5, 0xE8B8D433,
+    0x7807C9A2, 0x0F00F934, 0x9609A88E, 0xE10E9818, 0x7F6A0DBB, 0x086D3D2D, 0x91646C97, 0xE6635C01,
+    0x6B6B51F4, 0x1C6C6162, 0x856530D8, 0xF262004E, 0x6C0695ED, 0x1B01A57B, 0x8208F4C1, 0xF50FC457,
+    0x65B0D9C6, 0x12B7E950, 0x8BBEB8EA, 0xFCB9887C, 0x62DD1DDF, 0x15DA2D49, 0x8CD37CF3, 0xFBD44C65,
+    0x4DB26158, 0x3AB551CE, 0xA3BC0074, 0xD4BB30E2, 0x4ADFA541, 0x3DD895D7, 0xA4D1C46D, 0xD3D6F4FB,
+    0x4369E96A, 0x346ED9FC, 0xAD678846, 0xDA60B8D0, 0x44042D73, 0x33031DE5, 0xAA0A4C5F, 0xDD0D7CC9,
+    0x5005713C, 0x270241AA, 0xBE0B1010, 0xC90C2086, 0x5768B525, 0x206F85B3, 0xB966D409, 0xCE61E49F,
+    0x5EDEF90E, 0x29D9C998, 0xB0D09822, 0xC7D7A8B4, 0x59B33D17, 0x2EB40D81, 0xB7BD5C3B, 0xC0BA6CAD,
+    0xEDB88320, 0x9ABFB3B6, 0x03B6E20C, 0x74B1D29A, 0xEAD54739, 0x9DD277AF, 0x04DB2615, 0x73DC1683,
+    0xE3630B12, 0x94643B84, 0x0D6D6A3E, 0x7A6A5AA8, 0xE40ECF0B, 0x9309FF9D, 0x0A00AE27, 0x7D079EB1,
+    0xF00F9344, 0x8708A3D2, 0x1E01F268, 0x6906C2FE, 0xF762575D, 0x806567CB, 0x196C3671, 0x6E6B06E7,
+    0xFED41B76, 0x89D32BE0, 0x10DA7A5A, 0x67DD4ACC, 0xF9B9DF6F, 0x8EBEEFF9, 0x17B7BE43, 0x60B08ED5,
+    0xD6D6A3E8, 0xA1D1937E, 0x38D8C2C4, 0x4FDFF252, 0xD1BB67F1, 0xA6BC5767, 0x3FB506DD, 0x48B2364B,
+    0xD80D2BDA, 0xAF0A1B4C, 0x36034AF6, 0x41047A60, 0xDF60EFC3, 0xA867DF55, 0x316E8EEF, 0x4669BE79,
+    0xCB61B38C, 0xBC66831A, 0x256FD2A0, 0x5268E236, 0xCC0C7795, 0xBB0B4703, 0x220216B9, 0x5505262F,
+    0xC5BA3BBE, 0xB2BD0B28, 0x2BB45A92, 0x5CB36A04, 0xC2D7FFA7, 0xB5D0CF31, 0x2CD99E8B, 0x5BDEAE1D,
+    0x9B64C2B0, 0xEC63F226, 0x756AA39C, 0x026D930A, 0x9C0906A9, 0xEB0E363F, 0x72076785, 0x05005713,
+    0x95BF4A82, 0xE2B87A14, 0x7BB12BAE, 0x0CB61B38, 0x92D28E9B, 0xE5D5BE0D, 0x7CDCEFB7, 0x0BDBDF21,
+    0x86D3D2D4, 0xF1D4E242, 0x68DDB3F8, 0x1FDA836E, 0x81BE16CD, 0xF6B9265B, 0x6FB077E1, 0x18B74777,
+    0x88085AE6, 0xFF0F6A70, 0x66063BCA, 0x11010B5C, 0x8F659EFF, 0xF862AE69, 0x616BFFD3, 0x166CCF45,
+    0xA00AE278, 0xD70DD2EE, 0x4E048354, 0x3903B3C2, 0xA7672661, 0xD06016F7, 0x4969474D, 0x3E6E77DB,
+    0xAED16A4A, 0xD9D65ADC, 0x40DF0B66, 0x37D83BF0, 0xA9BCAE53, 0xDEBB9EC5, 0x47B2CF7F, 0x30B5FFE9,
+    0xBDBDF21C, 0xCABAC28A, 0x53B39330, 0x24B4A3A6, 0xBAD03605, 0xCDD70693, 0x54DE5729, 0x23D967BF,
+    0xB3667A2E, 0xC4614AB8, 0x5D681B02, 0x2A6F2B94, 0xB40BBE37, 0xC30C8EA1, 0x5A05DF1B, 0x2D02EF8D,
+};
+
+static u32 crc32_bytes(u32 crc, const u8* p, size_t len) {
+    while (len--) { crc = crc32_table[(crc ^ *p++) & 0xFF] ^ (crc >> 8); }
+    return crc;
+}
+
+#if defined(__PCLMUL__) && defined(__SSE4_1__)
+// Folds 64 bytes per iteration with carry-less multiplies, then Barrett-reduces the 128-bit
+// remainder (Intel, "Fast CRC Computation Using PCLMULQDQ"). Takes and returns the raw,
+// non-inverted CRC register. Requires len >= 64 and len % 16 == 0.
+static u32 crc32_clmul(u32 crc, const u8* p, size_t len) {
+    const __m128i k1k2 = _mm_set_epi64x(0x01C6E41596LL, 0x0154442BD4LL);
+    const __m128i k3k4 = _mm_set_epi64x(0x00CCAA009ELL, 0x01751997D0LL);
+    const __m128i k5k0 = _mm_set_epi64x(0, 0x0163CD6124LL);
+    const __m128i poly = _mm_set_epi64x(0x01F7011641LL, 0x01DB710641LL);
+    const __m128i mask32 = _mm_setr_epi32(~0, 0, ~0, 0);
+
+    __m128i x1 = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(p + 0x00)), _mm_cvtsi32_si128((int)crc));
+    __m128i x2 = _mm_loadu_si128((const __m128i*)(p + 0x10));
+    __m128i x3 = _mm_loadu_si128((const __m128i*)(p + 0x20));
+    __m128i x4 = _mm_loadu_si128((const __m128i*)(p + 0x30));
+    p += 64;
+    len -= 64;
+    for (; len >= 64; p += 64, len -= 64) {
+        __m128i x5 = _mm_clmulepi64_si128(x1, k1k2, 0x00);
+        __m128i x6 = _mm_clmulepi64_si128(x2, k1k2, 0x00);
+        __m128i x7 = _mm_clmulepi64_si128(x3, k1k2, 0x00);
+        __m128i x8 = _mm_clmulepi64_si128(x4, k1k2, 0x00);
+        x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, k1k2, 0x11), x5), _mm_loadu_si128((const __m128i*)(p + 0x00)));
+        x2 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x2, k1k2, 0x11), x6), _mm_loadu_si128((const __m128i*)(p + 0x10)));
+        x3 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x3, k1k2, 0x11), x7), _mm_loadu_si128((const __m128i*)(p + 0x20)));
+        x4 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x4, k1k2, 0x11), x8), _mm_loadu_si128((const __m128i*)(p + 0x30)));
+    }
+
+    // Fold the four lanes, then any remaining 16-byte blocks, into one.
+    __m128i next[3] = { x2, x3, x4 };
+    for (int i = 0; i < 3; ++i) {
+        __m128i lo = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+        x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, k3k4, 0x11), next[i]), lo);
+    }
+    for (; len >= 16; p += 16, len -= 16) {
+        __m128i lo = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+        x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, k3k4, 0x11), _mm_loadu_si128((const __m128i*)p)), lo);
+    }
+
+    // 128 -> 64 bits.
+    __m128i x2r = _mm_clmulepi64_si128(x1, k3k4, 0x10);
+    x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2r);
+    x2r = _mm_srli_si128(x1, 4);
+    x1 = _mm_xor_si128(_mm_clmulepi64_si128(_mm_and_si128(x1, mask32), k5k0, 0x00), x2r);
+
+    // Barrett reduction to 32 bits.
+    x2r = _mm_clmulepi64_si128(_mm_and_si128(x1, mask32), poly, 0x10);
+    x2r = _mm_clmulepi64_si128(_mm_and_si128(x2r, mask32), poly, 0x00);
+    x1 = _mm_xor_si128(x1, x2r);
+    return (u32)_mm_extract_epi32(x1, 1);
+}
+#endif
+
+u32 crc32_update(u32 crc, const void* data, size_t len) {
+    const u8* p = (const u8*)data;
+    crc = ~crc;
+#if defined(__PCLMUL__) && defined(__SSE4_1__)
+    if (len >= 64) {
+        size_t bulk = len & ~(size_t)15;
+        crc = crc32_clmul(crc, p, bulk);
+        p += bulk;
+        len -= bulk;
+    }
+#endif
+    return ~crc32_bytes(crc, p, len);
+}
+
+// --- SHA-1 ---
+static inline u32 rol32(u32 x, int n) { return (x << n) | (x >> (32 - n)); }
+
+#if defined(__SHA__) && defined(__SSSE3__)
+// SHA extensions: each sha1rnds4 does four rounds, the message schedule runs four words
+// ahead in msg[] (rotating through four registers).
+#define SHA1_RNDS4(abcd, e, func) \
+    switch (func) { \
+        case 0: abcd = _mm_sha1rnds4_epu32(abcd, e, 0); break; \
+        case 1: abcd = _mm_sha1rnds4_epu32(abcd, e, 1); break; \
+        case 2: abcd = _mm_sha1rnds4_epu32(abcd, e, 2); break; \
+        default: abcd = _mm_sha1rnds4_epu32(abcd, e, 3); break; \
+    }
+
+static void sha1_blocks(u32 state[5], const u8* p, size_t blocks) {
+    const __m128i bswap = _mm_set_epi64x(0x0001020304050607LL, 0x08090A0B0C0D0E0FLL);
+    __m128i abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)state), 0x1B);
+    __m128i e0 = _mm_set_epi32((int)state[4], 0, 0, 0);
+    for (; blocks; --blocks, p += 64) {
+        __m128i abcd_save = abcd, e0_save = e0, e1 = abcd;
+        __m128i msg[4];
+        for (int k = 0; k < 20; ++k) {
+            if (k < 4) { msg[k] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(p + 16 * k)), bswap); }
+            __m128i m = msg[k & 3];
+            // Alternate the E registers: one feeds this group while the other saves ABCD.
+            __m128i* e_cur = (k & 1) ? &e1 : &e0;
+            __m128i* e_next = (k & 1) ? &e0 : &e1;
+            *e_cur = (k == 0) ? _mm_add_epi32(*e_cur, m) : _mm_sha1nexte_epu32(*e_cur, m);
+            *e_next = abcd;
+            if (k >= 3 && k <= 18) { msg[(k + 1) & 3] = _mm_sha1msg2_epu32(msg[(k + 1) & 3], m); }
+            SHA1_RNDS4(abcd, *e_cur, k / 5);
+            if (k >= 1 && k <= 16) { msg[(k + 3) & 3] = _mm_sha1msg1_epu32(msg[(k + 3) & 3], m); }
+            if (k >= 2 && k <= 17) { msg[(k + 2) & 3] = _mm_xor_si128(msg[(k + 2) & 3], m); }
+        }
+        e0 = _mm_sha1nexte_epu32(e0, e0_save);
+        abcd = _mm_add_epi32(abcd, abcd_save);
+    }
+    _mm_storeu_si128((__m128i*)state, _mm_shuffle_epi32(abcd, 0x1B));
+    state[4] = (u32)_mm_extract_epi32(e0, 3);
+}
+#else
+static void sha1_blocks(u32 state[5], const u8* p, size_t blocks) {
+    for (; blocks; --blocks, p += 64) {
+        u32 w[80];
+        for (int i = 0; i < 16; ++i) { w[i] = (u32)p[4 * i] << 24 | (u32)p[4 * i + 1] << 16 | (u32)p[4 * i + 2] << 8 | p[4 * i + 3]; }
+        for (int i = 16; i < 80; ++i) { w[i] = rol32(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1); }
+        u32 a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+        for (int i = 0; i < 80; ++i) {
+            u32 f, k;
+            if (i < 20) { f = (b & c) | (~b & d); k = 0x5A827999; }
+            else if (i < 40) { f = b ^ c ^ d; k = 0x6ED9EBA1; }
+            else if (i < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDC; }
+            else { f = b ^ c ^ d; k = 0xCA62C1D6; }
+            u32 t = rol32(a, 5) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = rol32(b, 30);
+            b = a;
+            a = t;
+        }
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+    }
+}
+#endif
+
+void sha1_init(Sha1* sha) {
+    static const u32 initial[5] = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+    memcpy(sha->state, initial, sizeof(initial));
+    sha->length = 0;
+}
+
+void sha1_update(Sha1* sha, const void* data, size_t len) {
+    const u8* p = (const u8*)data;
+    u32 used = (u32)(sha->length & 63);
+    sha->length += len;
+    if (used) {
+        u32 take = (len < 64 - used) ? (u32)len : 64 - used;
+        memcpy(sha->block + used, p, take);
+        p += take;
+        len -= take;
+        if (used + take < 64) { return; }
+        sha1_blocks(sha->state, sha->block, 1);
+    }
+    sha1_blocks(sha->state, p, len / 64);
+    memcpy(sha->block, p + (len & ~(size_t)63), len & 63);
+}
+
+void sha1_final(Sha1* sha, u8 digest[SHA1_DIGEST_SIZE]) {
+    u64 bits = sha->length * 8;
+    u8 pad[72] = { 0x80 };
+    size_t pad_len = ((sha->length & 63) < 56 ? 56 : 120) - (sha->length & 63);
+    for (int i = 0; i < 8; ++i) { pad[pad_len + i] = (u8)(bits >> (56 - 8 * i)); }
+    sha1_update(sha, pad, pad_len + 8);
+    for (int i = 0; i < 5; ++i) {
+        digest[4 * i + 0] = (u8)(sha->state[i] >> 24);
+        digest[4 * i + 1] = (u8)(sha->state[i] >> 16);
+        digest[4 * i + 2] = (u8)(sha->state[i] >> 8);
+        digest[4 * i + 3] = (u8)sha->state[i];
+    }
+}
+
+// --- FNV-1a ---
+u64 fnv1a64_update(u64 hash, const void* data, size_t len) {
+    const u8* p = (const u8*)data;
+    for (size_t i = 0; i < len; ++i) { hash = (hash ^ p[i]) * 0x100000001B3ULL; }
+    return hash;
+}
\ No newline at end of file
@@ -0,0 +1,35 @@
+#ifndef MYNES_C_HASH_H
+#define MYNES_C_HASH_H
+
+#include <stddef.h>
+#include "common/types.h"
+
+// --- Checksums ---
+// CRC32 (the zlib/PNG polynomial, as used by ROM databases) and SHA-1. Both have portable
+// implementations and use the CPU's instructions when the build enables them:
+// PCLMULQDQ folding for CRC32 (-mpclmul -msse4.1) and the SHA extensions for SHA-1 (-msha).
+
+// Continues a CRC32 over more data; start with crc = 0.
+u32 crc32_update(u32 crc, const void* data, size_t len);
+
+typedef struct Sha1 {
+    u32 state[5];
+    u64 length;   // Bytes hashed so far
+    u8 block[64]; // Pending partial block
+} Sha1;
+
+#define SHA1_DIGEST_SIZE 20
+
+void sha1_init(Sha1* sha);
+void sha1_update(Sha1* sha, const void* data, size_t len);
+void sha1_final(Sha1* sha, u8 digest[SHA1_DIGEST_SIZE]);
+
+// --- FNV-1a ---
+// 64-bit FNV-1a: a cheap hash for telling emulator output apart (frame and state hashes), not
+// for identifying files. Continue with the previous result; start with FNV1A64_BASIS.
+#define FNV1A64_BASIS 0xCBF29CE484222325ULL
+
+u64 fnv1a64_update(u64 hash, const void* data, size_t len);
+static inline u64 fnv1a64(const void* data, size_t len) { return fnv1a64_update(FNV1A64_BASIS, data, len); }
+
+#endif // MYNES_C_HASH_H
\ No newline at end of file
@@ -0,0 +1,21 @@
+// The Golden Rule: Include your own header first.
+#include "common/json.h"
+
+void json_write_string(FILE* out, const char* s) {
+    fputc('"', out);
+    for (; *s; ++s) {
+        unsigned char c = (unsigned char)*s;
+        switch (c) {
+            case '"':  fputs("\\\"", out); break;
+            case '\\': fputs("\\\\", out); break;
+            case '\n': fputs("\\n", out); break;
+            case '\r': fputs("\\r", out); break;
+            case '\t': fputs("\\t", out); break;
+            default:
+                if (c < 0x20) { fprintf(out, "\\u%04x", c); }
+                else { fputc(c, out); } // UTF-8 passes through as is
+                break;
+        }
+    }
+    fputc('"', out);
+}
\ No newline at end of file
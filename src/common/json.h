@@ -0,0 +1,14 @@
+#ifndef MYNES_C_JSON_H
+#define MYNES_C_JSON_H
+
+#include <stdio.h>
+
+// --- JSON Output ---
+// The tools write their reports with fprintf; strings that come from outside (paths, error
+// messages) go through here so that quotes, backslashes (Windows paths) and control
+// characters cannot break the document.
+
+// Writes 's' as a quoted JSON string.
+void json_write_string(FILE* out, const char* s);
+
+#endif // MYNES_C_JSON_H
\ No newline at end of file
@@ -0,0 +1,57 @@
+#ifndef MYNES_C_SPSC_RING_H
+#define MYNES_C_SPSC_RING_H
+
+#include "common/types.h"
+#include <stdatomic.h>
+
+// --- Lock-free Sample Ring ---
+// A bounded FIFO of audio samples between exactly one producer thread and one consumer thread
+// (e.g. the emulation thread and the audio callback). Each side owns one index and only
+// reads the other's, so neither ever blocks or takes a lock: a full ring refuses the excess
+// and an empty one returns short. The capacity must be a power of two.
+
+typedef struct SpscRing {
+    s16* data;
+    u32 mask;              // capacity - 1
+    _Atomic u32 head;      // Next slot to write; advanced by the producer only
+    _Atomic u32 tail;      // Next slot to read; advanced by the consumer only
+} SpscRing;
+
+static inline void spsc_ring_init(SpscRing* ring, s16* data, u32 capacity) {
+    ring->data = data;
+    ring->mask = capacity - 1;
+    atomic_init(&ring->head, 0u);
+    atomic_init(&ring->tail, 0u);
+}
+
+static inline u32 spsc_ring_capacity(const SpscRing* ring) { return ring->mask + 1; }
+
+// Samples currently queued. Exact on either side for its own purposes; a snapshot otherwise.
+static inline u32 spsc_ring_size(SpscRing* ring) {
+    return atomic_load_explicit(&ring->head, memory_order_acquire) - atomic_load_explicit(&ring->tail, memory_order_acquire);
+}
+
+// --- Producer Side ---
+// Appends as many of 'count' samples as fit. Returns the number written.
+static inline u32 spsc_ring_write(SpscRing* ring, const s16* samples, u32 count) {
+    u32 head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    u32 tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    u32 space = spsc_ring_capacity(ring) - (head - tail);
+    if (count > space) { count = space; }
+    for (u32 i = 0; i < count; ++i) { ring->data[(head + i) & ring->mask] = samples[i]; }
+    atomic_store_explicit(&ring->head, head + count, memory_order_release);
+    return count;
+}
+
+// --- Consumer Side ---
+// Removes up to 'count' samples into 'out'. Returns the number read.
+static inline u32 spsc_ring_read(SpscRing* ring, s16* out, u32 count) {
+    u32 tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    u32 head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    if (count > head - tail) { count = head - tail; }
+    for (u32 i = 0; i < count; ++i) { out[i] = ring->data[(tail + i) & ring->mask]; }
+    atomic_store_explicit(&ring->tail, tail + count, memory_order_release);
+    return count;
+}
+
+#endif // MYNES_C_SPSC_RING_H
\ No newline at end of file
@@ -0,0 +1,210 @@
+// The Golden Rule: Include your own header first.
+#include "common/thread_pool.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h> // For GetSystemInfo
+#else
+#include <unistd.h> // For sysconf
+#endif
+
+typedef struct {
+    ThreadPoolTask fn;
+    void* arg;
+} Task;
+
+// A worker's deque: a growable ring of tasks. The owner pushes and pops at 'tail'; thieves
+// take from 'head'. One short mutex per deque keeps it simple, and with whole-job tasks
+// contention is negligible.
+typedef struct {
+    pthread_mutex_t lock;
+    Task* tasks;
+    u32 capacity; // Power of two
+    u32 head;
+    u32 tail;     // head == tail: empty
+    pthread_t thread;
+    ThreadPool* pool;
+    u32 index;
+} Worker;
+
+struct ThreadPool {
+    Worker* workers;
+    u32 count;
+    atomic_uint next_worker; // Round-robin target for external submissions
+    atomic_int queued;       // Tasks sitting in deques
+    atomic_long pending;     // Tasks submitted and not yet finished
+
+    pthread_mutex_t lock;    // Guards sleeping: idle workers and thread_pool_wait()
+    pthread_cond_t work_available;
+    pthread_cond_t all_done;
+    bool stopping;
+};
+
+// The worker the current thread is, so tasks submitted from inside a task stay local.
+static _Thread_local Worker* current_worker;
+
+#define DEQUE_INITIAL_CAPACITY 64
+
+static bool deque_push(Worker* w, Task task) {
+    pthread_mutex_lock(&w->lock);
+    if (w->tail - w->head == w->capacity) {
+        u32 capacity = w->capacity * 2;
+        Task* tasks = (Task*)malloc(capacity * sizeof(Task));
+        if (!tasks) {
+            pthread_mutex_unlock(&w->lock);
+            return false;
+        }
+        for (u32 i = 0; i < w->capacity; ++i) { tasks[i] = w->tasks[(w->head + i) & (w->capacity - 1)]; }
+        free(w->tasks);
+        w->tasks = tasks;
+        w->tail = w->capacity;
+        w->head = 0;
+        w->capacity = capacity;
+    }
+    w->tasks[w->tail++ & (w->capacity - 1)] = task;
+    pthread_mutex_unlock(&w->lock);
+    return true;
+}
+
+// Takes from the back (owner) or the front (thief).
+static bool deque_take(Worker* w, Task* out, bool steal) {
+    pthread_mutex_lock(&w->lock);
+    bool found = w->head != w->tail;
+    if (found) { *out = steal ? w->tasks[w->head++ & (w->capacity - 1)] : w->tasks[--w->tail & (w->capacity - 1)]; }
+    pthread_mutex_unlock(&w->lock);
+    return found;
+}
+
+static bool worker_find_task(Worker* self, Task* out) {
+    ThreadPool* pool = self->pool;
+    if (atomic_load_explicit(&pool->queued, memory_order_acquire) <= 0) { return false; }
+    bool found = deque_take(self, out, false);
+    for (u32 i = 1; !found && i < pool->count; ++i) {
+        found = deque_take(&pool->workers[(self->index + i) % pool->count], out, true);
+    }
+    if (found) { atomic_fetch_sub_explicit(&pool->queued, 1, memory_order_relaxed); }
+    return found;
+}
+
+static void task_finished(ThreadPool* pool) {
+    if (atomic_fetch_sub_explicit(&pool->pending, 1, memory_order_acq_rel) == 1) {
+        pthread_mutex_lock(&pool->lock);
+        pthread_cond_broadcast(&pool->all_done);
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
+
+static void* worker_main(void* data) {
+    Worker* self = (Worker*)data;
+    ThreadPool* pool = self->pool;
+    current_worker = self;
+    for (;;) {
+        Task task;
+        if (worker_find_task(self, &task)) {
+            task.fn(task.arg, self->index);
+            task_finished(pool);
+            continue;
+        }
+        pthread_mutex_lock(&pool->lock);
+        while (atomic_load(&pool->queued) <= 0 && !pool->stopping) { pthread_cond_wait(&pool->work_available, &pool->lock); }
+        bool stop = pool->stopping && atomic_load(&pool->queued) <= 0;
+        pthread_mutex_unlock(&pool->lock);
+        if (stop) { return NULL; }
+    }
+}
+
+static u32 online_cpus(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? (u32)info.dwNumberOfProcessors : 1;
+#else
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return cpus > 0 ? (u32)cpus : 1;
+#endif
+}
+
+ThreadPool* thread_pool_create(u32 threads) {
+    if (threads == 0) { threads = online_cpus(); }
+    ThreadPool* pool = (ThreadPool*)calloc(1, sizeof(ThreadPool));
+    if (!pool) { return NULL; }
+    pool->workers = (Worker*)calloc(threads, sizeof(Worker));
+    if (!pool->workers) {
+        free(pool);
+        return NULL;
+    }
+    atomic_init(&pool->next_worker, 0);
+    atomic_init(&pool->queued, 0);
+    atomic_init(&pool->pending, 0);
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work_available, NULL);
+    pthread_cond_init(&pool->all_done, NULL);
+
+    for (u32 i = 0; i < threads; ++i) {
+        Worker* w = &pool->workers[i];
+        pthread_mutex_init(&w->lock, NULL);
+        w->capacity = DEQUE_INITIAL_CAPACITY;
+        w->tasks = (Task*)malloc(w->capacity * sizeof(Task));
+        w->pool = pool;
+        w->index = i;
+        if (!w->tasks || pthread_create(&w->thread, NULL, worker_main, w) != 0) {
+            free(w->tasks);
+            pthread_mutex_destroy(&w->lock);
+            break;
+        }
+        pool->count++;
+    }
+    if (pool->count == 0) {
+        thread_pool_destroy(pool);
+        return NULL;
+    }
+    return pool;
+}
+
+u32 thread_pool_size(const ThreadPool* pool) { return pool->count; }
+
+bool thread_pool_submit(ThreadPool* pool, ThreadPoolTask fn, void* arg) {
+    Worker* target = current_worker && current_worker->pool == pool
+        ? current_worker
+        : &pool->workers[atomic_fetch_add_explicit(&pool->next_worker, 1, memory_order_relaxed) % pool->count];
+
+    // Counted as pending before it can possibly run, so wait() never sees a false zero.
+    atomic_fetch_add_explicit(&pool->pending, 1, memory_order_relaxed);
+    if (!deque_push(target, (Task){ fn, arg })) {
+        task_finished(pool);
+        return false;
+    }
+    atomic_fetch_add_explicit(&pool->queued, 1, memory_order_release);
+    pthread_mutex_lock(&pool->lock);
+    pthread_cond_signal(&pool->work_available);
+    pthread_mutex_unlock(&pool->lock);
+    return true;
+}
+
+void thread_pool_wait(ThreadPool* pool) {
+    pthread_mutex_lock(&pool->lock);
+    while (atomic_load(&pool->pending) > 0) { pthread_cond_wait(&pool->all_done, &pool->lock); }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void thread_pool_destroy(ThreadPool* pool) {
+    if (!pool) { return; }
+    thread_pool_wait(pool);
+    pthread_mutex_lock(&pool->lock);
+    pool->stopping = true;
+    pthread_cond_broadcast(&pool->work_available);
+    pthread_mutex_unlock(&pool->lock);
+    for (u32 i = 0; i < pool->count; ++i) {
+        pthread_join(pool->workers[i].thread, NULL);
+        free(pool->workers[i].tasks);
+        pthread_mutex_destroy(&pool->workers[i].lock);
+    }
+    pthread_cond_destroy(&pool->work_available);
+    pthread_cond_destroy(&pool->all_done);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->workers);
+    free(pool);
+}
\ No newline at end of file
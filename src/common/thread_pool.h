@@ -0,0 +1,33 @@
+#ifndef MYNES_C_THREAD_POOL_H
+#define MYNES_C_THREAD_POOL_H
+
+#include "common/types.h"
+
+// --- Work-Stealing Thread Pool ---
+// Each worker owns a deque of tasks. Workers pop their own newest task (LIFO, cache warm)
+// and, when their deque runs dry, steal the oldest task from another worker (FIFO, so the
+// biggest remaining chunks of work move). Tasks submitted from outside the pool are dealt
+// round-robin across the deques. Task order is not guaranteed; callers that need ordered
+// output store results by index.
+typedef struct ThreadPool ThreadPool;
+
+// 'worker' is the index (0 .. threads-1) of the thread running the task, for per-thread scratch.
+typedef void (*ThreadPoolTask)(void* arg, u32 worker);
+
+/**
+ * @brief Starts a pool of 'threads' workers (0 picks the number of online CPUs).
+ * @return The pool, or NULL if it could not be created.
+ */
+ThreadPool* thread_pool_create(u32 threads);
+u32 thread_pool_size(const ThreadPool* pool);
+
+// Queues a task. Safe to call from any thread, including from inside a task.
+bool thread_pool_submit(ThreadPool* pool, ThreadPoolTask fn, void* arg);
+
+// Blocks until every submitted task has finished.
+void thread_pool_wait(ThreadPool* pool);
+
+// Waits for outstanding tasks, then stops and frees the pool.
+void thread_pool_destroy(ThreadPool* pool);
+
+#endif // MYNES_C_THREAD_POOL_H
\ No newline at end of file
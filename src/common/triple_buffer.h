@@ -0,0 +1,53 @@
+#ifndef MYNES_C_TRIPLE_BUFFER_H
+#define MYNES_C_TRIPLE_BUFFER_H
+
+#include "common/types.h"
+#include <stdatomic.h>
+
+// --- Lock-free Triple Buffer ---
+// One producer and one consumer share three buffers. The producer always owns 'back' and the
+// consumer 'front'; the third sits in 'middle' and is swapped in by either side with a single
+// atomic exchange. Nothing is copied and neither side ever waits for the other: the producer
+// overwrites a frame the consumer never picked up, and the consumer keeps showing its current
+// frame until a newer one is published.
+
+#define TRIPLE_BUFFER_FRESH 0x4u // Set in 'middle' when it holds a frame the consumer has not seen
+
+typedef struct TripleBuffer {
+    void* buffers[3];
+    u32 back;             // Producer-owned index
+    u32 front;            // Consumer-owned index
+    _Atomic u32 middle;   // Index of the spare buffer, plus TRIPLE_BUFFER_FRESH
+} TripleBuffer;
+
+static inline void triple_buffer_init(TripleBuffer* tb, void* a, void* b, void* c) {
+    tb->buffers[0] = a;
+    tb->buffers[1] = b;
+    tb->buffers[2] = c;
+    tb->back = 0;
+    tb->front = 1;
+    atomic_init(&tb->middle, 2u);
+}
+
+// --- Producer Side ---
+static inline void* triple_buffer_back(TripleBuffer* tb) { return tb->buffers[tb->back]; }
+
+// Publishes the back buffer and returns the buffer to draw the next frame into.
+static inline void* triple_buffer_publish(TripleBuffer* tb) {
+    u32 old = atomic_exchange_explicit(&tb->middle, tb->back | TRIPLE_BUFFER_FRESH, memory_order_acq_rel);
+    tb->back = old & 3u;
+    return tb->buffers[tb->back];
+}
+
+// --- Consumer Side ---
+// Takes the newest published frame, if there is one. Returns false when 'front' is current.
+static inline bool triple_buffer_acquire(TripleBuffer* tb) {
+    if (!(atomic_load_explicit(&tb->middle, memory_order_relaxed) & TRIPLE_BUFFER_FRESH)) { return false; }
+    u32 old = atomic_exchange_explicit(&tb->middle, tb->front, memory_order_acq_rel);
+    tb->front = old & 3u;
+    return true;
+}
+
+static inline const void* triple_buffer_front(const TripleBuffer* tb) { return tb->buffers[tb->front]; }
+
+#endif // MYNES_C_TRIPLE_BUFFER_H
\ No newline at end of file
@@ -0,0 +1,16 @@
+// The Golden Rule: Include your own header first.
+#include "controller/controller.h"
+
+void controller_write(Controller* pad, u8 data) {
+    // While the strobe is high the register reloads continuously, so the report latched on
+    // the falling edge is whatever is held then.
+    if (pad->strobe || (data & 1)) { pad->shift = pad->buttons; }
+    pad->strobe = (data & 1) != 0;
+}
+
+u8 controller_read(Controller* pad) {
+    if (pad->strobe) { return pad->buttons & 1; }
+    u8 bit = pad->shift & 1;
+    pad->shift = (u8)(pad->shift >> 1 | 0x80); // Official pads report 1 once all 8 bits are out
+    return bit;
+}
\ No newline at end of file
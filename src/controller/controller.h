@@ -0,0 +1,29 @@
+#ifndef MYNES_C_CONTROLLER_H
+#define MYNES_C_CONTROLLER_H
+
+#include "common/types.h"
+
+// --- Standard Controller ---
+// Writing 1 to $4016 holds both pads' shift registers in reload; writing 0 latches the buttons
+// held at that moment. Each read of $4016 (port 1) or $4017 (port 2) then returns the next
+// bit, A first. Button bits use the same order.
+#define BUTTON_A      0x01
+#define BUTTON_B      0x02
+#define BUTTON_SELECT 0x04
+#define BUTTON_START  0x08
+#define BUTTON_UP     0x10
+#define BUTTON_DOWN   0x20
+#define BUTTON_LEFT   0x40
+#define BUTTON_RIGHT  0x80
+
+typedef struct Controller {
+    u8 buttons;  // Held buttons; set by the front end between frames
+    u8 shift;    // Latched report, next bit in bit 0
+    bool strobe; // Last bit 0 written to $4016
+} Controller;
+
+// --- Function Prototypes ---
+void controller_write(Controller* pad, u8 data);
+u8 controller_read(Controller* pad);
+
+#endif // MYNES_C_CONTROLLER_H
\ No newline at end of file
@@ -2,171 +2,576 @@
 #include "cpu/cpu.h"
 
 #include "bus/bus.h"
+#include "cpu/cpu_opcodes.h"
+#include "ppu/ppu.h"
 #include <string.h>
 #include <stdio.h>
 
-// --- Helper Functions (all now take Bus*) ---
-static u8 cpu_fetch_byte(CPU* cpu, Bus* bus) { u8 d = bus_read(bus, cpu->pc); cpu->pc++; return d; }
-static u16 cpu_fetch_word(CPU* cpu, Bus* bus) { u8 lo = cpu_fetch_byte(cpu, bus); u8 hi = cpu_fetch_byte(cpu, bus); return (u16)hi << 8 | (u16)lo; }
-static void cpu_set_flag(CPU* cpu, CpuFlags flag, bool value) { if (value) cpu->status |= flag; else cpu->status &= ~flag; }
-static u8 cpu_get_flag(CPU* cpu, CpuFlags flag) { return (cpu->status & flag) > 0; }
-static void cpu_update_zn_flags(CPU* cpu, u8 v) { cpu_set_flag(cpu, Z_FLAG, v == 0); cpu_set_flag(cpu, N_FLAG, v & 0x80); }
-static void cpu_stack_push(CPU* cpu, Bus* bus, u8 d) { bus_write(bus, 0x0100 | cpu->sp, d); cpu->sp--; }
-static u8 cpu_stack_pop(CPU* cpu, Bus* bus) { cpu->sp++; return bus_read(bus, 0x0100 | cpu->sp); }
-static void cpu_stack_push_word(CPU* cpu, Bus* bus, u16 d) { cpu_stack_push(cpu, bus, (u8)(d >> 8)); cpu_stack_push(cpu, bus, (u8)(d & 0xFF)); }
-static u16 cpu_stack_pop_word(CPU* cpu, Bus* bus) { u8 lo = cpu_stack_pop(cpu, bus); u8 hi = cpu_stack_pop(cpu, bus); return (u16)hi << 8 | (u16)lo; }
-
-// --- Addressing Modes (all now take Bus*) ---
-static u16 get_operand_address(CPU* cpu, Bus* bus, AddressingMode mode) {
-    switch (mode) {
-        case AM_IMM: return cpu->pc++;
-        case AM_ZP0: return cpu_fetch_byte(cpu, bus);
-        case AM_ZPX: return (cpu_fetch_byte(cpu, bus) + cpu->x) & 0xFF;
-        case AM_ZPY: return (cpu_fetch_byte(cpu, bus) + cpu->y) & 0xFF;
-        case AM_ABS: return cpu_fetch_word(cpu, bus);
-        case AM_ABX: return cpu_fetch_word(cpu, bus) + cpu->x;
-        case AM_ABY: return cpu_fetch_word(cpu, bus) + cpu->y;
-        case AM_IND: { u16 ptr = cpu_fetch_word(cpu, bus); u16 lo = bus_read(bus, ptr); u16 hi = bus_read(bus, (ptr & 0xFF00) | ((ptr + 1) & 0x00FF)); return (u16)hi << 8 | (u16)lo; }
-        case AM_IZX: { u8 ptr = cpu_fetch_byte(cpu, bus) + cpu->x; u16 lo = bus_read(bus, ptr & 0xFF); u16 hi = bus_read(bus, (ptr + 1) & 0xFF); return (u16)hi << 8 | (u16)lo; }
-        case AM_IZY: { u8 ptr = cpu_fetch_byte(cpu, bus); u16 lo = bus_read(bus, ptr); u16 hi = bus_read(bus, (ptr + 1) & 0xFF); return ((u16)hi << 8 | (u16)lo) + cpu->y; }
-        case AM_ACC: case AM_IMP: case AM_REL: default: return 0;
-    }
+// --- Helper Functions ---
+static inline u8 cpu_fetch_byte(CPU* cpu, Bus* bus) { u8 d = bus_read(bus, cpu->pc); cpu->pc++; return d; }
+static inline u16 cpu_fetch_word(CPU* cpu, Bus* bus) { u8 lo = cpu_fetch_byte(cpu, bus); u8 hi = cpu_fetch_byte(cpu, bus); return (u16)hi << 8 | (u16)lo; }
+static inline void cpu_update_zn_flags(CPU* cpu, u8 v) { cpu->flag_nz = v; }
+static inline bool cpu_flag_z(const CPU* cpu) { return (cpu->flag_nz & 0x00FF) == 0; }
+static inline bool cpu_flag_n(const CPU* cpu) { return (cpu->flag_nz & 0x8080) != 0; }
+static inline bool cpu_flag_v(const CPU* cpu) { return (cpu->flag_v & 0x80) != 0; }
+static inline u8 cpu_pack_status(const CPU* cpu) {
+    return (u8)((cpu->status & (I_FLAG | D_FLAG | B_FLAG | U_FLAG)) | (cpu->flag_c ? C_FLAG : 0) | (cpu_flag_z(cpu) ? Z_FLAG : 0) |
+                (cpu_flag_v(cpu) ? V_FLAG : 0) | (cpu_flag_n(cpu) ? N_FLAG : 0));
+}
+static inline void cpu_unpack_status(CPU* cpu, u8 status) {
+    cpu->status = status & (I_FLAG | D_FLAG | B_FLAG | U_FLAG);
+    cpu->flag_c = status & C_FLAG;
+    cpu->flag_nz = (u16)((status & N_FLAG) << 8) | ((status & Z_FLAG) ? 0 : 1);
+    cpu->flag_v = (u8)((status & V_FLAG) << 1);
 }
+static inline void cpu_stack_push(CPU* cpu, Bus* bus, u8 d) { bus_write(bus, 0x0100 | cpu->sp, d); cpu->sp--; }
+static inline u8 cpu_stack_pop(CPU* cpu, Bus* bus) { cpu->sp++; return bus_read(bus, 0x0100 | cpu->sp); }
+static inline void cpu_stack_push_word(CPU* cpu, Bus* bus, u16 d) { cpu_stack_push(cpu, bus, (u8)(d >> 8)); cpu_stack_push(cpu, bus, (u8)(d & 0xFF)); }
+static inline u16 cpu_stack_pop_word(CPU* cpu, Bus* bus) { u8 lo = cpu_stack_pop(cpu, bus); u8 hi = cpu_stack_pop(cpu, bus); return (u16)hi << 8 | (u16)lo; }
+static inline u16 cpu_read_word_zp(Bus* bus, u8 ptr) { u16 lo = bus_read(bus, ptr); u16 hi = bus_read(bus, (u8)(ptr + 1)); return (u16)hi << 8 | lo; }
+static inline u16 cpu_read_vector(Bus* bus, u16 vector) { u16 lo = bus_read(bus, vector); u16 hi = bus_read(bus, vector + 1); return (u16)hi << 8 | lo; }
+// Called after the I flag may have been cleared: stop the run so the IRQ gets serviced.
+static inline void cpu_check_irq(CPU* cpu) { if (cpu->irq_lines && !(cpu->status & I_FLAG)) cpu->deadline = 0; }
+
+// --- Addressing Modes ---
+// Each mode receives the operand bytes that were already fetched and returns the effective
+// address. 'read' selects the extra cycle that indexed reads pay when crossing a page;
+// stores and read-modify-write instructions always pay it and have it in their base cycles.
+static inline u16 cpu_page_cross(CPU* cpu, u16 base, u16 addr, bool read) { if (read && ((base ^ addr) & 0xFF00)) cpu->cycles++; return addr; }
+static inline u16 am_zpx(CPU* cpu, u8 zp) { return (u8)(zp + cpu->x); }
+static inline u16 am_zpy(CPU* cpu, u8 zp) { return (u8)(zp + cpu->y); }
+static inline u16 am_abx(CPU* cpu, u16 base, bool read) { return cpu_page_cross(cpu, base, base + cpu->x, read); }
+static inline u16 am_aby(CPU* cpu, u16 base, bool read) { return cpu_page_cross(cpu, base, base + cpu->y, read); }
+static inline u16 am_ind(Bus* bus, u16 ptr) { u16 lo = bus_read(bus, ptr); u16 hi = bus_read(bus, (ptr & 0xFF00) | ((ptr + 1) & 0x00FF)); return (u16)hi << 8 | lo; }
+static inline u16 am_izx(CPU* cpu, Bus* bus, u8 zp) { return cpu_read_word_zp(bus, (u8)(zp + cpu->x)); }
+static inline u16 am_izy(CPU* cpu, Bus* bus, u8 zp, bool read) { u16 base = cpu_read_word_zp(bus, zp); return cpu_page_cross(cpu, base, base + cpu->y, read); }
+
+// --- Shared ALU Helpers ---
+static inline void alu_adc(CPU* cpu, u8 v) { u16 sum = cpu->a + v + cpu->flag_c; cpu->flag_c = (u8)(sum >> 8); cpu->flag_v = (u8)(~(cpu->a ^ v) & (cpu->a ^ sum)); cpu->a = (u8)sum; cpu_update_zn_flags(cpu, cpu->a); }
+static inline void alu_compare(CPU* cpu, u8 reg, u8 v) { cpu->flag_c = reg >= v; cpu_update_zn_flags(cpu, (u8)(reg - v)); }
+static inline u8 alu_asl(CPU* cpu, u8 v) { cpu->flag_c = v >> 7; v <<= 1; cpu_update_zn_flags(cpu, v); return v; }
+static inline u8 alu_lsr(CPU* cpu, u8 v) { cpu->flag_c = v & 1; v >>= 1; cpu_update_zn_flags(cpu, v); return v; }
+static inline u8 alu_rol(CPU* cpu, u8 v) { u8 c = cpu->flag_c; cpu->flag_c = v >> 7; v = (u8)(v << 1) | c; cpu_update_zn_flags(cpu, v); return v; }
+static inline u8 alu_ror(CPU* cpu, u8 v) { u8 c = cpu->flag_c; cpu->flag_c = v & 1; v = (v >> 1) | (u8)(c << 7); cpu_update_zn_flags(cpu, v); return v; }
+
+// --- Read Instructions (kind R) ---
+static inline void op_adc(CPU* cpu, u8 v) { alu_adc(cpu, v); }
+static inline void op_sbc(CPU* cpu, u8 v) { alu_adc(cpu, (u8)~v); }
+static inline void op_and(CPU* cpu, u8 v) { cpu->a &= v; cpu_update_zn_flags(cpu, cpu->a); }
+static inline void op_eor(CPU* cpu, u8 v) { cpu->a ^= v; cpu_update_zn_flags(cpu, cpu->a); }
+static inline void op_ora(CPU* cpu, u8 v) { cpu->a |= v; cpu_update_zn_flags(cpu, cpu->a); }
+static inline void op_bit(CPU* cpu, u8 v) { cpu->flag_nz = (u16)(v & cpu->a) | (u16)((v & 0x80) << 8); cpu->flag_v = (u8)(v << 1); }
+static inline void op_cmp(CPU* cpu, u8 v) { alu_compare(cpu, cpu->a, v); }
+static inline void op_cpx(CPU* cpu, u8 v) { alu_compare(cpu, cpu->x, v); }
+static inline void op_cpy(CPU* cpu, u8 v) { alu_compare(cpu, cpu->y, v); }
+static inline void op_lda(CPU* cpu, u8 v) { cpu->a = v; cpu_update_zn_flags(cpu, cpu->a); }
+static inline void op_ldx(CPU* cpu, u8 v) { cpu->x = v; cpu_update_zn_flags(cpu, cpu->x); }
+static inline void op_ldy(CPU* cpu, u8 v) { cpu->y = v; cpu_update_zn_flags(cpu, cpu->y); }
+static inline void op_ign(CPU* cpu, u8 v) { (void)cpu; (void)v; }
+// Unofficial read instructions.
+static inline void op_lax(CPU* cpu, u8 v) { cpu->a = cpu->x = v; cpu_update_zn_flags(cpu, v); }
+static inline void op_anc(CPU* cpu, u8 v) { op_and(cpu, v); cpu->flag_c = cpu->a >> 7; }
+static inline void op_alr(CPU* cpu, u8 v) { cpu->a = alu_lsr(cpu, cpu->a & v); }
+static inline void op_arr(CPU* cpu, u8 v) { cpu->a = (u8)((cpu->a & v) >> 1) | (u8)(cpu->flag_c << 7); cpu_update_zn_flags(cpu, cpu->a); cpu->flag_c = (cpu->a >> 6) & 1; cpu->flag_v = (u8)((cpu->a ^ (cpu->a << 1)) << 1); }
+static inline void op_axs(CPU* cpu, u8 v) { u8 ax = cpu->a & cpu->x; cpu->flag_c = ax >= v; cpu->x = (u8)(ax - v); cpu_update_zn_flags(cpu, cpu->x); }
+static inline void op_lxa(CPU* cpu, u8 v) { cpu->a = cpu->x = (cpu->a | 0xEE) & v; cpu_update_zn_flags(cpu, cpu->a); }
+static inline void op_xaa(CPU* cpu, u8 v) { cpu->a = (cpu->a | 0xEE) & cpu->x & v; cpu_update_zn_flags(cpu, cpu->a); }
+static inline void op_las(CPU* cpu, u8 v) { cpu->a = cpu->x = cpu->sp = v & cpu->sp; cpu_update_zn_flags(cpu, cpu->a); }
+
+// --- Write, Read-Modify-Write and Jump Instructions (kind W) ---
+static inline void op_sta(CPU* cpu, Bus* bus, u16 a) { bus_write(bus, a, cpu->a); }
+static inline void op_stx(CPU* cpu, Bus* bus, u16 a) { bus_write(bus, a, cpu->x); }
+static inline void op_sty(CPU* cpu, Bus* bus, u16 a) { bus_write(bus, a, cpu->y); }
+static inline void op_asl(CPU* cpu, Bus* bus, u16 a) { bus_write(bus, a, alu_asl(cpu, bus_read(bus, a))); }
+static inline void op_lsr(CPU* cpu, Bus* bus, u16 a) { bus_write(bus, a, alu_lsr(cpu, bus_read(bus, a))); }
+static inline void op_rol(CPU* cpu, Bus* bus, u16 a) { bus_write(bus, a, alu_rol(cpu, bus_read(bus, a))); }
+static inline void op_ror(CPU* cpu, Bus* bus, u16 a) { bus_write(bus, a, alu_ror(cpu, bus_read(bus, a))); }
+static inline void op_inc(CPU* cpu, Bus* bus, u16 a) { u8 v = bus_read(bus, a) + 1; bus_write(bus, a, v); cpu_update_zn_flags(cpu, v); }
+static inline void op_dec(CPU* cpu, Bus* bus, u16 a) { u8 v = bus_read(bus, a) - 1; bus_write(bus, a, v); cpu_update_zn_flags(cpu, v); }
+static inline void op_jmp(CPU* cpu, Bus* bus, u16 a) { (void)bus; cpu->pc = a; }
+static inline void op_jsr(CPU* cpu, Bus* bus, u16 a) { cpu_stack_push_word(cpu, bus, cpu->pc - 1); cpu->pc = a; }
+// Unofficial read-modify-write instructions: a shift or increment fused with an ALU operation.
+static inline void op_sax(CPU* cpu, Bus* bus, u16 a) { bus_write(bus, a, cpu->a & cpu->x); }
+static inline void op_slo(CPU* cpu, Bus* bus, u16 a) { u8 v = alu_asl(cpu, bus_read(bus, a)); bus_write(bus, a, v); op_ora(cpu, v); }
+static inline void op_rla(CPU* cpu, Bus* bus, u16 a) { u8 v = alu_rol(cpu, bus_read(bus, a)); bus_write(bus, a, v); op_and(cpu, v); }
+static inline void op_sre(CPU* cpu, Bus* bus, u16 a) { u8 v = alu_lsr(cpu, bus_read(bus, a)); bus_write(bus, a, v); op_eor(cpu, v); }
+static inline void op_rra(CPU* cpu, Bus* bus, u16 a) { u8 v = alu_ror(cpu, bus_read(bus, a)); bus_write(bus, a, v); alu_adc(cpu, v); }
+static inline void op_dcp(CPU* cpu, Bus* bus, u16 a) { u8 v = bus_read(bus, a) - 1; bus_write(bus, a, v); alu_compare(cpu, cpu->a, v); }
+static inline void op_isb(CPU* cpu, Bus* bus, u16 a) { u8 v = bus_read(bus, a) + 1; bus_write(bus, a, v); alu_adc(cpu, (u8)~v); }
+
+// --- Unstable High-Byte Stores (kind H) ---
+// These store 'value & (high byte of base + 1)'. When indexing crosses a page the stored
+// value also replaces the high byte of the target address.
+static inline void cpu_store_high_and(Bus* bus, u16 base, u8 index, u8 value) {
+    u16 addr = base + index;
+    u8 data = value & (u8)((base >> 8) + 1);
+    if ((base ^ addr) & 0xFF00) { addr = (u16)data << 8 | (addr & 0x00FF); }
+    bus_write(bus, addr, data);
+}
+static inline void op_shy(CPU* cpu, Bus* bus, u16 base) { cpu_store_high_and(bus, base, cpu->x, cpu->y); }
+static inline void op_shx(CPU* cpu, Bus* bus, u16 base) { cpu_store_high_and(bus, base, cpu->y, cpu->x); }
+static inline void op_sha(CPU* cpu, Bus* bus, u16 base) { cpu_store_high_and(bus, base, cpu->y, cpu->a & cpu->x); }
+static inline void op_tas(CPU* cpu, Bus* bus, u16 base) { cpu->sp = cpu->a & cpu->x; cpu_store_high_and(bus, base, cpu->y, cpu->sp); }
+
+// --- Implied and Accumulator Instructions (kind I) ---
+static inline void op_asl_a(CPU* cpu, Bus* bus) { (void)bus; cpu->a = alu_asl(cpu, cpu->a); }
+static inline void op_lsr_a(CPU* cpu, Bus* bus) { (void)bus; cpu->a = alu_lsr(cpu, cpu->a); }
+static inline void op_rol_a(CPU* cpu, Bus* bus) { (void)bus; cpu->a = alu_rol(cpu, cpu->a); }
+static inline void op_ror_a(CPU* cpu, Bus* bus) { (void)bus; cpu->a = alu_ror(cpu, cpu->a); }
+static inline void op_tax(CPU* cpu, Bus* bus) { (void)bus; cpu->x = cpu->a; cpu_update_zn_flags(cpu, cpu->x); }
+static inline void op_tay(CPU* cpu, Bus* bus) { (void)bus; cpu->y = cpu->a; cpu_update_zn_flags(cpu, cpu->y); }
+static inline void op_tsx(CPU* cpu, Bus* bus) { (void)bus; cpu->x = cpu->sp; cpu_update_zn_flags(cpu, cpu->x); }
+static inline void op_txa(CPU* cpu, Bus* bus) { (void)bus; cpu->a = cpu->x; cpu_update_zn_flags(cpu, cpu->a); }
+static inline void op_txs(CPU* cpu, Bus* bus) { (void)bus; cpu->sp = cpu->x; }
+static inline void op_tya(CPU* cpu, Bus* bus) { (void)bus; cpu->a = cpu->y; cpu_update_zn_flags(cpu, cpu->a); }
+static inline void op_inx(CPU* cpu, Bus* bus) { (void)bus; cpu->x++; cpu_update_zn_flags(cpu, cpu->x); }
+static inline void op_iny(CPU* cpu, Bus* bus) { (void)bus; cpu->y++; cpu_update_zn_flags(cpu, cpu->y); }
+static inline void op_dex(CPU* cpu, Bus* bus) { (void)bus; cpu->x--; cpu_update_zn_flags(cpu, cpu->x); }
+static inline void op_dey(CPU* cpu, Bus* bus) { (void)bus; cpu->y--; cpu_update_zn_flags(cpu, cpu->y); }
+static inline void op_clc(CPU* cpu, Bus* bus) { (void)bus; cpu->flag_c = 0; }
+static inline void op_cld(CPU* cpu, Bus* bus) { (void)bus; cpu->status &= ~D_FLAG; }
+static inline void op_cli(CPU* cpu, Bus* bus) { (void)bus; cpu->status &= ~I_FLAG; cpu_check_irq(cpu); }
+static inline void op_clv(CPU* cpu, Bus* bus) { (void)bus; cpu->flag_v = 0; }
+static inline void op_sec(CPU* cpu, Bus* bus) { (void)bus; cpu->flag_c = 1; }
+static inline void op_sed(CPU* cpu, Bus* bus) { (void)bus; cpu->status |= D_FLAG; }
+static inline void op_sei(CPU* cpu, Bus* bus) { (void)bus; cpu->status |= I_FLAG; }
+static inline void op_nop(CPU* cpu, Bus* bus) { (void)cpu; (void)bus; }
+static inline void op_pha(CPU* cpu, Bus* bus) { cpu_stack_push(cpu, bus, cpu->a); }
+static inline void op_pla(CPU* cpu, Bus* bus) { cpu->a = cpu_stack_pop(cpu, bus); cpu_update_zn_flags(cpu, cpu->a); }
+static inline void op_php(CPU* cpu, Bus* bus) { cpu_stack_push(cpu, bus, cpu_pack_status(cpu) | B_FLAG | U_FLAG); }
+static inline void op_plp(CPU* cpu, Bus* bus) { cpu_unpack_status(cpu, (cpu_stack_pop(cpu, bus) & ~B_FLAG) | U_FLAG); cpu_check_irq(cpu); }
+static inline void op_rti(CPU* cpu, Bus* bus) { op_plp(cpu, bus); cpu->pc = cpu_stack_pop_word(cpu, bus); }
+static inline void op_rts(CPU* cpu, Bus* bus) { cpu->pc = cpu_stack_pop_word(cpu, bus) + 1; }
+static inline void op_brk(CPU* cpu, Bus* bus) { cpu_stack_push_word(cpu, bus, cpu->pc + 1); op_php(cpu, bus); cpu->status |= I_FLAG; cpu->pc = cpu_read_vector(bus, 0xFFFE); }
+// JAM/KIL locks the real CPU up. Re-executing it forever keeps the clock running.
+static inline void op_jam(CPU* cpu, Bus* bus) { (void)bus; cpu->pc--; }
+
+// --- Branches (kind B) ---
+static inline void cpu_branch(CPU* cpu, bool condition, s8 offset) {
+    if (!condition) { return; }
+    u16 target = cpu->pc + offset;
+    cpu->cycles += ((target ^ cpu->pc) & 0xFF00) ? 2 : 1;
+    cpu->pc = target;
+}
+static inline void op_bcc(CPU* cpu, s8 o) { cpu_branch(cpu, !cpu->flag_c, o); }
+static inline void op_bcs(CPU* cpu, s8 o) { cpu_branch(cpu, cpu->flag_c, o); }
+static inline void op_beq(CPU* cpu, s8 o) { cpu_branch(cpu, cpu_flag_z(cpu), o); }
+static inline void op_bmi(CPU* cpu, s8 o) { cpu_branch(cpu, cpu_flag_n(cpu), o); }
+static inline void op_bne(CPU* cpu, s8 o) { cpu_branch(cpu, !cpu_flag_z(cpu), o); }
+static inline void op_bpl(CPU* cpu, s8 o) { cpu_branch(cpu, !cpu_flag_n(cpu), o); }
+static inline void op_bvc(CPU* cpu, s8 o) { cpu_branch(cpu, !cpu_flag_v(cpu), o); }
+static inline void op_bvs(CPU* cpu, s8 o) { cpu_branch(cpu, cpu_flag_v(cpu), o); }
+
+// --- Handler Generation ---
+// Every opcode in CPU_OPCODE_TABLE becomes one handler with its addressing mode and
+// operation fused. The FETCH macros read the operand bytes that follow the opcode.
+#define FETCH8()  cpu_fetch_byte(cpu, bus)
+#define FETCH16() cpu_fetch_word(cpu, bus)
+
+// Effective address for W-kind instructions (no page-cross penalty).
+#define ADDR_ZP0() ((u16)FETCH8())
+#define ADDR_ZPX() am_zpx(cpu, FETCH8())
+#define ADDR_ZPY() am_zpy(cpu, FETCH8())
+#define ADDR_ABS() FETCH16()
+#define ADDR_ABX() am_abx(cpu, FETCH16(), false)
+#define ADDR_ABY() am_aby(cpu, FETCH16(), false)
+#define ADDR_IND() am_ind(bus, FETCH16())
+#define ADDR_IZX() am_izx(cpu, bus, FETCH8())
+#define ADDR_IZY() am_izy(cpu, bus, FETCH8(), false)
+
+// Operand value for R-kind instructions (indexed reads pay for page crossings).
+#define READ_IMM() FETCH8()
+#define READ_ZP0() bus_read(bus, ADDR_ZP0())
+#define READ_ZPX() bus_read(bus, ADDR_ZPX())
+#define READ_ZPY() bus_read(bus, ADDR_ZPY())
+#define READ_ABS() bus_read(bus, ADDR_ABS())
+#define READ_ABX() bus_read(bus, am_abx(cpu, FETCH16(), true))
+#define READ_ABY() bus_read(bus, am_aby(cpu, FETCH16(), true))
+#define READ_IZX() bus_read(bus, ADDR_IZX())
+#define READ_IZY() bus_read(bus, am_izy(cpu, bus, FETCH8(), true))
+
+// Un-indexed base address for H-kind instructions.
+#define BASE_ABX() FETCH16()
+#define BASE_ABY() FETCH16()
+#define BASE_IZY() cpu_read_word_zp(bus, FETCH8())
+
+#define EXEC_R(op, mode) op_##op(cpu, READ_##mode())
+#define EXEC_W(op, mode) op_##op(cpu, bus, ADDR_##mode())
+#define EXEC_H(op, mode) op_##op(cpu, bus, BASE_##mode())
+#define EXEC_I(op, mode) op_##op(cpu, bus)
+#define EXEC_B(op, mode) op_##op(cpu, (s8)FETCH8())
+
+// Computed goto gives every handler its own indirect jump, which predicts far better than
+// a single shared switch. Other compilers fall back to a plain switch (or build with
+// -DCPU_COMPUTED_GOTO=0 to force it).
+#ifndef CPU_COMPUTED_GOTO
+#if defined(__GNUC__) || defined(__clang__)
+#define CPU_COMPUTED_GOTO 1
+#else
+#define CPU_COMPUTED_GOTO 0
+#endif
+#endif
 
-// --- Instruction Implementations (all now take Bus*) ---
-static void adc(CPU* cpu, Bus* bus, u16 a) { u8 v = bus_read(bus, a); u16 sum = cpu->a + v + cpu_get_flag(cpu, C_FLAG); cpu_set_flag(cpu, C_FLAG, sum > 0xFF); cpu_set_flag(cpu, V_FLAG, (~(cpu->a ^ v) & (cpu->a ^ sum) & 0x80) != 0); cpu->a = (u8)sum; cpu_update_zn_flags(cpu, cpu->a); }
-static void sbc(CPU* cpu, Bus* bus, u16 a) { u8 v = bus_read(bus, a); u16 diff = cpu->a - v - (1 - cpu_get_flag(cpu, C_FLAG)); cpu_set_flag(cpu, C_FLAG, diff < 0x100); cpu_set_flag(cpu, V_FLAG, ((cpu->a ^ v) & (cpu->a ^ diff) & 0x80) != 0); cpu->a = (u8)diff; cpu_update_zn_flags(cpu, cpu->a); }
-static void compare(CPU* cpu, Bus* bus, u8 reg, u16 a) { u8 v = bus_read(bus, a); u8 res = reg - v; cpu_set_flag(cpu, C_FLAG, reg >= v); cpu_update_zn_flags(cpu, res); }
-static void asl(CPU* cpu, Bus* bus, u16 a, AddressingMode m) { u8 v = (m == AM_ACC) ? cpu->a : bus_read(bus, a); cpu_set_flag(cpu, C_FLAG, v & 0x80); v <<= 1; if (m == AM_ACC) cpu->a = v; else bus_write(bus, a, v); cpu_update_zn_flags(cpu, v); }
-static void lsr(CPU* cpu, Bus* bus, u16 a, AddressingMode m) { u8 v = (m == AM_ACC) ? cpu->a : bus_read(bus, a); cpu_set_flag(cpu, C_FLAG, v & 1); v >>= 1; if (m == AM_ACC) cpu->a = v; else bus_write(bus, a, v); cpu_update_zn_flags(cpu, v); }
-static void rol(CPU* cpu, Bus* bus, u16 a, AddressingMode m) { u8 v = (m == AM_ACC) ? cpu->a : bus_read(bus, a); bool old_c = cpu_get_flag(cpu, C_FLAG); cpu_set_flag(cpu, C_FLAG, v & 0x80); v = (v << 1) | old_c; if (m == AM_ACC) cpu->a = v; else bus_write(bus, a, v); cpu_update_zn_flags(cpu, v); }
-static void ror(CPU* cpu, Bus* bus, u16 a, AddressingMode m) { u8 v = (m == AM_ACC) ? cpu->a : bus_read(bus, a); bool old_c = cpu_get_flag(cpu, C_FLAG); cpu_set_flag(cpu, C_FLAG, v & 1); v = (v >> 1) | (old_c << 7); if (m == AM_ACC) cpu->a = v; else bus_write(bus, a, v); cpu_update_zn_flags(cpu, v); }
-static void inc(CPU* cpu, Bus* bus, u16 a) { u8 v = bus_read(bus, a) + 1; bus_write(bus, a, v); cpu_update_zn_flags(cpu, v); }
-static void dec(CPU* cpu, Bus* bus, u16 a) { u8 v = bus_read(bus, a) - 1; bus_write(bus, a, v); cpu_update_zn_flags(cpu, v); }
-static void lda(CPU* cpu, Bus* bus, u16 a) { cpu->a = bus_read(bus, a); cpu_update_zn_flags(cpu, cpu->a); }
-static void ldx(CPU* cpu, Bus* bus, u16 a) { cpu->x = bus_read(bus, a); cpu_update_zn_flags(cpu, cpu->x); }
-static void ldy(CPU* cpu, Bus* bus, u16 a) { cpu->y = bus_read(bus, a); cpu_update_zn_flags(cpu, cpu->y); }
-static void sta(CPU* cpu, Bus* bus, u16 a) { bus_write(bus, a, cpu->a); }
-static void stx(CPU* cpu, Bus* bus, u16 a) { bus_write(bus, a, cpu->x); }
-static void sty(CPU* cpu, Bus* bus, u16 a) { bus_write(bus, a, cpu->y); }
-static void tax(CPU* cpu) { cpu->x = cpu->a; cpu_update_zn_flags(cpu, cpu->x); }
-static void tay(CPU* cpu) { cpu->y = cpu->a; cpu_update_zn_flags(cpu, cpu->y); }
-static void tsx(CPU* cpu) { cpu->x = cpu->sp; cpu_update_zn_flags(cpu, cpu->x); }
-static void txa(CPU* cpu) { cpu->a = cpu->x; cpu_update_zn_flags(cpu, cpu->a); }
-static void txs(CPU* cpu) { cpu->sp = cpu->x; }
-static void tya(CPU* cpu) { cpu->a = cpu->y; cpu_update_zn_flags(cpu, cpu->a); }
-static void inx(CPU* cpu) { cpu->x++; cpu_update_zn_flags(cpu, cpu->x); }
-static void iny(CPU* cpu) { cpu->y++; cpu_update_zn_flags(cpu, cpu->y); }
-static void dex(CPU* cpu) { cpu->x--; cpu_update_zn_flags(cpu, cpu->x); }
-static void dey(CPU* cpu) { cpu->y--; cpu_update_zn_flags(cpu, cpu->y); }
-static void generic_and(CPU* cpu, Bus* bus, u16 a) { cpu->a &= bus_read(bus, a); cpu_update_zn_flags(cpu, cpu->a); }
-static void generic_eor(CPU* cpu, Bus* bus, u16 a) { cpu->a ^= bus_read(bus, a); cpu_update_zn_flags(cpu, cpu->a); }
-static void generic_ora(CPU* cpu, Bus* bus, u16 a) { cpu->a |= bus_read(bus, a); cpu_update_zn_flags(cpu, cpu->a); }
-static void bit(CPU* cpu, Bus* bus, u16 a) { u8 v = bus_read(bus, a); cpu_set_flag(cpu, Z_FLAG, (v & cpu->a) == 0); cpu_set_flag(cpu, N_FLAG, v & 0x80); cpu_set_flag(cpu, V_FLAG, v & 0x40); }
-static void jmp(CPU* cpu, u16 a) { cpu->pc = a; }
-static void jsr(CPU* cpu, Bus* bus, u16 a) { cpu_stack_push_word(cpu, bus, cpu->pc - 1); cpu->pc = a; }
-static void rts(CPU* cpu, Bus* bus) { cpu->pc = cpu_stack_pop_word(cpu, bus) + 1; }
-static void rti(CPU* cpu, Bus* bus) { cpu->status = cpu_stack_pop(cpu, bus) | U_FLAG; cpu->pc = cpu_stack_pop_word(cpu, bus); }
-static void pha(CPU* cpu, Bus* bus) { cpu_stack_push(cpu, bus, cpu->a); }
-static void pla(CPU* cpu, Bus* bus) { cpu->a = cpu_stack_pop(cpu, bus); cpu_update_zn_flags(cpu, cpu->a); }
-static void php(CPU* cpu, Bus* bus) { cpu_stack_push(cpu, bus, cpu->status | B_FLAG); }
-static void plp(CPU* cpu, Bus* bus) { cpu->status = cpu_stack_pop(cpu, bus) | U_FLAG; }
-static void nop(void) {}
-static void brk(CPU* cpu, Bus* bus) { cpu_stack_push_word(cpu, bus, cpu->pc); cpu_stack_push(cpu, bus, cpu->status | B_FLAG); cpu_set_flag(cpu, I_FLAG, true); u8 lo = bus_read(bus, 0xFFFE); u8 hi = bus_read(bus, 0xFFFF); cpu->pc = (u16)hi << 8 | (u16)lo; }
-static void clc(CPU* cpu) { cpu_set_flag(cpu, C_FLAG, false); }
-static void cld(CPU* cpu) { cpu_set_flag(cpu, D_FLAG, false); }
-static void cli(CPU* cpu) { cpu_set_flag(cpu, I_FLAG, false); }
-static void clv(CPU* cpu) { cpu_set_flag(cpu, V_FLAG, false); }
-static void sec(CPU* cpu) { cpu_set_flag(cpu, C_FLAG, true); }
-static void sed(CPU* cpu) { cpu_set_flag(cpu, D_FLAG, true); }
-static void sei(CPU* cpu) { cpu_set_flag(cpu, I_FLAG, true); }
-static void cmp(CPU* cpu, Bus* bus, u16 a) { compare(cpu, bus, cpu->a, a); }
-static void cpx(CPU* cpu, Bus* bus, u16 a) { compare(cpu, bus, cpu->x, a); }
-static void cpy(CPU* cpu, Bus* bus, u16 a) { compare(cpu, bus, cpu->y, a); }
-static void branch(CPU* cpu, Bus* bus, bool condition) { if (condition) { s8 offset = (s8)cpu_fetch_byte(cpu, bus); cpu->pc += offset; } else { cpu_fetch_byte(cpu, bus); } }
-static void bcc(CPU* cpu, Bus* bus) { branch(cpu, bus, !cpu_get_flag(cpu, C_FLAG)); }
-static void bcs(CPU* cpu, Bus* bus) { branch(cpu, bus, cpu_get_flag(cpu, C_FLAG)); }
-static void beq(CPU* cpu, Bus* bus) { branch(cpu, bus, cpu_get_flag(cpu, Z_FLAG)); }
-static void bmi(CPU* cpu, Bus* bus) { branch(cpu, bus, cpu_get_flag(cpu, N_FLAG)); }
-static void bne(CPU* cpu, Bus* bus) { branch(cpu, bus, !cpu_get_flag(cpu, Z_FLAG)); }
-static void bpl(CPU* cpu, Bus* bus) { branch(cpu, bus, !cpu_get_flag(cpu, N_FLAG)); }
-static void bvc(CPU* cpu, Bus* bus) { branch(cpu, bus, !cpu_get_flag(cpu, V_FLAG)); }
-static void bvs(CPU* cpu, Bus* bus) { branch(cpu, bus, cpu_get_flag(cpu, V_FLAG)); }
-static void xxx(void) {}
-
-// --- Lookup Table & Core Functions ---
-typedef struct { void (*execute)(); AddressingMode mode; } OpcodeHandler;
-static OpcodeHandler instruction_table[256];
-
-void cpu_power_up(void) {
-    OpcodeHandler* table = instruction_table;
-    for(int i=0; i<256; ++i) table[i] = (OpcodeHandler){xxx, AM_IMP};
-    #define OP(op, ex, am) instruction_table[op] = (OpcodeHandler){(void (*)())ex, am}
-    OP(0x69, adc, AM_IMM); OP(0x65, adc, AM_ZP0); OP(0x75, adc, AM_ZPX); OP(0x6D, adc, AM_ABS); OP(0x7D, adc, AM_ABX); OP(0x79, adc, AM_ABY); OP(0x61, adc, AM_IZX); OP(0x71, adc, AM_IZY);
-    OP(0x29, generic_and, AM_IMM); OP(0x25, generic_and, AM_ZP0); OP(0x35, generic_and, AM_ZPX); OP(0x2D, generic_and, AM_ABS); OP(0x3D, generic_and, AM_ABX); OP(0x39, generic_and, AM_ABY); OP(0x21, generic_and, AM_IZX); OP(0x31, generic_and, AM_IZY);
-    OP(0x0A, asl, AM_ACC); OP(0x06, asl, AM_ZP0); OP(0x16, asl, AM_ZPX); OP(0x0E, asl, AM_ABS); OP(0x1E, asl, AM_ABX);
-    OP(0x90, bcc, AM_REL); OP(0xB0, bcs, AM_REL); OP(0xF0, beq, AM_REL);
-    OP(0x24, bit, AM_ZP0); OP(0x2C, bit, AM_ABS);
-    OP(0x30, bmi, AM_REL); OP(0xD0, bne, AM_REL); OP(0x10, bpl, AM_REL);
-    OP(0x00, brk, AM_IMP);
-    OP(0x50, bvc, AM_REL); OP(0x70, bvs, AM_REL);
-    OP(0x18, clc, AM_IMP); OP(0xD8, cld, AM_IMP); OP(0x58, cli, AM_IMP); OP(0xB8, clv, AM_IMP);
-    OP(0xC9, cmp, AM_IMM); OP(0xC5, cmp, AM_ZP0); OP(0xD5, cmp, AM_ZPX); OP(0xCD, cmp, AM_ABS); OP(0xDD, cmp, AM_ABX); OP(0xD9, cmp, AM_ABY); OP(0xC1, cmp, AM_IZX); OP(0xD1, cmp, AM_IZY);
-    OP(0xE0, cpx, AM_IMM); OP(0xE4, cpx, AM_ZP0); OP(0xEC, cpx, AM_ABS);
-    OP(0xC0, cpy, AM_IMM); OP(0xC4, cpy, AM_ZP0); OP(0xCC, cpy, AM_ABS);
-    OP(0xC6, dec, AM_ZP0); OP(0xD6, dec, AM_ZPX); OP(0xCE, dec, AM_ABS); OP(0xDE, dec, AM_ABX);
-    OP(0xCA, dex, AM_IMP); OP(0x88, dey, AM_IMP);
-    OP(0x49, generic_eor, AM_IMM); OP(0x45, generic_eor, AM_ZP0); OP(0x55, generic_eor, AM_ZPX); OP(0x4D, generic_eor, AM_ABS); OP(0x5D, generic_eor, AM_ABX); OP(0x59, generic_eor, AM_ABY); OP(0x41, generic_eor, AM_IZX); OP(0x51, generic_eor, AM_IZY);
-    OP(0xE6, inc, AM_ZP0); OP(0xF6, inc, AM_ZPX); OP(0xEE, inc, AM_ABS); OP(0xFE, inc, AM_ABX);
-    OP(0xE8, inx, AM_IMP); OP(0xC8, iny, AM_IMP);
-    OP(0x4C, jmp, AM_ABS); OP(0x6C, jmp, AM_IND);
-    OP(0x20, jsr, AM_ABS);
-    OP(0xA9, lda, AM_IMM); OP(0xA5, lda, AM_ZP0); OP(0xB5, lda, AM_ZPX); OP(0xAD, lda, AM_ABS); OP(0xBD, lda, AM_ABX); OP(0xB9, lda, AM_ABY); OP(0xA1, lda, AM_IZX); OP(0xB1, lda, AM_IZY);
-    OP(0xA2, ldx, AM_IMM); OP(0xA6, ldx, AM_ZP0); OP(0xB6, ldx, AM_ZPY); OP(0xAE, ldx, AM_ABS); OP(0xBE, ldx, AM_ABY);
-    OP(0xA0, ldy, AM_IMM); OP(0xA4, ldy, AM_ZP0); OP(0xB4, ldy, AM_ZPY); OP(0xAC, ldy, AM_ABS); OP(0xBC, ldy, AM_ABY);
-    OP(0x4A, lsr, AM_ACC); OP(0x46, lsr, AM_ZP0); OP(0x56, lsr, AM_ZPX); OP(0x4E, lsr, AM_ABS); OP(0x5E, lsr, AM_ABX);
-    OP(0xEA, nop, AM_IMP);
-    OP(0x09, generic_ora, AM_IMM); OP(0x05, generic_ora, AM_ZP0); OP(0x15, generic_ora, AM_ZPX); OP(0x0D, generic_ora, AM_ABS); OP(0x1D, generic_ora, AM_ABX); OP(0x19, generic_ora, AM_ABY); OP(0x01, generic_ora, AM_IZX); OP(0x11, generic_ora, AM_IZY);
-    OP(0x48, pha, AM_IMP); OP(0x08, php, AM_IMP); OP(0x68, pla, AM_IMP); OP(0x28, plp, AM_IMP);
-    OP(0x2A, rol, AM_ACC); OP(0x26, rol, AM_ZP0); OP(0x36, rol, AM_ZPX); OP(0x2E, rol, AM_ABS); OP(0x3E, rol, AM_ABX);
-    OP(0x6A, ror, AM_ACC); OP(0x66, ror, AM_ZP0); OP(0x76, ror, AM_ZPX); OP(0x6E, ror, AM_ABS); OP(0x7E, ror, AM_ABX);
-    OP(0x40, rti, AM_IMP); OP(0x60, rts, AM_IMP);
-    OP(0xE9, sbc, AM_IMM); OP(0xE5, sbc, AM_ZP0); OP(0xF5, sbc, AM_ZPX); OP(0xED, sbc, AM_ABS); OP(0xFD, sbc, AM_ABX); OP(0xF9, sbc, AM_ABY); OP(0xE1, sbc, AM_IZX); OP(0xF1, sbc, AM_IZY);
-    OP(0x38, sec, AM_IMP); OP(0xF8, sed, AM_IMP); OP(0x78, sei, AM_IMP);
-    OP(0x85, sta, AM_ZP0); OP(0x95, sta, AM_ZPX); OP(0x8D, sta, AM_ABS); OP(0x9D, sta, AM_ABX); OP(0x99, sta, AM_ABY); OP(0x81, sta, AM_IZX); OP(0x91, sta, AM_IZY);
-    OP(0x86, stx, AM_ZP0); OP(0x96, stx, AM_ZPY); OP(0x8E, stx, AM_ABS);
-    OP(0x84, sty, AM_ZP0); OP(0x94, sty, AM_ZPX); OP(0x8C, sty, AM_ABS);
-    OP(0xAA, tax, AM_IMP); OP(0xA8, tay, AM_IMP); OP(0xBA, tsx, AM_IMP); OP(0x8A, txa, AM_IMP); OP(0x9A, txs, AM_IMP); OP(0x98, tya, AM_IMP);
-}
-
-void cpu_init(CPU* cpu) { memset(cpu, 0, sizeof(CPU)); }
-void cpu_reset(CPU* cpu, Bus* bus) { cpu->a = 0; cpu->x = 0; cpu->y = 0; cpu->sp = 0xFD; cpu->status = U_FLAG | I_FLAG; u8 lo = bus_read(bus, 0xFFFC); u8 hi = bus_read(bus, 0xFFFF); cpu->pc = (u16)hi << 8 | (u16)lo; cpu->cycles = 0; }
-
-void cpu_step(CPU* cpu, Bus* bus) {
-    u8 opcode = cpu_fetch_byte(cpu, bus);
-    OpcodeHandler handler = instruction_table[opcode];
-    u16 address = 0;
-    if (handler.mode != AM_IMP && handler.mode != AM_ACC) {
-        address = get_operand_address(cpu, bus, handler.mode);
+// --- Tracing ---
+#if CPU_TRACE
+// Logs the instruction about to run at PC. Instruction bytes are peeked through the page
+// table (never through I/O, which could have side effects).
+static void cpu_trace(CPU* cpu, Bus* bus) {
+    TraceRecord* r = trace_next(cpu->trace);
+    r->cycle = cpu->cycles;
+    r->pc = cpu->pc;
+    for (u16 i = 0; i < 3; ++i) {
+        u16 address = cpu->pc + i;
+        const u8* page = bus->read_pages[address >> BUS_PAGE_SHIFT];
+        r->bytes[i] = page ? page[address & (BUS_PAGE_SIZE - 1)] : 0;
     }
+    r->a = cpu->a;
+    r->x = cpu->x;
+    r->y = cpu->y;
+    r->p = cpu_pack_status(cpu);
+    r->sp = cpu->sp;
+    ppu_position_at(bus->ppu, cpu->cycles, &r->scanline, &r->dot);
+}
+#define CPU_TRACE_HOOK() do { if (cpu->trace) { cpu_trace(cpu, bus); } } while (0)
+
+void cpu_set_trace(CPU* cpu, Trace* trace) {
+    cpu->trace = trace;
+    if (trace) { cpu_set_idle_skip(cpu, false); }
+}
+#else
+#define CPU_TRACE_HOOK() ((void)0)
+
+void cpu_set_trace(CPU* cpu, Trace* trace) { (void)cpu; (void)trace; }
+#endif
+
+#if MYNES_PROFILE
+// Every dispatch loop snapshots PC and the cycle count before an instruction and charges the
+// difference (penalties and DMA stalls included) to its opcode and PC afterwards.
+#define CPU_PROFILE_LOCALS() u16 profile_pc = 0; u64 profile_cycles = 0
+#define CPU_PROFILE_BEGIN() (profile_pc = cpu->pc, profile_cycles = cpu->cycles)
+#define CPU_PROFILE_END(code) profile_instruction(code, profile_pc, cpu->cycles - profile_cycles)
+#else
+#define CPU_PROFILE_LOCALS() ((void)0)
+#define CPU_PROFILE_BEGIN() ((void)0)
+#define CPU_PROFILE_END(code) ((void)0)
+#endif
+
+// Runs instructions until cpu->cycles reaches *until. The deadline is re-read after every
+// instruction because I/O writes can move it. At least one instruction always executes.
+static void cpu_dispatch(CPU* cpu, Bus* bus, const u64* until) {
+    u8 opcode;
+    CPU_PROFILE_LOCALS();
+#if CPU_COMPUTED_GOTO
+    #define CPU_LABEL_ADDR(code, kind, op, mode, cyc) &&opcode_##code,
+    static const void* const dispatch_table[256] = { CPU_OPCODE_TABLE(CPU_LABEL_ADDR) };
+    #undef CPU_LABEL_ADDR
+    #define CPU_DISPATCH() do { CPU_TRACE_HOOK(); CPU_PROFILE_BEGIN(); opcode = FETCH8(); cpu->instructions++; goto *dispatch_table[opcode]; } while (0)
+    #define CPU_NEXT() do { if (cpu->cycles >= *until) return; CPU_DISPATCH(); } while (0)
+    #define CPU_HANDLER(code, kind, op, mode, cyc) \
+        opcode_##code: EXEC_##kind(op, mode); cpu->cycles += cyc; CPU_PROFILE_END(code); CPU_NEXT();
+
+    CPU_DISPATCH();
+    CPU_OPCODE_TABLE(CPU_HANDLER)
+#else
+    #define CPU_NEXT() break
+    #define CPU_HANDLER(code, kind, op, mode, cyc) \
+        case code: EXEC_##kind(op, mode); cpu->cycles += cyc; CPU_PROFILE_END(code); CPU_NEXT();
+
+    do {
+        CPU_TRACE_HOOK();
+        CPU_PROFILE_BEGIN();
+        opcode = FETCH8();
+        cpu->instructions++;
+        switch (opcode) {
+            CPU_OPCODE_TABLE(CPU_HANDLER)
+        }
+    } while (cpu->cycles < *until);
+#endif
+    #undef CPU_HANDLER
+    #undef CPU_NEXT
+    #undef CPU_DISPATCH
+}
 
-    // This is a simplified way to call functions with different signatures.
-    // A more robust system might use a union or more complex wrappers.
-    // This part is complex and relies on knowing the function signatures.
-    // We will simplify this in the next step.
+// --- Decoded Blocks ---
+#if CPU_BLOCK_CACHE
+#define CPU_MODE_LENGTH_IMP 1
+#define CPU_MODE_LENGTH_ACC 1
+#define CPU_MODE_LENGTH_IMM 2
+#define CPU_MODE_LENGTH_ZP0 2
+#define CPU_MODE_LENGTH_ZPX 2
+#define CPU_MODE_LENGTH_ZPY 2
+#define CPU_MODE_LENGTH_REL 2
+#define CPU_MODE_LENGTH_IZX 2
+#define CPU_MODE_LENGTH_IZY 2
+#define CPU_MODE_LENGTH_ABS 3
+#define CPU_MODE_LENGTH_ABX 3
+#define CPU_MODE_LENGTH_ABY 3
+#define CPU_MODE_LENGTH_IND 3
+#define CPU_LENGTH(code, kind, op, mode, cyc) CPU_MODE_LENGTH_##mode,
+static const u8 cpu_op_length[256] = { CPU_OPCODE_TABLE(CPU_LENGTH) };
+#undef CPU_LENGTH
+
+typedef enum { CPU_KIND_R, CPU_KIND_W, CPU_KIND_H, CPU_KIND_I, CPU_KIND_B } CpuOpKind;
+#define CPU_KIND(code, kind, op, mode, cyc) CPU_KIND_##kind,
+static const u8 cpu_op_kind[256] = { CPU_OPCODE_TABLE(CPU_KIND) };
+#undef CPU_KIND
+#define CPU_MODE(code, kind, op, mode, cyc) AM_##mode,
+static const u8 cpu_op_mode[256] = { CPU_OPCODE_TABLE(CPU_MODE) };
+#undef CPU_MODE
+
+// Instructions that can move PC anywhere but to the next instruction end a block.
+static inline bool cpu_ends_block(u8 opcode) {
     switch (opcode) {
-        // Cases for functions with specific signatures
-        case 0x90: case 0xB0: case 0xF0: case 0x30: case 0xD0: case 0x10: case 0x50: case 0x70:
-            ((void (*)(CPU*, Bus*))handler.execute)(cpu, bus);
-            break;
-        case 0x18: case 0xD8: case 0x58: case 0xB8: case 0x38: case 0xF8: case 0x78:
-        case 0xCA: case 0x88: case 0xE8: case 0xC8: case 0xAA: case 0xA8: case 0xBA:
-        case 0x8A: case 0x9A: case 0x98: case 0x48: case 0x08: case 0x68: case 0x28:
-        case 0x40: case 0x60: case 0x00: case 0xEA:
-            ((void (*)(CPU*))handler.execute)(cpu);
-            break;
+        case 0x00: case 0x20: case 0x40: case 0x4C: case 0x60: case 0x6C: return true; // BRK JSR RTI JMP RTS JMP
         default:
-            ((void (*)(CPU*, Bus*, u16))handler.execute)(cpu, bus, address);
+            if ((opcode & 0x1F) == 0x10) { return true; } // Branches
+            // JAM: $x2 except the two-byte NOPs $82, $A2 (LDX #), $C2 and $E2.
+            return (opcode & 0x0F) == 0x02 && opcode != 0x82 && opcode != 0xA2 && opcode != 0xC2 && opcode != 0xE2;
+    }
+}
+
+static inline u32 cpu_block_slot(u16 pc) { return (pc ^ (pc >> 11)) & (CPU_BLOCK_CACHE_SIZE - 1); }
+
+// Decodes the run of instructions starting at PC from the host memory mapped there. Returns
+// NULL if PC is not in directly mapped memory (I/O, open bus) or its first instruction
+// straddles the end of the page; the interpreter handles those.
+static CpuBlock* cpu_decode_block(CPU* cpu, Bus* bus, CpuBlock* block) {
+    u32 page_index = cpu->pc >> BUS_PAGE_SHIFT;
+    const u8* page = bus->read_pages[page_index];
+    if (!page || !bus_code_cacheable(bus, page_index)) { return NULL; }
+    u32 offset = cpu->pc & (BUS_PAGE_SIZE - 1);
+    u8 count = 0;
+    while (count < CPU_BLOCK_MAX_OPS) {
+        u8 opcode = page[offset];
+        u8 length = cpu_op_length[opcode];
+        if (offset + length > BUS_PAGE_SIZE) { break; }
+        CpuOp* op = &block->ops[count++];
+        op->opcode = opcode;
+        op->length = length;
+        op->operand = (length == 1) ? 0 : (length == 2) ? page[offset + 1] : (u16)(page[offset + 1] | page[offset + 2] << 8);
+        offset += length;
+        if (cpu_ends_block(opcode) || offset == BUS_PAGE_SIZE) { break; }
+    }
+    if (count == 0) { return NULL; }
+    block->page = page;
+    block->pc = cpu->pc;
+    block->count = count;
+    const CpuOp* last = &block->ops[count - 1];
+    u16 next_pc = (u16)(cpu->pc + offset - (cpu->pc & (BUS_PAGE_SIZE - 1)));
+    block->loops = ((last->opcode & 0x1F) == 0x10 && (u16)(next_pc + (s8)last->operand) == cpu->pc) ||
+                   (last->opcode == 0x4C && last->operand == cpu->pc);
+    bus_track_code_page(bus, page_index);
+    cpu->block_cache.misses++;
+    return block;
+}
+
+static inline CpuBlock* cpu_find_block(CPU* cpu, Bus* bus) {
+    CpuBlock* block = &cpu->block_cache.blocks[cpu_block_slot(cpu->pc)];
+    if (block->pc == cpu->pc && block->page == bus->read_pages[cpu->pc >> BUS_PAGE_SHIFT] && block->page) {
+        cpu->block_cache.hits++;
+        return block;
+    }
+    return cpu_decode_block(cpu, bus, block);
+}
+
+void cpu_invalidate_blocks(CPU* cpu, const u8* page) {
+    for (u32 i = 0; i < CPU_BLOCK_CACHE_SIZE; ++i) {
+        CpuBlock* block = &cpu->block_cache.blocks[i];
+        if (block->page && (!page || block->page == page)) { block->page = NULL; }
+    }
+    cpu->block_cache.invalidations++;
+}
+
+void cpu_set_block_cache(CPU* cpu, bool enabled) { cpu->block_cache.enabled = enabled; }
+void cpu_set_idle_skip(CPU* cpu, bool enabled) { cpu->idle.enabled = enabled; cpu->idle.block = NULL; }
+
+// --- Idle Loops ---
+// Checks that the body of a looping block (everything but the closing branch or JMP) cannot
+// change anything but registers, and that whatever it reads only changes when the CPU writes
+// it or on a PPUSTATUS change. Sets *polls_ppu if it reads $2002.
+static bool cpu_idle_body(const Bus* bus, const CpuBlock* block, bool* polls_ppu) {
+    *polls_ppu = false;
+    for (u32 i = 0; i + 1 < block->count; ++i) {
+        const CpuOp* op = &block->ops[i];
+        switch (cpu_op_kind[op->opcode]) {
+            case CPU_KIND_I:
+                switch (op->opcode) {
+                    case 0x08: case 0x28: case 0x48: case 0x58: case 0x68: return false; // PHP PLP PHA CLI PLA
+                    default: break;
+                }
+                break;
+            case CPU_KIND_R:
+                if (cpu_op_mode[op->opcode] == AM_IMM) { break; }
+                if (cpu_op_mode[op->opcode] != AM_ZP0 && cpu_op_mode[op->opcode] != AM_ABS) { return false; }
+                if ((op->operand & 0xE007) == 0x2002) { *polls_ppu = true; break; }
+                if (!bus->read_pages[op->operand >> BUS_PAGE_SHIFT]) { return false; }
+                break;
+            default:
+                return false;
+        }
+    }
+    return true;
+}
+
+// Called on entering a looping block. The first entry only records the machine state. If the
+// next entry follows exactly one pass through the block, within the same cpu_run() (so no
+// interrupt or DMA stall came in between), and left every register unchanged, the loop is
+// spinning: the iterations that would finish before the deadline, or before PPUSTATUS can
+// change, are accounted for in one step. They end strictly before that point, so the
+// interpreter resumes exactly where a full run would be and still reads a changed value on
+// its exact cycle.
+static void cpu_idle_check(CPU* cpu, Bus* bus, const CpuBlock* block, u64 until) {
+    CpuIdleSkip* idle = &cpu->idle;
+    u8 status = cpu_pack_status(cpu);
+    u64 period = cpu->cycles - idle->cycles;
+    bool repeat = idle->block == block && cpu->instructions - idle->instructions == block->count &&
+                  idle->a == cpu->a && idle->x == cpu->x && idle->y == cpu->y && idle->sp == cpu->sp && idle->status == status;
+    bool polls_ppu;
+    if (repeat && cpu_idle_body(bus, block, &polls_ppu)) {
+        u64 horizon = until;
+        if (polls_ppu) {
+            u64 ppu_change = ppu_status_stable_until(bus->ppu);
+            if (ppu_change < horizon) { horizon = ppu_change; }
+        }
+        if (horizon > cpu->cycles + period) {
+            u64 loops = (horizon - cpu->cycles - 1) / period;
+            cpu->cycles += loops * period;
+            cpu->instructions += loops * block->count;
+            idle->skips++;
+            idle->skipped_cycles += loops * period;
+            idle->skipped_instructions += loops * block->count;
+            PROFILE_IDLE(loops * period);
+        }
+    }
+    idle->block = block;
+    idle->a = cpu->a;
+    idle->x = cpu->x;
+    idle->y = cpu->y;
+    idle->sp = cpu->sp;
+    idle->status = status;
+    idle->cycles = cpu->cycles;
+    idle->instructions = cpu->instructions;
+}
+
+// The same handlers as cpu_dispatch(), with the instruction bytes taken from the decoded op
+// instead of fetched through the bus. PC is advanced past the instruction before it runs, so
+// branches, JSR and BRK see the same PC as in the interpreter.
+#undef FETCH8
+#undef FETCH16
+#define FETCH8()  ((u8)o->operand)
+#define FETCH16() (o->operand)
+
+static void cpu_run_blocks(CPU* cpu, Bus* bus, const u64* until) {
+    static const u64 single_step = 0;
+    const CpuOp* o;
+    const CpuOp* end;
+    CPU_PROFILE_LOCALS();
+    cpu->idle.block = NULL; // Events ran since the last call: start watching afresh
+#if CPU_COMPUTED_GOTO
+    #define CPU_LABEL_ADDR(code, kind, op, mode, cyc) &&block_##code,
+    static const void* const block_table[256] = { CPU_OPCODE_TABLE(CPU_LABEL_ADDR) };
+    #undef CPU_LABEL_ADDR
+    #define CPU_DISPATCH() do { CPU_TRACE_HOOK(); CPU_PROFILE_BEGIN(); cpu->pc += o->length; cpu->instructions++; goto *block_table[o->opcode]; } while (0)
+    #define CPU_NEXT() do { if (cpu->cycles >= *until) return; if (++o == end || cpu->block_cache.exit) goto next_block; CPU_DISPATCH(); } while (0)
+    #define CPU_HANDLER(code, kind, op, mode, cyc) \
+        block_##code: EXEC_##kind(op, mode); cpu->cycles += cyc; CPU_PROFILE_END(code); CPU_NEXT();
+
+next_block:
+    for (;;) {
+        CpuBlock* block = cpu_find_block(cpu, bus);
+        if (block) {
+            if (block->loops && cpu->idle.enabled) { cpu_idle_check(cpu, bus, block, *until); }
+            o = block->ops;
+            end = o + block->count;
             break;
+        }
+        cpu_dispatch(cpu, bus, &single_step);
+        if (cpu->cycles >= *until) { return; }
+    }
+    cpu->block_cache.exit = false;
+    CPU_DISPATCH();
+    CPU_OPCODE_TABLE(CPU_HANDLER)
+#else
+    #define CPU_HANDLER(code, kind, op, mode, cyc) \
+        case code: EXEC_##kind(op, mode); cpu->cycles += cyc; CPU_PROFILE_END(code); break;
+
+    for (;;) {
+        CpuBlock* block = cpu_find_block(cpu, bus);
+        if (!block) {
+            cpu_dispatch(cpu, bus, &single_step);
+            if (cpu->cycles >= *until) { return; }
+            continue;
+        }
+        if (block->loops && cpu->idle.enabled) { cpu_idle_check(cpu, bus, block, *until); }
+        cpu->block_cache.exit = false;
+        for (o = block->ops, end = o + block->count; o != end; ++o) {
+            CPU_TRACE_HOOK();
+            CPU_PROFILE_BEGIN();
+            cpu->pc += o->length;
+            cpu->instructions++;
+            switch (o->opcode) {
+                CPU_OPCODE_TABLE(CPU_HANDLER)
+            }
+            if (cpu->cycles >= *until) { return; }
+            if (cpu->block_cache.exit) { break; }
+        }
     }
+#endif
+    #undef CPU_HANDLER
+    #undef CPU_NEXT
+    #undef CPU_DISPATCH
+}
+
+#undef FETCH8
+#undef FETCH16
+#define FETCH8()  cpu_fetch_byte(cpu, bus)
+#define FETCH16() cpu_fetch_word(cpu, bus)
+
+static inline void cpu_execute(CPU* cpu, Bus* bus, const u64* until) {
+    if (cpu->block_cache.enabled) { cpu_run_blocks(cpu, bus, until); }
+    else { cpu_dispatch(cpu, bus, until); }
+}
+#else
+void cpu_invalidate_blocks(CPU* cpu, const u8* page) { (void)cpu; (void)page; }
+void cpu_set_block_cache(CPU* cpu, bool enabled) { (void)cpu; (void)enabled; }
+void cpu_set_idle_skip(CPU* cpu, bool enabled) { (void)cpu; (void)enabled; }
+static inline void cpu_execute(CPU* cpu, Bus* bus, const u64* until) { cpu_dispatch(cpu, bus, until); }
+#endif
+
+// --- Core Functions ---
+u8 cpu_get_status(const CPU* cpu) { return cpu_pack_status(cpu); }
+void cpu_set_status(CPU* cpu, u8 status) { cpu_unpack_status(cpu, status); }
+
+void cpu_init(CPU* cpu) {
+    memset(cpu, 0, sizeof(CPU));
+#if CPU_BLOCK_CACHE
+    cpu->block_cache.enabled = true;
+    cpu->idle.enabled = true;
+#endif
+}
+void cpu_reset(CPU* cpu, Bus* bus) { cpu->a = 0; cpu->x = 0; cpu->y = 0; cpu->sp = 0xFD; cpu_unpack_status(cpu, U_FLAG | I_FLAG); cpu->pc = cpu_read_vector(bus, 0xFFFC); cpu->cycles = 7; cpu->irq_lines = 0; }
+
+void cpu_step(CPU* cpu, Bus* bus) { static const u64 single_step = 0; cpu_execute(cpu, bus, &single_step); }
+void cpu_run(CPU* cpu, Bus* bus) { if (cpu->cycles < cpu->deadline) cpu_execute(cpu, bus, &cpu->deadline); }
+
+// --- Interrupts ---
+static void cpu_interrupt(CPU* cpu, Bus* bus, u16 vector) {
+    cpu_stack_push_word(cpu, bus, cpu->pc);
+    cpu_stack_push(cpu, bus, (cpu_pack_status(cpu) & ~B_FLAG) | U_FLAG);
+    cpu->status |= I_FLAG;
+    cpu->pc = cpu_read_vector(bus, vector);
+    cpu->cycles += 7;
+}
+
+void cpu_nmi(CPU* cpu, Bus* bus) { cpu_interrupt(cpu, bus, 0xFFFA); }
+
+void cpu_set_irq(CPU* cpu, IrqSource source, bool asserted) {
+    if (asserted) { cpu->irq_lines |= source; cpu_check_irq(cpu); }
+    else { cpu->irq_lines &= ~source; }
+}
+
+bool cpu_poll_irq(CPU* cpu, Bus* bus) {
+    if (!cpu->irq_lines || (cpu->status & I_FLAG)) { return false; }
+    cpu_interrupt(cpu, bus, 0xFFFE);
+    return true;
 }
\ No newline at end of file
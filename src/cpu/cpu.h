@@ -2,6 +2,7 @@
 #define MYNES_C_CPU_H
 
 #include "common/types.h"
+#include "trace/trace.h"
 
 // Forward declare Bus. CPU functions will receive it as a parameter.
 typedef struct Bus Bus;
@@ -12,16 +13,97 @@ typedef enum {
     AM_REL, AM_ABS, AM_ABX, AM_ABY, AM_IND, AM_IZX, AM_IZY,
 } AddressingMode;
 
+// --- Decoded Block Cache ---
+// Straight-line runs of instructions are decoded once into micro-ops (opcode, length and
+// operand already fetched) and replayed without going through the bus for instruction bytes.
+// A block never crosses a 256-byte page and ends at the first branch, jump, return, BRK or
+// JAM. Blocks are keyed by (page, PC), where 'page' is the host memory mapped at PC: a bank
+// switch maps different memory, so the old bank's blocks stop matching without a flush (and
+// match again, still valid, if it is switched back). Code decoded from RAM is write-tracked
+// by the bus, which drops the page's blocks on the first write into it.
+// Build with -DCPU_BLOCK_CACHE=0 to always interpret.
+#ifndef CPU_BLOCK_CACHE
+#define CPU_BLOCK_CACHE 1
+#endif
+#define CPU_BLOCK_MAX_OPS 12
+#define CPU_BLOCK_CACHE_SIZE 2048 // Direct-mapped, power of two
+
+typedef struct CpuOp {
+    u8 opcode;
+    u8 length;  // Instruction bytes, added to PC before the operation runs
+    u16 operand;
+} CpuOp;
+
+typedef struct CpuBlock {
+    const u8* page; // Host memory of the block's page, NULL for an empty slot
+    u16 pc;
+    u8 count;
+    bool loops;     // The last instruction branches or jumps back to 'pc'
+    CpuOp ops[CPU_BLOCK_MAX_OPS];
+} CpuBlock;
+
+typedef struct CpuBlockCache {
+    bool enabled;
+    bool exit;       // Set by I/O writes: leave the running block after this instruction
+    u64 hits;
+    u64 misses;      // Lookups that decoded a new block
+    u64 invalidations;
+    CpuBlock blocks[CPU_BLOCK_CACHE_SIZE];
+} CpuBlockCache;
+
+// --- Idle Loop Skipping ---
+// A block that loops onto itself, only reads memory nothing but the CPU can change (RAM,
+// ROM, PRG RAM) or PPUSTATUS, and leaves every register as it found it, is a spin-wait:
+// until an event fires or $2002 changes, each iteration is an exact repeat of the last.
+// Once one full iteration has been seen to be such a fixed point, the CPU adds whole
+// iterations' worth of cycles and instructions up to just before the next change, and
+// resumes interpreting. The result is identical to running every iteration.
+typedef struct CpuIdleSkip {
+    bool enabled;
+    const CpuBlock* block; // Loop block entered last, NULL when nothing is being watched
+    u8 a, x, y, sp, status;
+    u64 cycles;            // Machine state at that entry
+    u64 instructions;
+    u64 skips;             // Fast-forwards taken
+    u64 skipped_cycles;
+    u64 skipped_instructions;
+} CpuIdleSkip;
+
 // --- 6502 CPU Structure ---
 typedef struct CPU {
     u8 a, x, y;
     u16 pc;
     u8 sp;
-    u8 status;
-    u32 cycles;
+    u8 status;    // I and D (and B/U as last loaded); read the full byte with cpu_get_status()
+    // --- Lazy Flags ---
+    // Most instructions overwrite N and Z (and often C) before anything looks at them, so
+    // they store their result instead of updating 'status' bit by bit. The byte is only
+    // put together when something needs it: PHP, BRK, interrupts, save states, tracing.
+    u16 flag_nz;  // Z while the low byte is zero; N while bit 7 or 15 is set (BIT's N lives in 15)
+    u8 flag_c;    // 0 or 1
+    u8 flag_v;    // V is bit 7
+    u64 cycles;
+    u64 instructions;
+    // cpu_run() executes until cycles reaches this deadline. The scheduler lowers it when an
+    // earlier event is queued, and the CPU zeroes it when an interrupt needs servicing.
+    u64 deadline;
+    u8 irq_lines; // One bit per IrqSource currently asserting /IRQ
     // No Bus* pointer here anymore!
+#if CPU_BLOCK_CACHE
+    CpuBlockCache block_cache;
+    CpuIdleSkip idle;
+#endif
+#if CPU_TRACE
+    Trace* trace; // Receives a record per instruction when set
+#endif
 } CPU;
 
+// --- Interrupt Request Sources ---
+// /IRQ is level-triggered and shared; every source drives its own bit of irq_lines.
+typedef enum {
+    IRQ_MAPPER = (1 << 0), IRQ_APU_FRAME = (1 << 1), IRQ_DMC = (1 << 2),
+} IrqSource;
+
 // --- Processor Status Flags ---
 typedef enum {
     C_FLAG = (1 << 0), Z_FLAG = (1 << 1), I_FLAG = (1 << 2), D_FLAG = (1 << 3),
@@ -29,9 +111,35 @@ typedef enum {
 } CpuFlags;
 
 // --- Function Prototypes ---
-void cpu_power_up(void);
 void cpu_init(CPU* cpu);
 void cpu_reset(CPU* cpu, Bus* bus);
+// The processor status byte, assembled from the lazily kept flags, and its inverse.
+u8 cpu_get_status(const CPU* cpu);
+void cpu_set_status(CPU* cpu, u8 status);
+// Executes one instruction and advances cpu->cycles by its exact cycle cost.
 void cpu_step(CPU* cpu, Bus* bus);
+// Executes instructions until cpu->cycles reaches cpu->deadline (may overshoot by one instruction).
+void cpu_run(CPU* cpu, Bus* bus);
+
+// --- Block Cache Maintenance ---
+// Drops the decoded blocks living in one page of host memory (NULL: all of them).
+void cpu_invalidate_blocks(CPU* cpu, const u8* page);
+// Turns the block cache on or off at run time (the interpreter gives identical results).
+void cpu_set_block_cache(CPU* cpu, bool enabled);
+// Turns idle loop skipping on or off (it needs the block cache; results are identical).
+void cpu_set_idle_skip(CPU* cpu, bool enabled);
+
+// --- Tracing ---
+// Starts (or with NULL, stops) logging every instruction into 'trace'. Tracing turns idle
+// loop skipping off so that no iteration is missing from the log. Does nothing in builds
+// without CPU_TRACE.
+void cpu_set_trace(CPU* cpu, Trace* trace);
+
+// --- Interrupts ---
+// Both are taken between instructions by the scheduler's run loop.
+void cpu_nmi(CPU* cpu, Bus* bus);
+void cpu_set_irq(CPU* cpu, IrqSource source, bool asserted);
+// Services a pending IRQ if one is asserted and the I flag is clear. Returns true if taken.
+bool cpu_poll_irq(CPU* cpu, Bus* bus);
 
 #endif // MYNES_C_CPU_H
\ No newline at end of file
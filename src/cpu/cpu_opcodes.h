@@ -0,0 +1,82 @@
+#ifndef MYNES_C_CPU_OPCODES_H
+#define MYNES_C_CPU_OPCODES_H
+
+// --- 6502 Opcode Table (X-macro) ---
+// One entry per opcode, in opcode order: X(opcode, kind, operation, mode, base_cycles)
+//
+// kind selects how the operation receives its operand:
+//   R - read:    op(cpu, value)      +1 cycle when an indexed read crosses a page
+//   W - write:   op(cpu, bus, addr)  stores, read-modify-write, JMP/JSR
+//   H - unstable high-byte stores:   op(cpu, bus, base) before indexing (SHA/SHX/SHY/TAS)
+//   I - implied: op(cpu, bus)        includes the accumulator forms (asl_a, ...)
+//   B - branch:  op(cpu, offset)     +1 cycle when taken, +1 more when crossing a page
+//
+// mode is the AddressingMode (without the AM_ prefix) and base_cycles excludes penalties.
+// Unofficial opcodes use the common names from the NESdev wiki (ign = NOP with operand).
+#define CPU_OPCODE_TABLE(X) \
+    X(0x00, I, brk,   IMP, 7) X(0x01, R, ora,   IZX, 6) X(0x02, I, jam,   IMP, 2) X(0x03, W, slo,   IZX, 8) \
+    X(0x04, R, ign,   ZP0, 3) X(0x05, R, ora,   ZP0, 3) X(0x06, W, asl,   ZP0, 5) X(0x07, W, slo,   ZP0, 5) \
+    X(0x08, I, php,   IMP, 3) X(0x09, R, ora,   IMM, 2) X(0x0A, I, asl_a, ACC, 2) X(0x0B, R, anc,   IMM, 2) \
+    X(0x0C, R, ign,   ABS, 4) X(0x0D, R, ora,   ABS, 4) X(0x0E, W, asl,   ABS, 6) X(0x0F, W, slo,   ABS, 6) \
+    X(0x10, B, bpl,   REL, 2) X(0x11, R, ora,   IZY, 5) X(0x12, I, jam,   IMP, 2) X(0x13, W, slo,   IZY, 8) \
+    X(0x14, R, ign,   ZPX, 4) X(0x15, R, ora,   ZPX, 4) X(0x16, W, asl,   ZPX, 6) X(0x17, W, slo,   ZPX, 6) \
+    X(0x18, I, clc,   IMP, 2) X(0x19, R, ora,   ABY, 4) X(0x1A, I, nop,   IMP, 2) X(0x1B, W, slo,   ABY, 7) \
+    X(0x1C, R, ign,   ABX, 4) X(0x1D, R, ora,   ABX, 4) X(0x1E, W, asl,   ABX, 7) X(0x1F, W, slo,   ABX, 7) \
+    X(0x20, W, jsr,   ABS, 6) X(0x21, R, and,   IZX, 6) X(0x22, I, jam,   IMP, 2) X(0x23, W, rla,   IZX, 8) \
+    X(0x24, R, bit,   ZP0, 3) X(0x25, R, and,   ZP0, 3) X(0x26, W, rol,   ZP0, 5) X(0x27, W, rla,   ZP0, 5) \
+    X(0x28, I, plp,   IMP, 4) X(0x29, R, and,   IMM, 2) X(0x2A, I, rol_a, ACC, 2) X(0x2B, R, anc,   IMM, 2) \
+    X(0x2C, R, bit,   ABS, 4) X(0x2D, R, and,   ABS, 4) X(0x2E, W, rol,   ABS, 6) X(0x2F, W, rla,   ABS, 6) \
+    X(0x30, B, bmi,   REL, 2) X(0x31, R, and,   IZY, 5) X(0x32, I, jam,   IMP, 2) X(0x33, W, rla,   IZY, 8) \
+    X(0x34, R, ign,   ZPX, 4) X(0x35, R, and,   ZPX, 4) X(0x36, W, rol,   ZPX, 6) X(0x37, W, rla,   ZPX, 6) \
+    X(0x38, I, sec,   IMP, 2) X(0x39, R, and,   ABY, 4) X(0x3A, I, nop,   IMP, 2) X(0x3B, W, rla,   ABY, 7) \
+    X(0x3C, R, ign,   ABX, 4) X(0x3D, R, and,   ABX, 4) X(0x3E, W, rol,   ABX, 7) X(0x3F, W, rla,   ABX, 7) \
+    X(0x40, I, rti,   IMP, 6) X(0x41, R, eor,   IZX, 6) X(0x42, I, jam,   IMP, 2) X(0x43, W, sre,   IZX, 8) \
+    X(0x44, R, ign,   ZP0, 3) X(0x45, R, eor,   ZP0, 3) X(0x46, W, lsr,   ZP0, 5) X(0x47, W, sre,   ZP0, 5) \
+    X(0x48, I, pha,   IMP, 3) X(0x49, R, eor,   IMM, 2) X(0x4A, I, lsr_a, ACC, 2) X(0x4B, R, alr,   IMM, 2) \
+    X(0x4C, W, jmp,   ABS, 3) X(0x4D, R, eor,   ABS, 4) X(0x4E, W, lsr,   ABS, 6) X(0x4F, W, sre,   ABS, 6) \
+    X(0x50, B, bvc,   REL, 2) X(0x51, R, eor,   IZY, 5) X(0x52, I, jam,   IMP, 2) X(0x53, W, sre,   IZY, 8) \
+    X(0x54, R, ign,   ZPX, 4) X(0x55, R, eor,   ZPX, 4) X(0x56, W, lsr,   ZPX, 6) X(0x57, W, sre,   ZPX, 6) \
+    X(0x58, I, cli,   IMP, 2) X(0x59, R, eor,   ABY, 4) X(0x5A, I, nop,   IMP, 2) X(0x5B, W, sre,   ABY, 7) \
+    X(0x5C, R, ign,   ABX, 4) X(0x5D, R, eor,   ABX, 4) X(0x5E, W, lsr,   ABX, 7) X(0x5F, W, sre,   ABX, 7) \
+    X(0x60, I, rts,   IMP, 6) X(0x61, R, adc,   IZX, 6) X(0x62, I, jam,   IMP, 2) X(0x63, W, rra,   IZX, 8) \
+    X(0x64, R, ign,   ZP0, 3) X(0x65, R, adc,   ZP0, 3) X(0x66, W, ror,   ZP0, 5) X(0x67, W, rra,   ZP0, 5) \
+    X(0x68, I, pla,   IMP, 4) X(0x69, R, adc,   IMM, 2) X(0x6A, I, ror_a, ACC, 2) X(0x6B, R, arr,   IMM, 2) \
+    X(0x6C, W, jmp,   IND, 5) X(0x6D, R, adc,   ABS, 4) X(0x6E, W, ror,   ABS, 6) X(0x6F, W, rra,   ABS, 6) \
+    X(0x70, B, bvs,   REL, 2) X(0x71, R, adc,   IZY, 5) X(0x72, I, jam,   IMP, 2) X(0x73, W, rra,   IZY, 8) \
+    X(0x74, R, ign,   ZPX, 4) X(0x75, R, adc,   ZPX, 4) X(0x76, W, ror,   ZPX, 6) X(0x77, W, rra,   ZPX, 6) \
+    X(0x78, I, sei,   IMP, 2) X(0x79, R, adc,   ABY, 4) X(0x7A, I, nop,   IMP, 2) X(0x7B, W, rra,   ABY, 7) \
+    X(0x7C, R, ign,   ABX, 4) X(0x7D, R, adc,   ABX, 4) X(0x7E, W, ror,   ABX, 7) X(0x7F, W, rra,   ABX, 7) \
+    X(0x80, R, ign,   IMM, 2) X(0x81, W, sta,   IZX, 6) X(0x82, R, ign,   IMM, 2) X(0x83, W, sax,   IZX, 6) \
+    X(0x84, W, sty,   ZP0, 3) X(0x85, W, sta,   ZP0, 3) X(0x86, W, stx,   ZP0, 3) X(0x87, W, sax,   ZP0, 3) \
+    X(0x88, I, dey,   IMP, 2) X(0x89, R, ign,   IMM, 2) X(0x8A, I, txa,   IMP, 2) X(0x8B, R, xaa,   IMM, 2) \
+    X(0x8C, W, sty,   ABS, 4) X(0x8D, W, sta,   ABS, 4) X(0x8E, W, stx,   ABS, 4) X(0x8F, W, sax,   ABS, 4) \
+    X(0x90, B, bcc,   REL, 2) X(0x91, W, sta,   IZY, 6) X(0x92, I, jam,   IMP, 2) X(0x93, H, sha,   IZY, 6) \
+    X(0x94, W, sty,   ZPX, 4) X(0x95, W, sta,   ZPX, 4) X(0x96, W, stx,   ZPY, 4) X(0x97, W, sax,   ZPY, 4) \
+    X(0x98, I, tya,   IMP, 2) X(0x99, W, sta,   ABY, 5) X(0x9A, I, txs,   IMP, 2) X(0x9B, H, tas,   ABY, 5) \
+    X(0x9C, H, shy,   ABX, 5) X(0x9D, W, sta,   ABX, 5) X(0x9E, H, shx,   ABY, 5) X(0x9F, H, sha,   ABY, 5) \
+    X(0xA0, R, ldy,   IMM, 2) X(0xA1, R, lda,   IZX, 6) X(0xA2, R, ldx,   IMM, 2) X(0xA3, R, lax,   IZX, 6) \
+    X(0xA4, R, ldy,   ZP0, 3) X(0xA5, R, lda,   ZP0, 3) X(0xA6, R, ldx,   ZP0, 3) X(0xA7, R, lax,   ZP0, 3) \
+    X(0xA8, I, tay,   IMP, 2) X(0xA9, R, lda,   IMM, 2) X(0xAA, I, tax,   IMP, 2) X(0xAB, R, lxa,   IMM, 2) \
+    X(0xAC, R, ldy,   ABS, 4) X(0xAD, R, lda,   ABS, 4) X(0xAE, R, ldx,   ABS, 4) X(0xAF, R, lax,   ABS, 4) \
+    X(0xB0, B, bcs,   REL, 2) X(0xB1, R, lda,   IZY, 5) X(0xB2, I, jam,   IMP, 2) X(0xB3, R, lax,   IZY, 5) \
+    X(0xB4, R, ldy,   ZPX, 4) X(0xB5, R, lda,   ZPX, 4) X(0xB6, R, ldx,   ZPY, 4) X(0xB7, R, lax,   ZPY, 4) \
+    X(0xB8, I, clv,   IMP, 2) X(0xB9, R, lda,   ABY, 4) X(0xBA, I, tsx,   IMP, 2) X(0xBB, R, las,   ABY, 4) \
+    X(0xBC, R, ldy,   ABX, 4) X(0xBD, R, lda,   ABX, 4) X(0xBE, R, ldx,   ABY, 4) X(0xBF, R, lax,   ABY, 4) \
+    X(0xC0, R, cpy,   IMM, 2) X(0xC1, R, cmp,   IZX, 6) X(0xC2, R, ign,   IMM, 2) X(0xC3, W, dcp,   IZX, 8) \
+    X(0xC4, R, cpy,   ZP0, 3) X(0xC5, R, cmp,   ZP0, 3) X(0xC6, W, dec,   ZP0, 5) X(0xC7, W, dcp,   ZP0, 5) \
+    X(0xC8, I, iny,   IMP, 2) X(0xC9, R, cmp,   IMM, 2) X(0xCA, I, dex,   IMP, 2) X(0xCB, R, axs,   IMM, 2) \
+    X(0xCC, R, cpy,   ABS, 4) X(0xCD, R, cmp,   ABS, 4) X(0xCE, W, dec,   ABS, 6) X(0xCF, W, dcp,   ABS, 6) \
+    X(0xD0, B, bne,   REL, 2) X(0xD1, R, cmp,   IZY, 5) X(0xD2, I, jam,   IMP, 2) X(0xD3, W, dcp,   IZY, 8) \
+    X(0xD4, R, ign,   ZPX, 4) X(0xD5, R, cmp,   ZPX, 4) X(0xD6, W, dec,   ZPX, 6) X(0xD7, W, dcp,   ZPX, 6) \
+    X(0xD8, I, cld,   IMP, 2) X(0xD9, R, cmp,   ABY, 4) X(0xDA, I, nop,   IMP, 2) X(0xDB, W, dcp,   ABY, 7) \
+    X(0xDC, R, ign,   ABX, 4) X(0xDD, R, cmp,   ABX, 4) X(0xDE, W, dec,   ABX, 7) X(0xDF, W, dcp,   ABX, 7) \
+    X(0xE0, R, cpx,   IMM, 2) X(0xE1, R, sbc,   IZX, 6) X(0xE2, R, ign,   IMM, 2) X(0xE3, W, isb,   IZX, 8) \
+    X(0xE4, R, cpx,   ZP0, 3) X(0xE5, R, sbc,   ZP0, 3) X(0xE6, W, inc,   ZP0, 5) X(0xE7, W, isb,   ZP0, 5) \
+    X(0xE8, I, inx,   IMP, 2) X(0xE9, R, sbc,   IMM, 2) X(0xEA, I, nop,   IMP, 2) X(0xEB, R, sbc,   IMM, 2) \
+    X(0xEC, R, cpx,   ABS, 4) X(0xED, R, sbc,   ABS, 4) X(0xEE, W, inc,   ABS, 6) X(0xEF, W, isb,   ABS, 6) \
+    X(0xF0, B, beq,   REL, 2) X(0xF1, R, sbc,   IZY, 5) X(0xF2, I, jam,   IMP, 2) X(0xF3, W, isb,   IZY, 8) \
+    X(0xF4, R, ign,   ZPX, 4) X(0xF5, R, sbc,   ZPX, 4) X(0xF6, W, inc,   ZPX, 6) X(0xF7, W, isb,   ZPX, 6) \
+    X(0xF8, I, sed,   IMP, 2) X(0xF9, R, sbc,   ABY, 4) X(0xFA, I, nop,   IMP, 2) X(0xFB, W, isb,   ABY, 7) \
+    X(0xFC, R, ign,   ABX, 4) X(0xFD, R, sbc,   ABX, 4) X(0xFE, W, inc,   ABX, 7) X(0xFF, W, isb,   ABX, 7)
+
+#endif // MYNES_C_CPU_OPCODES_H
\ No newline at end of file
@@ -0,0 +1,97 @@
+// The Golden Rule: Include your own header first.
+#include "libmynes/libmynes.h"
+
+#include <stdlib.h>
+#include "nes/nes.h"
+
+_Static_assert(MYNES_SCREEN_WIDTH == PPU_SCREEN_WIDTH && MYNES_SCREEN_HEIGHT == PPU_SCREEN_HEIGHT, "screen size");
+_Static_assert(MYNES_SAMPLE_RATE == APU_SAMPLE_RATE, "sample rate");
+_Static_assert(MYNES_BUTTON_A == BUTTON_A && MYNES_BUTTON_START == BUTTON_START && MYNES_BUTTON_RIGHT == BUTTON_RIGHT,
+               "button bits");
+
+struct MyNES {
+    NES nes;
+    bool loaded;        // 'nes' holds a cartridge
+    u32 render_interval;
+    MyNESVideoCallback video;
+    void* video_user;
+    MyNESAudioCallback audio;
+    void* audio_user;
+    u32 framebuffer[PPU_SCREEN_WIDTH * PPU_SCREEN_HEIGHT];
+};
+
+MyNES* mynes_create(void) {
+    MyNES* mynes = (MyNES*)calloc(1, sizeof(MyNES));
+    if (mynes) { mynes->render_interval = 1; }
+    return mynes;
+}
+
+static void mynes_unload(MyNES* mynes) {
+    if (mynes->loaded) { nes_free(&mynes->nes); }
+    mynes->loaded = false;
+}
+
+void mynes_destroy(MyNES* mynes) {
+    if (!mynes) { return; }
+    mynes_unload(mynes);
+    free(mynes);
+}
+
+// Powers on around a freshly loaded image, dropping the caller's reference to it.
+static bool mynes_insert(MyNES* mynes, RomImage* image) {
+    mynes_unload(mynes);
+    if (!image) { return false; }
+    mynes->loaded = nes_init(&mynes->nes, image);
+    rom_image_release(image); // The instance keeps its own reference
+    if (mynes->loaded) {
+        nes_set_framebuffer(&mynes->nes, mynes->framebuffer);
+        nes_set_render_interval(&mynes->nes, mynes->render_interval);
+    }
+    return mynes->loaded;
+}
+
+bool mynes_load_rom(MyNES* mynes, const void* data, size_t size) {
+    return mynes_insert(mynes, rom_image_load_memory((const u8*)data, size, "(memory)"));
+}
+
+bool mynes_load_rom_file(MyNES* mynes, const char* path) { return mynes_insert(mynes, rom_image_load(path)); }
+
+void mynes_set_input(MyNES* mynes, int port, uint8_t buttons) {
+    if (mynes->loaded && (port == 0 || port == 1)) { nes_set_input(&mynes->nes, port, buttons); }
+}
+
+void mynes_set_render_interval(MyNES* mynes, uint32_t interval) {
+    mynes->render_interval = interval ? interval : 1;
+    if (mynes->loaded) { nes_set_render_interval(&mynes->nes, mynes->render_interval); }
+}
+
+void mynes_set_video_callback(MyNES* mynes, MyNESVideoCallback callback, void* user) {
+    mynes->video = callback;
+    mynes->video_user = user;
+}
+
+void mynes_set_audio_callback(MyNES* mynes, MyNESAudioCallback callback, void* user) {
+    mynes->audio = callback;
+    mynes->audio_user = user;
+}
+
+bool mynes_run_frame(MyNES* mynes) {
+    if (!mynes->loaded) { return false; }
+    bool drawn = nes_run_frame(&mynes->nes);
+    if (drawn && mynes->video) { mynes->video(mynes->video_user, mynes->framebuffer); }
+    if (mynes->audio) {
+        u32 count;
+        const s16* samples = nes_drain_samples(&mynes->nes, &count);
+        if (count) { mynes->audio(mynes->audio_user, samples, count); }
+    }
+    return drawn;
+}
+
+const uint32_t* mynes_framebuffer(const MyNES* mynes) { return mynes->framebuffer; }
+
+const int16_t* mynes_drain_audio(MyNES* mynes, size_t* count) {
+    u32 drained = 0;
+    const s16* samples = mynes->loaded ? nes_drain_samples(&mynes->nes, &drained) : NULL;
+    *count = drained;
+    return samples;
+}
\ No newline at end of file
@@ -0,0 +1,98 @@
+#ifndef MYNES_C_LIBMYNES_H
+#define MYNES_C_LIBMYNES_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// --- libmynes ---
+// The emulator core as a library (make lib: libmynes.a and libmynes.so / mynes.dll), for
+// programs that want to drive it in-process: test harnesses, bots, training environments.
+// It has no SDL or other dependency, and this header is all a program needs; the core's own
+// headers stay internal.
+//
+// Each MyNES is one independent machine. Instances share nothing mutable, so any number of
+// them can run on different threads; a single instance must only be used by one thread at
+// a time. Pictures and sound are never copied out: the video callback and mynes_framebuffer()
+// point at the buffer the PPU draws into, and the audio callback and mynes_drain_audio()
+// point at the samples where the APU left them.
+#if defined(_WIN32) && defined(MYNES_BUILD_SHARED)
+#define MYNES_API __declspec(dllexport)
+#elif defined(__GNUC__)
+#define MYNES_API __attribute__((visibility("default")))
+#else
+#define MYNES_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MYNES_SCREEN_WIDTH 256
+#define MYNES_SCREEN_HEIGHT 240
+#define MYNES_SAMPLE_RATE 48000 // Mono signed 16-bit samples per second
+
+// Controller buttons, for mynes_set_input().
+#define MYNES_BUTTON_A      0x01
+#define MYNES_BUTTON_B      0x02
+#define MYNES_BUTTON_SELECT 0x04
+#define MYNES_BUTTON_START  0x08
+#define MYNES_BUTTON_UP     0x10
+#define MYNES_BUTTON_DOWN   0x20
+#define MYNES_BUTTON_LEFT   0x40
+#define MYNES_BUTTON_RIGHT  0x80
+
+typedef struct MyNES MyNES;
+
+// Called from mynes_run_frame() with each frame drawn: MYNES_SCREEN_WIDTH x MYNES_SCREEN_HEIGHT
+// ARGB8888 pixels (0xAARRGGBB), rows packed. Valid until the next frame runs.
+typedef void (*MyNESVideoCallback)(void* user, const uint32_t* pixels);
+// Called from mynes_run_frame() with the samples of the frame, which then count as drained.
+// Valid until the next frame runs.
+typedef void (*MyNESAudioCallback)(void* user, const int16_t* samples, size_t count);
+
+// --- Function Prototypes ---
+
+// Returns a machine with no cartridge, or NULL if out of memory.
+MYNES_API MyNES* mynes_create(void);
+MYNES_API void mynes_destroy(MyNES* mynes);
+
+/**
+ * @brief Inserts a cartridge from a .nes file in memory and powers on, replacing any previous
+ * cartridge. The data is copied; the caller's buffer may be freed afterwards.
+ * @return false (with a message on stderr) if the file is invalid or its board unsupported;
+ * the machine is then left without a cartridge.
+ */
+MYNES_API bool mynes_load_rom(MyNES* mynes, const void* data, size_t size);
+// Same, from a file. Files are memory-mapped rather than copied.
+MYNES_API bool mynes_load_rom_file(MyNES* mynes, const char* path);
+
+// Sets the buttons (MYNES_BUTTON_* bits) held on a controller port (0 or 1) from the next frame on.
+MYNES_API void mynes_set_input(MyNES* mynes, int port, uint8_t buttons);
+
+// Draws only 1 frame in 'interval' (1, the default, draws every frame). The frames between
+// run exactly as if drawn; agents that look at every n-th frame skip the cost of the rest.
+MYNES_API void mynes_set_render_interval(MyNES* mynes, uint32_t interval);
+
+MYNES_API void mynes_set_video_callback(MyNES* mynes, MyNESVideoCallback callback, void* user);
+MYNES_API void mynes_set_audio_callback(MyNES* mynes, MyNESAudioCallback callback, void* user);
+
+/**
+ * @brief Runs one frame, then calls the callbacks that are set.
+ * @return Whether the frame was drawn; false also when no cartridge is loaded.
+ */
+MYNES_API bool mynes_run_frame(MyNES* mynes);
+
+// The picture of the last frame drawn (see MyNESVideoCallback). The pointer stays the same
+// for the life of the instance.
+MYNES_API const uint32_t* mynes_framebuffer(const MyNES* mynes);
+
+// Hands out every sample produced since the last drain (or audio callback) and sets '*count'.
+// Valid until the next frame runs. Samples left undrained for more than a few frames are dropped.
+MYNES_API const int16_t* mynes_drain_audio(MyNES* mynes, size_t* count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MYNES_C_LIBMYNES_H
\ No newline at end of file
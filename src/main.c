@@ -1,81 +1,403 @@
 #define SDL_MAIN_HANDLED
 #include <stdio.h>
 #include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
 #include <SDL2/SDL.h>
 
 #include "common/types.h"
+#include "common/spsc_ring.h"
+#include "common/triple_buffer.h"
 #include "cartridge/cartridge.h"
-#include "bus/bus.h"
-#include "cpu/cpu.h"
-#include "ppu/ppu.h"
+#include "movie/movie.h"
+#include "nes/nes.h"
+#include "runahead/runahead.h"
+#include "savestate/savestate.h"
+#include "savestate/rewind.h"
 
 const int SCREEN_SCALE = 3;
 const int SCREEN_WIDTH = 256 * SCREEN_SCALE;
 const int SCREEN_HEIGHT = 240 * SCREEN_SCALE;
 
-int main(int argc, char* argv[]) {
-    if (argc < 2) {
-        fprintf(stderr, "Usage: %s <path_to_rom.nes>\n", argv[0]);
-        return 1;
+// NTSC frame rate: 21.477272 MHz master clock / 4 / (341 * 262 - 0.5) dots.
+static const double NTSC_FRAME_RATE = 60.0988;
+
+// Rewind history: one state per frame, a keyframe every second, 8 MB of pool.
+#define REWIND_POOL_BYTES (8u << 20)
+#define REWIND_KEYFRAME_INTERVAL 60
+
+// Audio: the ring holds about 85 ms and is kept around half full, so output latency stays
+// near 43 ms. The device asks for 512 samples (about 11 ms) per callback.
+#define AUDIO_RING_SAMPLES 4096
+#define AUDIO_DEVICE_SAMPLES 512
+// Largest change of emulation speed the rate control may make (0.5%).
+#define AUDIO_MAX_SKEW 0.005
+
+// Unthrottled, only 1 frame in 4 is drawn (--ff-render changes it); the machine itself runs
+// exactly as it would with every frame drawn.
+#define FAST_FORWARD_RENDER_INTERVAL 4
+
+// With --run-ahead, the time it takes is checked over windows of this many frames (10 s).
+#define RUN_AHEAD_REPORT_FRAMES 600
+
+// Movies recorded here carry a state hash for every frame.
+#define MOVIE_HASH_INTERVAL 1
+
+// --- Keyboard ---
+// Controller 1: arrows, X = A, Z = B, right shift = Select, enter = Start.
+static u8 key_button(SDL_Keycode key) {
+    switch (key) {
+        case SDLK_x: return BUTTON_A;
+        case SDLK_z: return BUTTON_B;
+        case SDLK_RSHIFT: return BUTTON_SELECT;
+        case SDLK_RETURN: return BUTTON_START;
+        case SDLK_UP: return BUTTON_UP;
+        case SDLK_DOWN: return BUTTON_DOWN;
+        case SDLK_LEFT: return BUTTON_LEFT;
+        case SDLK_RIGHT: return BUTTON_RIGHT;
+        default: return 0;
+    }
+}
+
+// Sleeps until the performance counter reaches 'deadline'. SDL_Delay is only used for the
+// coarse part of the wait; the last millisecond is spun so the frame period stays exact.
+static void wait_until(u64 deadline, u64 perf_freq) {
+    for (;;) {
+        u64 now = SDL_GetPerformanceCounter();
+        if (now >= deadline) { return; }
+        u64 remaining_ms = (deadline - now) * 1000 / perf_freq;
+        if (remaining_ms > 1) { SDL_Delay((u32)(remaining_ms - 1)); }
     }
+}
+
+// --- Emulation Thread ---
+// The core runs on its own thread and hands finished frames to the presentation (main) thread
+// through a triple buffer, so a slow present or a vsync wait never stalls emulation.
+typedef struct EmuThread {
+    NES* nes;
+    TripleBuffer frames;
+    atomic_bool running;
+    atomic_bool throttled;
+    u32 fast_forward_interval; // Unthrottled, only 1 frame in this many is drawn
+    atomic_uchar buttons;      // Controller 1, from the keyboard
+
+    // Run-ahead (--run-ahead): only at normal speed, and not while rewinding. It leaves the
+    // real timeline alone, so movies, save states and rewind work as usual.
+    RunAhead run_ahead;
+
+    // Movie: a recording takes its input from the keyboard, a playback replaces it. Either
+    // one needs an unbroken run from power-on, so state loads and rewind are off meanwhile.
+    Movie movie;
+    const char* movie_path;
+    bool recording;
+    bool playing;
+
+    // Save states: F5/F7 post a request, BACKSPACE held rewinds. All run on this thread,
+    // between frames.
+    atomic_int request;
+    atomic_bool rewinding;
+    const char* state_path;
+    SaveState snapshot;
+    Rewind rewind;
+
+    // Audio: this thread produces into the ring and the SDL audio callback consumes it.
+    bool audio_enabled;
+    bool audio_playing;  // Callback-owned: false until the ring has filled to half
+    SpscRing audio;
+    s16 samples[APU_SAMPLE_BUFFER];
+} EmuThread;
+
+enum { EMU_REQUEST_NONE, EMU_REQUEST_SAVE, EMU_REQUEST_LOAD };
+
+static void handle_state_requests(EmuThread* emu) {
+    switch (atomic_exchange(&emu->request, EMU_REQUEST_NONE)) {
+        case EMU_REQUEST_SAVE:
+            savestate_capture(&emu->snapshot, &emu->nes->bus);
+            if (savestate_write_file(&emu->snapshot, emu->state_path)) { printf("State saved to %s\n", emu->state_path); }
+            break;
+        case EMU_REQUEST_LOAD:
+            if (emu->recording || emu->playing) { fprintf(stderr, "State loads are disabled during a movie.\n"); break; }
+            if (!savestate_read_file(&emu->snapshot, emu->state_path)) { break; }
+            if (savestate_restore(&emu->snapshot, &emu->nes->bus)) { printf("State loaded from %s\n", emu->state_path); }
+            else { fprintf(stderr, "Save state does not match this cartridge.\n"); }
+            break;
+    }
+}
+
+// --- Audio ---
+// Runs on SDL's audio thread. Playback (re)starts only once the ring is half full, so after
+// start-up or an underrun there is headroom again instead of a stream of tiny gaps.
+static void audio_callback(void* data, Uint8* stream, int length) {
+    EmuThread* emu = (EmuThread*)data;
+    s16* out = (s16*)stream;
+    u32 count = (u32)length / sizeof(s16);
+    u32 got = 0;
+    if (!emu->audio_playing && spsc_ring_size(&emu->audio) >= spsc_ring_capacity(&emu->audio) / 2) {
+        emu->audio_playing = true;
+    }
+    if (emu->audio_playing) {
+        got = spsc_ring_read(&emu->audio, out, count);
+        if (got < count) { emu->audio_playing = false; } // Underrun
+    }
+    memset(out + got, 0, (count - got) * sizeof(s16));
+}
+
+// Moves the frame's samples into the ring. Unthrottled, the ring is only topped up to half,
+// so the sound is current again as soon as the throttle comes back.
+static void push_audio(EmuThread* emu, bool throttled) {
+    u32 count = nes_read_samples(emu->nes, emu->samples, APU_SAMPLE_BUFFER);
+    if (!emu->audio_enabled) { return; }
+    if (!throttled) {
+        u32 half = spsc_ring_capacity(&emu->audio) / 2;
+        u32 size = spsc_ring_size(&emu->audio);
+        u32 room = size < half ? half - size : 0;
+        if (count > room) { count = room; }
+    }
+    spsc_ring_write(&emu->audio, emu->samples, count);
+}
+
+// Dynamic rate control: scales the frame period by up to AUDIO_MAX_SKEW so the ring hovers
+// around half full. A fuller ring means emulation is ahead of the sound card, so it slows
+// down slightly, and vice versa. The samples themselves are untouched, so pitch does not
+// change; only the video rate moves, by far less than anyone can see.
+static double audio_rate_adjust(EmuThread* emu) {
+    if (!emu->audio_enabled) { return 1.0; }
+    double fill = (double)spsc_ring_size(&emu->audio) / spsc_ring_capacity(&emu->audio);
+    return 1.0 + AUDIO_MAX_SKEW * (2.0 * fill - 1.0);
+}
+
+// Warns when run-ahead overran its share of the frame period in the last window, and says
+// how far ahead would fit instead.
+static void check_run_ahead(EmuThread* emu) {
+    if (emu->run_ahead.count < RUN_AHEAD_REPORT_FRAMES) { return; }
+    RunAheadReport report;
+    run_ahead_report(&emu->run_ahead, &report);
+    if (report.budget_used > RUN_AHEAD_BUDGET) {
+        fprintf(stderr, "Run-ahead of %u frames takes %.2f ms of each %.2f ms frame; --run-ahead %u would fit.\n",
+                emu->run_ahead.frames, report.total_ms, RUN_AHEAD_FRAME_PERIOD * 1e3, report.max_frames);
+    }
+    run_ahead_reset_stats(&emu->run_ahead);
+}
+
+static int emulation_thread(void* data) {
+    EmuThread* emu = (EmuThread*)data;
+    const u64 perf_freq = SDL_GetPerformanceFrequency();
+    const double ticks_per_frame = (double)perf_freq / NTSC_FRAME_RATE;
+    double frame_time = 0.0; // Ticks elapsed since 'epoch' at which the next frame is due.
+    u64 epoch = SDL_GetPerformanceCounter();
+    bool was_throttled = atomic_load(&emu->throttled);
 
-    Cartridge cart;
-    if (!cartridge_load(&cart, argv[1])) { return 1; }
+    while (atomic_load_explicit(&emu->running, memory_order_relaxed)) {
+        handle_state_requests(emu);
+        // While rewinding, step back one recorded frame and re-run it for the picture.
+        bool rewinding = atomic_load_explicit(&emu->rewinding, memory_order_relaxed) && !emu->recording && !emu->playing;
+        if (rewinding && rewind_pop(&emu->rewind, &emu->snapshot)) { savestate_restore(&emu->snapshot, &emu->nes->bus); }
 
-    cpu_power_up();
-    Bus nes_bus;
-    CPU nes_cpu;
-    PPU nes_ppu;
+        bool throttled = atomic_load_explicit(&emu->throttled, memory_order_relaxed);
+        nes_set_render_interval(emu->nes, (throttled || rewinding) ? 1 : emu->fast_forward_interval);
+        if (emu->playing && !movie_play_input(&emu->movie, emu->nes)) {
+            printf("Movie finished after %llu frames.\n", (unsigned long long)emu->movie.frame);
+            emu->playing = false;
+        }
+        if (!emu->playing) { nes_set_input(emu->nes, 0, atomic_load_explicit(&emu->buttons, memory_order_relaxed)); }
+        bool ahead = emu->run_ahead.frames && throttled && !rewinding;
+        bool drawn = ahead ? run_ahead_frame(&emu->run_ahead, emu->nes) : nes_run_frame(emu->nes);
+        if (emu->recording && !movie_record_frame(&emu->movie, emu->nes)) {
+            fprintf(stderr, "Out of memory: movie recording stopped.\n");
+            emu->recording = false;
+        }
+        if (emu->playing && !movie_check_frame(&emu->movie, emu->nes)) {
+            fprintf(stderr, "Movie desynchronised at frame %llu.\n", (unsigned long long)(emu->movie.frame - 1));
+            emu->playing = false;
+        }
+        if (rewinding) { nes_read_samples(emu->nes, emu->samples, APU_SAMPLE_BUFFER); } // Not played back
+        else { push_audio(emu, throttled); }
+        if (!rewinding) {
+            savestate_capture(&emu->snapshot, &emu->nes->bus);
+            rewind_push(&emu->rewind, &emu->snapshot);
+        }
+        if (drawn) { nes_set_framebuffer(emu->nes, (u32*)triple_buffer_publish(&emu->frames)); }
+        if (ahead) { check_run_ahead(emu); }
+
+        if (throttled != was_throttled) {
+            was_throttled = throttled;
+            epoch = SDL_GetPerformanceCounter();
+            frame_time = 0.0;
+        }
+        if (throttled) {
+            frame_time += ticks_per_frame * audio_rate_adjust(emu);
+            u64 now = SDL_GetPerformanceCounter();
+            // If the host fell more than a few frames behind, resynchronise instead of
+            // running a burst of catch-up frames.
+            if ((double)(now - epoch) > frame_time + 4.0 * ticks_per_frame) {
+                epoch = now;
+                frame_time = 0.0;
+            } else {
+                wait_until(epoch + (u64)frame_time, perf_freq);
+            }
+        }
+    }
+    return 0;
+}
 
-    // Initialize individual components
-    bus_init(&nes_bus);
-    cpu_init(&nes_cpu);
-    ppu_init(&nes_ppu);
+int main(int argc, char* argv[]) {
+    const char* rom_path = NULL;
+    bool throttled = true;
+    u32 fast_forward_interval = FAST_FORWARD_RENDER_INTERVAL;
+    u32 run_ahead = 0;
+    const char* record_path = NULL;
+    const char* play_path = NULL;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--unthrottled") == 0) { throttled = false; }
+        else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) { record_path = argv[++i]; }
+        else if (strcmp(argv[i], "--play") == 0 && i + 1 < argc) { play_path = argv[++i]; }
+        else if (strcmp(argv[i], "--ff-render") == 0 && i + 1 < argc) { fast_forward_interval = (u32)strtoul(argv[++i], NULL, 10); }
+        else if (strcmp(argv[i], "--run-ahead") == 0 && i + 1 < argc) { run_ahead = (u32)strtoul(argv[++i], NULL, 10); }
+        else { rom_path = argv[i]; }
+    }
+    if (!rom_path || (record_path && play_path)) {
+        fprintf(stderr, "Usage: %s [--unthrottled] [--ff-render <n>] [--run-ahead <n>] [--record <movie> | --play <movie>] <path_to_rom.nes>\n", argv[0]);
+        return 1;
+    }
 
-    // --- The Great Connection ---
-    // Connect all components to the bus, establishing the final hardware layout.
-    bus_connect_cartridge(&nes_bus, &cart);
-    bus_connect_cpu(&nes_bus, &nes_cpu);
-    bus_connect_ppu(&nes_bus, &nes_ppu);
+    profile_install(NULL); // PROFILE=1 builds: report to stderr at exit and on SIGUSR1
 
-    // Now that the bus is fully connected, we can reset the components.
-    cpu_reset(&nes_cpu, &nes_bus);
-    ppu_reset(&nes_ppu);
+    RomImage* image = rom_image_load(rom_path);
+    if (!image) { return 1; }
+    // The whole machine (CPU, PPU, bus, mapper, scheduler) lives in one context.
+    static NES nes;
+    bool ok = nes_init(&nes, image);
+    rom_image_release(image); // The instance keeps its own reference
+    if (!ok) { return 1; }
+    nes_print_cartridge(&nes);
+
+    // The PPU draws straight into the triple buffer's back buffer; finished frames are
+    // swapped, never copied, on their way to the presentation thread.
+    static u32 framebuffers[3][PPU_SCREEN_WIDTH * PPU_SCREEN_HEIGHT];
+    static EmuThread emu;
+    emu.nes = &nes;
+    triple_buffer_init(&emu.frames, framebuffers[0], framebuffers[1], framebuffers[2]);
+    atomic_init(&emu.running, true);
+    atomic_init(&emu.throttled, throttled);
+    emu.fast_forward_interval = fast_forward_interval ? fast_forward_interval : 1;
+    atomic_init(&emu.request, EMU_REQUEST_NONE);
+    atomic_init(&emu.rewinding, false);
+    atomic_init(&emu.buttons, 0);
+    run_ahead_init(&emu.run_ahead, run_ahead);
+    char state_path[1024];
+    snprintf(state_path, sizeof(state_path), "%s.state", rom_path);
+    emu.state_path = state_path;
+    if (!rewind_init(&emu.rewind, REWIND_POOL_BYTES, REWIND_KEYFRAME_INTERVAL, 1)) {
+        fprintf(stderr, "Failed to allocate the rewind buffer.\n");
+        return 1;
+    }
+    nes_set_framebuffer(&nes, (u32*)triple_buffer_back(&emu.frames));
+    if (record_path) {
+        movie_record_begin(&emu.movie, &nes, 1, MOVIE_HASH_INTERVAL);
+        emu.movie_path = record_path;
+        emu.recording = true;
+    } else if (play_path) {
+        if (!movie_load(&emu.movie, play_path)) { return 1; }
+        if (!movie_matches_rom(&emu.movie, nes.cart.image)) {
+            fprintf(stderr, "%s was recorded with a different ROM.\n", play_path);
+            return 1;
+        }
+        emu.playing = true;
+    }
 
     printf("Core components initialized and interconnected.\n");
 
     // --- SDL Setup ---
-    if (SDL_Init(SDL_INIT_VIDEO) < 0) { fprintf(stderr, "SDL Error: %s\n", SDL_GetError()); return 1; }
+    if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO) < 0) { fprintf(stderr, "SDL Error: %s\n", SDL_GetError()); return 1; }
     SDL_Window* window = SDL_CreateWindow("MyNES-C", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, SCREEN_WIDTH, SCREEN_HEIGHT, SDL_WINDOW_SHOWN);
     if (!window) { fprintf(stderr, "Window Error: %s\n", SDL_GetError()); return 1; }
-    SDL_Renderer* renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+    SDL_Renderer* renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
     if (!renderer) { fprintf(stderr, "Renderer Error: %s\n", SDL_GetError()); return 1; }
+    // Nearest-neighbour so the GPU's SCREEN_SCALE upscale keeps pixels sharp.
+    SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "nearest");
+    SDL_Texture* screen = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, PPU_SCREEN_WIDTH, PPU_SCREEN_HEIGHT);
+    if (!screen) { fprintf(stderr, "Texture Error: %s\n", SDL_GetError()); return 1; }
+
+    // Mono 16-bit at the APU's rate; SDL converts if the device wants something else.
+    static s16 audio_ring[AUDIO_RING_SAMPLES];
+    spsc_ring_init(&emu.audio, audio_ring, AUDIO_RING_SAMPLES);
+    SDL_AudioSpec want;
+    memset(&want, 0, sizeof(want));
+    want.freq = APU_SAMPLE_RATE;
+    want.format = AUDIO_S16SYS;
+    want.channels = 1;
+    want.samples = AUDIO_DEVICE_SAMPLES;
+    want.callback = audio_callback;
+    want.userdata = &emu;
+    SDL_AudioDeviceID audio = SDL_OpenAudioDevice(NULL, 0, &want, NULL, 0);
+    if (audio) {
+        emu.audio_enabled = true;
+        SDL_PauseAudioDevice(audio, 0);
+    } else {
+        fprintf(stderr, "Audio Error: %s (continuing without sound)\n", SDL_GetError());
+    }
     printf("SDL setup successful.\n");
 
-    // --- Main Emulation Loop ---
+    SDL_Thread* thread = SDL_CreateThread(emulation_thread, "emulation", &emu);
+    if (!thread) { fprintf(stderr, "Thread Error: %s\n", SDL_GetError()); return 1; }
+
+    // --- Presentation Loop ---
+    // Polls events and shows the newest finished frame. Frames are paced by the emulation
+    // thread; this loop is paced by vsync. TAB toggles the throttle, F5/F7 save and load a
+    // state next to the ROM, holding BACKSPACE rewinds, and the other keys are controller 1.
     bool running = true;
     SDL_Event event;
     while (running) {
         while (SDL_PollEvent(&event)) {
             if (event.type == SDL_QUIT) {
                 running = false;
+            } else if (event.type == SDL_KEYDOWN || event.type == SDL_KEYUP) {
+                bool down = event.type == SDL_KEYDOWN;
+                switch (event.key.keysym.sym) {
+                    case SDLK_TAB: if (down) { atomic_store(&emu.throttled, !atomic_load(&emu.throttled)); } break;
+                    case SDLK_F5: if (down) { atomic_store(&emu.request, EMU_REQUEST_SAVE); } break;
+                    case SDLK_F7: if (down) { atomic_store(&emu.request, EMU_REQUEST_LOAD); } break;
+                    case SDLK_BACKSPACE: atomic_store(&emu.rewinding, down); break;
+                    default: {
+                        u8 button = key_button(event.key.keysym.sym);
+                        if (down) { atomic_fetch_or(&emu.buttons, button); }
+                        else { atomic_fetch_and(&emu.buttons, (u8)~button); }
+                        break;
+                    }
+                }
             }
         }
 
-        // The step functions now take the bus as an argument
-        cpu_step(&nes_cpu, &nes_bus);
-        ppu_step(&nes_ppu, &nes_bus);
-
-        SDL_SetRenderDrawColor(renderer, 0x1D, 0x2B, 0x53, 0xFF);
+        if (triple_buffer_acquire(&emu.frames)) {
+            SDL_UpdateTexture(screen, NULL, triple_buffer_front(&emu.frames), PPU_SCREEN_WIDTH * sizeof(u32));
+        }
         SDL_RenderClear(renderer);
+        SDL_RenderCopy(renderer, screen, NULL, NULL);
         SDL_RenderPresent(renderer);
     }
 
+    atomic_store(&emu.running, false);
+    SDL_WaitThread(thread, NULL);
+    if (audio) { SDL_CloseAudioDevice(audio); }
+
     // --- Cleanup ---
+    if (emu.movie_path && movie_save(&emu.movie, emu.movie_path)) {
+        printf("Movie of %llu frames saved to %s\n", (unsigned long long)emu.movie.header.frames, emu.movie_path);
+    }
+    movie_free(&emu.movie);
+    if (emu.run_ahead.frames && emu.run_ahead.count) {
+        RunAheadReport report;
+        run_ahead_report(&emu.run_ahead, &report);
+        printf("Run-ahead of %u frames: %.2f ms per frame (%.0f%% of the frame period), up to %u would fit.\n",
+               emu.run_ahead.frames, report.total_ms, report.budget_used * 100.0, report.max_frames);
+    }
+    rewind_free(&emu.rewind);
+    SDL_DestroyTexture(screen);
     SDL_DestroyRenderer(renderer);
     SDL_DestroyWindow(window);
     SDL_Quit();
-    cartridge_free(&cart);
+    nes_free(&nes);
 
     printf("Emulation finished. Shutting down.\n");
     return 0;
@@ -0,0 +1,145 @@
+// The Golden Rule: Include your own header first.
+#include "mapper/mapper.h"
+
+#include <stdio.h>
+#include <string.h>
+#include "bus/bus.h"
+#include "ppu/ppu.h"
+
+const MapperOps* mapper_find(u16 mapper_id) {
+    switch (mapper_id) {
+        case 0: return &mapper_nrom;
+        case 1: return &mapper_mmc1;
+        case 2: return &mapper_uxrom;
+        case 3: return &mapper_cnrom;
+        case 4: return &mapper_mmc3;
+        default: return NULL;
+    }
+}
+
+bool mapper_init(Mapper* mapper, Cartridge* cart, Bus* bus) {
+    memset(mapper, 0, sizeof(Mapper));
+    mapper->cart = cart;
+    mapper->bus = bus;
+    mapper->ops = mapper_find(cart->mapper_id);
+    if (!mapper->ops) {
+        fprintf(stderr, "Unsupported mapper: %u\n", cart->mapper_id);
+        return false;
+    }
+    return true;
+}
+
+void mapper_reset(Mapper* mapper) {
+    mapper_set_prg_ram_8k(mapper, 0);
+    // A trainer is copied to $7000 before the game starts.
+    if (mapper->cart->trainer) { memcpy(mapper->prg_ram + 0x1000, mapper->cart->trainer, INES_TRAINER_SIZE); }
+    mapper_set_mirroring(mapper, mapper->cart->mirroring);
+    mapper->ops->reset(mapper);
+}
+
+void mapper_sync(Mapper* mapper) {
+    mapper_set_prg_ram_8k(mapper, 0);
+    mapper->ops->sync(mapper);
+}
+
+// --- Bank Switching Helpers ---
+// Resolves a possibly negative bank number of 'size' bytes to an offset into 'len' bytes.
+static u32 mapper_bank_offset(int bank, u32 size, u32 len) {
+    int count = (int)(len / size);
+    if (count == 0) { return 0; }
+    bank %= count;
+    if (bank < 0) { bank += count; }
+    return (u32)bank * size;
+}
+
+void mapper_set_prg_8k(Mapper* mapper, int window, int bank) {
+    Cartridge* cart = mapper->cart;
+    u8* memory = cart->prg_rom + mapper_bank_offset(bank, MAPPER_PRG_WINDOW, cart->prg_rom_len);
+    mapper->prg[window] = memory;
+    bus_map_pages(mapper->bus, (u16)(0x8000 + window * MAPPER_PRG_WINDOW), MAPPER_PRG_WINDOW, memory, false);
+}
+
+void mapper_set_prg_ram_8k(Mapper* mapper, int bank) {
+    u8* memory = mapper->prg_ram + mapper_bank_offset(bank, PRG_RAM_SIZE, mapper->cart->prg_ram_len);
+    bus_map_pages(mapper->bus, 0x6000, PRG_RAM_SIZE, memory, true);
+}
+
+void mapper_set_prg_16k(Mapper* mapper, int window, int bank) {
+    mapper_set_prg_8k(mapper, window * 2, bank * 2);
+    mapper_set_prg_8k(mapper, window * 2 + 1, bank * 2 + 1);
+}
+
+void mapper_set_prg_32k(Mapper* mapper, int bank) {
+    mapper_set_prg_16k(mapper, 0, bank * 2);
+    mapper_set_prg_16k(mapper, 1, bank * 2 + 1);
+}
+
+void mapper_set_chr_1k(Mapper* mapper, int window, int bank) {
+    Cartridge* cart = mapper->cart;
+    u32 offset = mapper_bank_offset(bank, MAPPER_CHR_WINDOW, cart->chr_rom_len);
+    mapper->chr[window] = cart->chr_rom + offset;
+    mapper->chr_tiles[window] = cart->chr_tiles + offset / CHR_TILE_BYTES * CHR_DECODED_TILE_BYTES;
+}
+
+void mapper_set_chr_4k(Mapper* mapper, int window, int bank) {
+    for (int i = 0; i < 4; ++i) { mapper_set_chr_1k(mapper, window * 4 + i, bank * 4 + i); }
+}
+
+void mapper_set_chr_8k(Mapper* mapper, int bank) {
+    for (int i = 0; i < 8; ++i) { mapper_set_chr_1k(mapper, i, bank * 8 + i); }
+}
+
+void mapper_set_mirroring(Mapper* mapper, Mirroring mirroring) {
+    // Four-screen boards wire their own VRAM; the header setting always wins.
+    if (mapper->cart->mirroring == MIRROR_FOUR_SCREEN) { mirroring = MIRROR_FOUR_SCREEN; }
+    ppu_set_mirroring(mapper->bus->ppu, mirroring);
+}
+
+void mapper_chr_write(Mapper* mapper, u16 address, u8 data) {
+    Cartridge* cart = mapper->cart;
+    u8* memory = mapper->chr[(address >> 10) & 7];
+    cartridge_write_chr(cart, (u32)(memory - cart->chr_rom) + (address & (MAPPER_CHR_WINDOW - 1)), data);
+}
+
+// --- Mapper 0: NROM ---
+// 16 or 32 KB of PRG (16 KB images are mirrored) and 8 KB of CHR, no registers.
+static void nrom_reset(Mapper* mapper) {
+    mapper_set_prg_16k(mapper, 0, 0);
+    mapper_set_prg_16k(mapper, 1, 1);
+    mapper_set_chr_8k(mapper, 0);
+}
+static void nrom_write(Mapper* mapper, u16 address, u8 data) { (void)mapper; (void)address; (void)data; }
+
+const MapperOps mapper_nrom = { "NROM", nrom_reset, nrom_write, nrom_reset, NULL, NULL };
+
+// --- Mapper 2: UxROM ---
+// Switchable 16 KB bank at $8000, last bank fixed at $C000.
+static void uxrom_sync(Mapper* mapper) {
+    mapper_set_prg_16k(mapper, 0, mapper->bank);
+    mapper_set_prg_16k(mapper, 1, -1);
+    mapper_set_chr_8k(mapper, 0);
+}
+static void uxrom_reset(Mapper* mapper) { mapper->bank = 0; uxrom_sync(mapper); }
+static void uxrom_write(Mapper* mapper, u16 address, u8 data) {
+    (void)address;
+    mapper->bank = data;
+    mapper_set_prg_16k(mapper, 0, data);
+}
+
+const MapperOps mapper_uxrom = { "UxROM", uxrom_reset, uxrom_write, uxrom_sync, NULL, NULL };
+
+// --- Mapper 3: CNROM ---
+// Fixed PRG, switchable 8 KB CHR bank.
+static void cnrom_sync(Mapper* mapper) {
+    mapper_set_prg_16k(mapper, 0, 0);
+    mapper_set_prg_16k(mapper, 1, 1);
+    mapper_set_chr_8k(mapper, mapper->bank);
+}
+static void cnrom_reset(Mapper* mapper) { mapper->bank = 0; cnrom_sync(mapper); }
+static void cnrom_write(Mapper* mapper, u16 address, u8 data) {
+    (void)address;
+    mapper->bank = data;
+    mapper_set_chr_8k(mapper, data);
+}
+
+const MapperOps mapper_cnrom = { "CNROM", cnrom_reset, cnrom_write, cnrom_sync, NULL, NULL };
\ No newline at end of file
@@ -0,0 +1,112 @@
+#ifndef MYNES_C_MAPPER_H
+#define MYNES_C_MAPPER_H
+
+#include "common/types.h"
+#include "cartridge/cartridge.h"
+
+// Forward declare Bus. Mappers remap the CPU page table through it.
+typedef struct Bus Bus;
+
+// --- Bank Windows ---
+// PRG is switched in 8 KB windows at $8000/$A000/$C000/$E000 and CHR in 1 KB windows over PPU
+// $0000-$1FFF. Larger banks are set as runs of these. A bank switch stores host pointers once;
+// reads never recompute bank offsets.
+#define MAPPER_PRG_WINDOW 0x2000
+#define MAPPER_CHR_WINDOW 0x0400
+#define MAPPER_PRG_WINDOWS 4
+#define MAPPER_CHR_WINDOWS 8
+
+typedef struct Mapper Mapper;
+
+typedef struct MapperOps {
+    const char* name;
+    void (*reset)(Mapper* mapper);
+    void (*write)(Mapper* mapper, u16 address, u8 data); // CPU writes to $8000-$FFFF
+    // Re-derives the bank pointers from the board registers, e.g. after a state load.
+    void (*sync)(Mapper* mapper);
+    // Optional. Called once per rendering scanline on the rising edge of PPU address line A12.
+    void (*ppu_a12)(Mapper* mapper);
+    // Optional. Called when PPUCTRL/PPUMASK change, so predicted events can be re-timed.
+    void (*resync)(Mapper* mapper);
+} MapperOps;
+
+typedef struct Mapper {
+    const MapperOps* ops;
+    Cartridge* cart;
+    Bus* bus;
+
+    u8* prg[MAPPER_PRG_WINDOWS];       // Host memory behind each PRG window
+    u8* chr[MAPPER_CHR_WINDOWS];       // Host memory behind each CHR window
+    u8* chr_tiles[MAPPER_CHR_WINDOWS]; // The matching decoded tiles (see cartridge.h)
+    u8 prg_ram[PRG_RAM_MAX_SIZE];      // cart->prg_ram_len bytes used, seen at $6000-$7FFF
+
+    // Board registers.
+    union {
+        u8 bank; // UxROM / CNROM: the single bank register
+        struct {
+            u8 shift;
+            u8 shift_count;
+            u8 control;
+            u8 chr_bank0, chr_bank1, prg_bank;
+        } mmc1;
+        struct {
+            u8 bank_select;
+            u8 regs[8];
+            u8 irq_latch;
+            u8 irq_counter;
+            bool irq_reload;
+            bool irq_enabled;
+        } mmc3;
+    };
+} Mapper;
+
+// --- Function Prototypes ---
+
+// The board implementation for an iNES mapper number, or NULL if it is not supported.
+const MapperOps* mapper_find(u16 mapper_id);
+
+/**
+ * @brief Selects the board implementation for the cartridge's mapper number.
+ * @return false if the mapper is not supported.
+ */
+bool mapper_init(Mapper* mapper, Cartridge* cart, Bus* bus);
+
+// Maps PRG RAM and the power-on banks. The bus must have its PPU connected.
+void mapper_reset(Mapper* mapper);
+// Re-applies the current register values after they were restored from a save state.
+void mapper_sync(Mapper* mapper);
+
+// --- Bank Switching Helpers ---
+// Bank numbers wrap around the image size; negative numbers count from the last bank.
+void mapper_set_prg_8k(Mapper* mapper, int window, int bank);
+void mapper_set_prg_16k(Mapper* mapper, int window, int bank);
+void mapper_set_prg_32k(Mapper* mapper, int bank);
+void mapper_set_chr_1k(Mapper* mapper, int window, int bank);
+void mapper_set_chr_4k(Mapper* mapper, int window, int bank);
+void mapper_set_chr_8k(Mapper* mapper, int bank);
+void mapper_set_prg_ram_8k(Mapper* mapper, int bank);
+void mapper_set_mirroring(Mapper* mapper, Mirroring mirroring);
+
+// --- PPU-side Access ---
+static inline u8 mapper_chr_read(const Mapper* mapper, u16 address) {
+    return mapper->chr[(address >> 10) & 7][address & (MAPPER_CHR_WINDOW - 1)];
+}
+void mapper_chr_write(Mapper* mapper, u16 address, u8 data);
+
+// Decoded row 'row' of the tile at PPU pattern address 'address'.
+static inline const u8* mapper_tile_row(const Mapper* mapper, u16 address, int row) {
+    return mapper->chr_tiles[(address >> 10) & 7] + ((address & (MAPPER_CHR_WINDOW - 1)) / CHR_TILE_BYTES) * CHR_DECODED_TILE_BYTES + row * 8;
+}
+
+static inline void mapper_write(Mapper* mapper, u16 address, u8 data) { mapper->ops->write(mapper, address, data); }
+static inline void mapper_ppu_a12(Mapper* mapper) { if (mapper->ops->ppu_a12) { mapper->ops->ppu_a12(mapper); } }
+static inline void mapper_resync(Mapper* mapper) { if (mapper->ops->resync) { mapper->ops->resync(mapper); } }
+
+// Board implementations.
+extern const MapperOps mapper_nrom;
+extern const MapperOps mapper_mmc1;
+extern const MapperOps mapper_uxrom;
+extern const MapperOps mapper_cnrom;
+extern const MapperOps mapper_mmc3;
+
+#endif // MYNES_C_MAPPER_H
\ No newline at end of file
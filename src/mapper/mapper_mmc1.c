@@ -0,0 +1,81 @@
+// =============================================================================
+// mapper_mmc1.c - Mapper 1: Nintendo MMC1 (SxROM).
+//
+// Registers are loaded serially: five writes of bit 0 to $8000-$FFFF, the fifth
+// address selecting the register. A write with bit 7 set resets the shifter.
+// =============================================================================
+#include "mapper/mapper.h"
+
+static void mmc1_update(Mapper* mapper) {
+    u8 control = mapper->mmc1.control;
+    static const Mirroring mirroring[4] = { MIRROR_SINGLE_LOW, MIRROR_SINGLE_HIGH, MIRROR_VERTICAL, MIRROR_HORIZONTAL };
+    mapper_set_mirroring(mapper, mirroring[control & 3]);
+
+    // SUROM: 512 KB boards use CHR bank bit 4 to select the 256 KB PRG half.
+    int outer = (mapper->cart->prg_rom_len > 0x40000) ? (mapper->mmc1.chr_bank0 & 0x10) : 0;
+    int prg = (mapper->mmc1.prg_bank & 0x0F) | outer;
+    switch ((control >> 2) & 3) {
+        case 0: case 1: // 32 KB
+            mapper_set_prg_16k(mapper, 0, prg & ~1);
+            mapper_set_prg_16k(mapper, 1, prg | 1);
+            break;
+        case 2: // First bank fixed at $8000
+            mapper_set_prg_16k(mapper, 0, outer);
+            mapper_set_prg_16k(mapper, 1, prg);
+            break;
+        case 3: // Last bank fixed at $C000
+            mapper_set_prg_16k(mapper, 0, prg);
+            mapper_set_prg_16k(mapper, 1, outer | 0x0F);
+            break;
+    }
+
+    // SOROM (16 KB) and SXROM (32 KB): CHR bank 0 also drives PRG RAM A13 (bit 3), and A14 (bit 2).
+    u32 prg_ram_len = mapper->cart->prg_ram_len;
+    if (prg_ram_len > PRG_RAM_SIZE) {
+        u8 chr = mapper->mmc1.chr_bank0;
+        mapper_set_prg_ram_8k(mapper, prg_ram_len > 0x4000 ? (chr >> 2) & 3 : (chr >> 3) & 1);
+    }
+
+    if (control & 0x10) {
+        mapper_set_chr_4k(mapper, 0, mapper->mmc1.chr_bank0);
+        mapper_set_chr_4k(mapper, 1, mapper->mmc1.chr_bank1);
+    } else {
+        mapper_set_chr_4k(mapper, 0, mapper->mmc1.chr_bank0 & ~1);
+        mapper_set_chr_4k(mapper, 1, mapper->mmc1.chr_bank0 | 1);
+    }
+}
+
+static void mmc1_reset(Mapper* mapper) {
+    mapper->mmc1.shift = 0;
+    mapper->mmc1.shift_count = 0;
+    mapper->mmc1.control = 0x0C;
+    mapper->mmc1.chr_bank0 = 0;
+    mapper->mmc1.chr_bank1 = 0;
+    mapper->mmc1.prg_bank = 0;
+    mmc1_update(mapper);
+}
+
+static void mmc1_write(Mapper* mapper, u16 address, u8 data) {
+    if (data & 0x80) {
+        mapper->mmc1.shift = 0;
+        mapper->mmc1.shift_count = 0;
+        mapper->mmc1.control |= 0x0C;
+        mmc1_update(mapper);
+        return;
+    }
+    mapper->mmc1.shift |= (u8)((data & 1) << mapper->mmc1.shift_count);
+    if (++mapper->mmc1.shift_count < 5) { return; }
+
+    u8 value = mapper->mmc1.shift;
+    mapper->mmc1.shift = 0;
+    mapper->mmc1.shift_count = 0;
+    switch ((address >> 13) & 3) {
+        case 0: mapper->mmc1.control = value; break;
+        case 1: mapper->mmc1.chr_bank0 = value; break;
+        case 2: mapper->mmc1.chr_bank1 = value; break;
+        case 3: mapper->mmc1.prg_bank = value; break;
+    }
+    mmc1_update(mapper);
+}
+
+const MapperOps mapper_mmc1 = { "MMC1", mmc1_reset, mmc1_write, mmc1_update, NULL, NULL };
\ No newline at end of file
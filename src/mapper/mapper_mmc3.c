@@ -0,0 +1,107 @@
+// =============================================================================
+// mapper_mmc3.c - Mapper 4: Nintendo MMC3 (TxROM).
+//
+// Eight bank registers behind a select/data pair, plus a scanline counter
+// clocked by rising edges of PPU A12. The PPU reports those edges as it
+// catches up; to raise the IRQ on time without polling, the board also asks
+// the PPU when the edge that will expire the counter happens and schedules an
+// EVENT_MAPPER_IRQ there to force the catch-up.
+// =============================================================================
+#include "mapper/mapper.h"
+
+#include "bus/bus.h"
+#include "cpu/cpu.h"
+#include "ppu/ppu.h"
+#include "scheduler/scheduler.h"
+
+static void mmc3_update_banks(Mapper* mapper) {
+    const u8* r = mapper->mmc3.regs;
+    u8 select = mapper->mmc3.bank_select;
+
+    // CHR: two 2 KB banks (R0, R1) and four 1 KB banks (R2-R5); bit 7 swaps the halves.
+    int a = (select & 0x80) ? 4 : 0;
+    int b = a ^ 4;
+    mapper_set_chr_1k(mapper, a + 0, r[0] & 0xFE);
+    mapper_set_chr_1k(mapper, a + 1, r[0] | 0x01);
+    mapper_set_chr_1k(mapper, a + 2, r[1] & 0xFE);
+    mapper_set_chr_1k(mapper, a + 3, r[1] | 0x01);
+    for (int i = 0; i < 4; ++i) { mapper_set_chr_1k(mapper, b + i, r[2 + i]); }
+
+    // PRG: R6 and the second-to-last bank trade places at $8000/$C000 based on bit 6.
+    mapper_set_prg_8k(mapper, (select & 0x40) ? 2 : 0, r[6] & 0x3F);
+    mapper_set_prg_8k(mapper, (select & 0x40) ? 0 : 2, -2);
+    mapper_set_prg_8k(mapper, 1, r[7] & 0x3F);
+    mapper_set_prg_8k(mapper, 3, -1);
+}
+
+// Re-times EVENT_MAPPER_IRQ for the A12 edge that will bring the counter to zero.
+static void mmc3_predict_irq(Mapper* mapper) {
+    Bus* bus = mapper->bus;
+    if (!mapper->mmc3.irq_enabled) {
+        scheduler_cancel(bus->sched, EVENT_MAPPER_IRQ);
+        return;
+    }
+    // A zero or reloading counter is refilled by the next edge and then counts the latch down.
+    u32 edges;
+    if (mapper->mmc3.irq_counter == 0 || mapper->mmc3.irq_reload) { edges = 1 + mapper->mmc3.irq_latch; }
+    else { edges = mapper->mmc3.irq_counter; }
+    u64 when = ppu_a12_edge_cycle(bus->ppu, edges);
+    if (when == SCHEDULER_NEVER) { scheduler_cancel(bus->sched, EVENT_MAPPER_IRQ); }
+    else { scheduler_schedule(bus->sched, EVENT_MAPPER_IRQ, when); }
+}
+
+static void mmc3_reset(Mapper* mapper) {
+    for (int i = 0; i < 8; ++i) { mapper->mmc3.regs[i] = 0; }
+    mapper->mmc3.regs[7] = 1;
+    mapper->mmc3.bank_select = 0;
+    mapper->mmc3.irq_latch = 0;
+    mapper->mmc3.irq_counter = 0;
+    mapper->mmc3.irq_reload = false;
+    mapper->mmc3.irq_enabled = false;
+    mmc3_update_banks(mapper);
+}
+
+static void mmc3_write(Mapper* mapper, u16 address, u8 data) {
+    bool odd = address & 1;
+    switch (address & 0xE000) {
+        case 0x8000:
+            if (odd) { mapper->mmc3.regs[mapper->mmc3.bank_select & 7] = data; }
+            else { mapper->mmc3.bank_select = data; }
+            mmc3_update_banks(mapper);
+            break;
+        case 0xA000:
+            // Odd: PRG RAM protect. Left always enabled, as most emulators do.
+            if (!odd) { mapper_set_mirroring(mapper, (data & 1) ? MIRROR_HORIZONTAL : MIRROR_VERTICAL); }
+            break;
+        case 0xC000:
+            if (odd) { mapper->mmc3.irq_counter = 0; mapper->mmc3.irq_reload = true; }
+            else { mapper->mmc3.irq_latch = data; }
+            mmc3_predict_irq(mapper);
+            break;
+        case 0xE000:
+            mapper->mmc3.irq_enabled = odd;
+            if (!odd) { cpu_set_irq(mapper->bus->cpu, IRQ_MAPPER, false); }
+            mmc3_predict_irq(mapper);
+            break;
+    }
+}
+
+static void mmc3_sync(Mapper* mapper) {
+    mmc3_update_banks(mapper);
+    mmc3_predict_irq(mapper);
+}
+
+static void mmc3_ppu_a12(Mapper* mapper) {
+    if (mapper->mmc3.irq_counter == 0 || mapper->mmc3.irq_reload) {
+        mapper->mmc3.irq_counter = mapper->mmc3.irq_latch;
+        mapper->mmc3.irq_reload = false;
+    } else {
+        mapper->mmc3.irq_counter--;
+    }
+    if (mapper->mmc3.irq_counter == 0 && mapper->mmc3.irq_enabled) {
+        cpu_set_irq(mapper->bus->cpu, IRQ_MAPPER, true);
+    }
+    mmc3_predict_irq(mapper);
+}
+
+const MapperOps mapper_mmc3 = { "MMC3", mmc3_reset, mmc3_write, mmc3_sync, mmc3_ppu_a12, mmc3_predict_irq };
\ No newline at end of file
@@ -0,0 +1,202 @@
+// The Golden Rule: Include your own header first.
+#include "movie/movie.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "common/file_map.h"
+
+_Static_assert(sizeof(MovieHeader) == 64, "the movie header is a fixed 64 bytes");
+
+void movie_rom_sha1(const RomImage* image, u8 sha1[SHA1_DIGEST_SIZE]) {
+    Sha1 sha;
+    sha1_init(&sha);
+    sha1_update(&sha, image->prg_rom, image->prg_rom_len);
+    if (image->chr_rom) { sha1_update(&sha, image->chr_rom, image->chr_rom_len); }
+    sha1_final(&sha, sha1);
+}
+
+u64 movie_state_hash(const NES* nes) {
+    const CPU* cpu = &nes->cpu;
+    const PPU* ppu = &nes->ppu;
+    const u8 regs[] = {
+        cpu->a, cpu->x, cpu->y, cpu->sp, cpu_get_status(cpu), (u8)cpu->pc, (u8)(cpu->pc >> 8),
+        ppu->ppuctrl, ppu->ppumask, ppu->ppustatus, ppu->oamaddr,
+        (u8)ppu->v, (u8)(ppu->v >> 8), (u8)ppu->t, (u8)(ppu->t >> 8), ppu->fine_x,
+    };
+    u64 hash = fnv1a64_update(FNV1A64_BASIS, regs, sizeof(regs));
+    hash = fnv1a64_update(hash, &cpu->cycles, sizeof(cpu->cycles));
+    hash = fnv1a64_update(hash, nes->bus.ram, RAM_SIZE);
+    hash = fnv1a64_update(hash, ppu->vram, sizeof(ppu->vram));
+    hash = fnv1a64_update(hash, ppu->palette_ram, sizeof(ppu->palette_ram));
+    return fnv1a64_update(hash, ppu->oam, sizeof(ppu->oam));
+}
+
+// --- Run Coding ---
+// Decodes the run at 'pos' into its length and buttons. Returns the position after it, or 0
+// if the stream ends inside it or the count does not fit 64 bits.
+static size_t movie_read_run(const Movie* movie, size_t pos, u64* length, u8* buttons) {
+    size_t end = movie->header.input_size;
+    *length = 0;
+    for (u32 shift = 0;; shift += 7) {
+        if (pos >= end || shift > 63) { return 0; }
+        u8 byte = movie->input[pos++];
+        *length |= (u64)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) { break; }
+    }
+    if (end - pos < movie->header.ports) { return 0; }
+    memcpy(buttons, movie->input + pos, movie->header.ports);
+    return pos + movie->header.ports;
+}
+
+static bool movie_grow(void** data, size_t* capacity, size_t need, size_t item) {
+    if (need <= *capacity) { return true; }
+    size_t grown = *capacity ? *capacity * 2 : 256;
+    while (grown < need) { grown *= 2; }
+    void* block = realloc(*data, grown * item);
+    if (!block) { return false; }
+    *data = block;
+    *capacity = grown;
+    return true;
+}
+
+// Appends the run being recorded to the input stream.
+static bool movie_flush_run(Movie* movie) {
+    if (!movie->run_length) { return true; }
+    u8 run[10 + MOVIE_MAX_PORTS];
+    size_t n = 0;
+    u64 length = movie->run_length;
+    do {
+        u8 byte = length & 0x7F;
+        length >>= 7;
+        run[n++] = byte | (length ? 0x80 : 0);
+    } while (length);
+    memcpy(run + n, movie->run_buttons, movie->header.ports);
+    n += movie->header.ports;
+
+    size_t size = movie->header.input_size;
+    if (!movie_grow((void**)&movie->input, &movie->input_capacity, size + n, 1)) { return false; }
+    memcpy(movie->input + size, run, n);
+    movie->header.input_size += n;
+    movie->run_length = 0;
+    return true;
+}
+
+// --- Recording ---
+void movie_record_begin(Movie* movie, const NES* nes, u32 ports, u32 hash_interval) {
+    memset(movie, 0, sizeof(Movie));
+    memcpy(movie->header.magic, MOVIE_MAGIC, 4);
+    movie->header.version = MOVIE_VERSION;
+    movie->header.hash_interval = hash_interval;
+    movie->header.ports = (u8)(ports >= MOVIE_MAX_PORTS ? MOVIE_MAX_PORTS : 1);
+    movie_rom_sha1(nes->cart.image, movie->header.rom_sha1);
+}
+
+bool movie_record_frame(Movie* movie, const NES* nes) {
+    u8 buttons[MOVIE_MAX_PORTS] = { nes->pads[0].buttons, nes->pads[1].buttons };
+    if (movie->run_length && memcmp(buttons, movie->run_buttons, movie->header.ports) != 0 && !movie_flush_run(movie)) {
+        return false;
+    }
+    memcpy(movie->run_buttons, buttons, MOVIE_MAX_PORTS);
+    movie->run_length++;
+    movie->frame++;
+    movie->header.frames++;
+
+    u32 interval = movie->header.hash_interval;
+    if (interval && movie->frame % interval == 0) {
+        u64 count = movie->header.hash_count;
+        if (!movie_grow((void**)&movie->hashes, &movie->hash_capacity, (size_t)count + 1, sizeof(u64))) { return false; }
+        movie->hashes[count] = movie_state_hash(nes);
+        movie->header.hash_count++;
+    }
+    return true;
+}
+
+bool movie_save(Movie* movie, const char* path) {
+    if (!movie_flush_run(movie)) {
+        fprintf(stderr, "Out of memory while recording the movie.\n");
+        return false;
+    }
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        perror("Failed to open movie for writing");
+        return false;
+    }
+    const MovieHeader* header = &movie->header;
+    bool ok = fwrite(header, sizeof(MovieHeader), 1, file) == 1 &&
+              (!header->input_size || fwrite(movie->input, header->input_size, 1, file) == 1) &&
+              (!header->hash_count || fwrite(movie->hashes, sizeof(u64), header->hash_count, file) == header->hash_count);
+    if (fclose(file) != 0) { ok = false; }
+    if (!ok) { fprintf(stderr, "Failed to write movie.\n"); }
+    return ok;
+}
+
+// --- Playback ---
+bool movie_load(Movie* movie, const char* path) {
+    memset(movie, 0, sizeof(Movie));
+    FileMap file;
+    if (!file_map_open(&file, path)) { return false; }
+    const MovieHeader* header = (const MovieHeader*)file.data;
+    bool ok = file.size >= sizeof(MovieHeader) && memcmp(header->magic, MOVIE_MAGIC, 4) == 0 &&
+              header->version == MOVIE_VERSION && header->ports >= 1 && header->ports <= MOVIE_MAX_PORTS &&
+              header->input_size <= file.size - sizeof(MovieHeader) &&
+              header->hash_count == (file.size - sizeof(MovieHeader) - header->input_size) / sizeof(u64) &&
+              (file.size - sizeof(MovieHeader) - header->input_size) % sizeof(u64) == 0;
+    if (ok) {
+        movie->header = *header;
+        movie->input = (u8*)malloc(header->input_size ? header->input_size : 1);
+        movie->hashes = (u64*)malloc(header->hash_count ? header->hash_count * sizeof(u64) : 1);
+        ok = movie->input && movie->hashes;
+    }
+    if (ok) {
+        memcpy(movie->input, file.data + sizeof(MovieHeader), header->input_size);
+        memcpy(movie->hashes, file.data + sizeof(MovieHeader) + header->input_size, header->hash_count * sizeof(u64));
+        movie->input_capacity = header->input_size;
+        movie->hash_capacity = header->hash_count;
+    }
+    file_map_close(&file);
+
+    // The runs must cover exactly the frames the header promises.
+    u64 frames = 0;
+    for (size_t pos = 0; ok && pos < movie->header.input_size;) {
+        u64 length;
+        pos = movie_read_run(movie, pos, &length, movie->buttons);
+        ok = pos != 0 && length <= movie->header.frames - frames;
+        frames += length;
+    }
+    if (!ok || frames != movie->header.frames) {
+        fprintf(stderr, "Not a compatible movie: %s\n", path);
+        movie_free(movie);
+        return false;
+    }
+    return true;
+}
+
+bool movie_matches_rom(const Movie* movie, const RomImage* image) {
+    u8 sha1[SHA1_DIGEST_SIZE];
+    movie_rom_sha1(image, sha1);
+    return memcmp(sha1, movie->header.rom_sha1, SHA1_DIGEST_SIZE) == 0;
+}
+
+bool movie_play_input(Movie* movie, NES* nes) {
+    if (movie->frame == movie->header.frames) { return false; }
+    // Zero-length runs are legal, if useless; skip them.
+    while (!movie->run_left) { movie->cursor = movie_read_run(movie, movie->cursor, &movie->run_left, movie->buttons); }
+    movie->run_left--;
+    movie->frame++;
+    for (int port = 0; port < movie->header.ports; ++port) { nes_set_input(nes, port, movie->buttons[port]); }
+    return true;
+}
+
+bool movie_check_frame(const Movie* movie, const NES* nes) {
+    u32 interval = movie->header.hash_interval;
+    if (!interval || movie->frame % interval != 0) { return true; }
+    u64 index = movie->frame / interval - 1;
+    return index >= movie->header.hash_count || movie->hashes[index] == movie_state_hash(nes);
+}
+
+void movie_free(Movie* movie) {
+    free(movie->input);
+    free(movie->hashes);
+    memset(movie, 0, sizeof(Movie));
+}
\ No newline at end of file
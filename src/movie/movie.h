@@ -0,0 +1,86 @@
+#ifndef MYNES_C_MOVIE_H
+#define MYNES_C_MOVIE_H
+
+#include <stddef.h>
+#include "common/types.h"
+#include "common/hash.h"
+#include "nes/nes.h"
+
+// --- Input Movies ---
+// A movie replays a session from power-on: the buttons held on each controller port in every
+// frame. The core is deterministic given the ROM and its input, so that is all it takes to
+// reproduce a run bit for bit, at any speed. A movie may also carry a hash of the machine
+// state every few frames, which lets a replay prove it stayed in sync.
+//
+// File layout, in host byte order like save states and traces:
+//   MovieHeader
+//   input stream  Runs of frames with the same input: a LEB128 frame count, then one button
+//                 byte per port
+//   hashes        hash_count u64 state hashes, taken after frames hash_interval - 1,
+//                 2 * hash_interval - 1, ...
+#define MOVIE_MAGIC "MNMV"
+#define MOVIE_VERSION 1
+#define MOVIE_MAX_PORTS 2
+
+typedef struct MovieHeader {
+    char magic[4];
+    u32 version;
+    u64 frames;
+    u64 input_size;    // Bytes of the input stream
+    u64 hash_count;
+    u32 hash_interval; // Frames per state hash, 0 for none
+    u8 rom_sha1[SHA1_DIGEST_SIZE]; // SHA-1 of PRG + CHR ROM, the ROM index key
+    u8 ports;          // 1 or 2
+    u8 reserved[7];
+} MovieHeader;
+
+typedef struct Movie {
+    MovieHeader header;
+    u8* input;
+    size_t input_capacity;
+    u64* hashes;
+    size_t hash_capacity;
+
+    // Recording: the run still being extended, not yet in 'input'
+    u8 run_buttons[MOVIE_MAX_PORTS];
+    u64 run_length;
+
+    // Playback
+    size_t cursor;     // Next byte of the input stream
+    u64 run_left;      // Frames left in the current run
+    u8 buttons[MOVIE_MAX_PORTS];
+
+    u64 frame;         // Frames recorded or played so far
+} Movie;
+
+// --- Function Prototypes ---
+
+// SHA-1 over the image's PRG and CHR ROM, the same digest the ROM index stores.
+void movie_rom_sha1(const RomImage* image, u8 sha1[SHA1_DIGEST_SIZE]);
+
+// Hash of the state a desync shows up in first: CPU registers and cycle count, RAM, and the
+// PPU's registers and memories.
+u64 movie_state_hash(const NES* nes);
+
+/**
+ * @brief Starts recording a machine that has just been powered on.
+ * @param ports Controller ports to record (1 or 2).
+ * @param hash_interval Frames per state hash, 0 to record input only.
+ */
+void movie_record_begin(Movie* movie, const NES* nes, u32 ports, u32 hash_interval);
+// Records the frame nes_run_frame() just ran: the buttons it was given and, when due, its hash.
+bool movie_record_frame(Movie* movie, const NES* nes);
+// Finishes the input stream and writes the movie out. The movie can go on recording.
+bool movie_save(Movie* movie, const char* path);
+
+// Loads and validates a movie for playback from its first frame.
+bool movie_load(Movie* movie, const char* path);
+bool movie_matches_rom(const Movie* movie, const RomImage* image);
+// Sets the buttons for the next frame. Returns false once every frame has been played.
+bool movie_play_input(Movie* movie, NES* nes);
+// After nes_run_frame(): false if the frame has a recorded hash and the machine differs.
+bool movie_check_frame(const Movie* movie, const NES* nes);
+
+void movie_free(Movie* movie);
+
+#endif // MYNES_C_MOVIE_H
\ No newline at end of file
@@ -0,0 +1,68 @@
+// The Golden Rule: Include your own header first.
+#include "nes/nes.h"
+
+#include <stdio.h>
+#include <string.h>
+
+bool nes_init(NES* nes, RomImage* image) {
+    memset(nes, 0, sizeof(NES));
+    if (!cartridge_attach(&nes->cart, image)) { return false; }
+
+    // Initialize individual components
+    bus_init(&nes->bus);
+    cpu_init(&nes->cpu);
+    ppu_init(&nes->ppu);
+    apu_init(&nes->apu);
+    scheduler_init(&nes->sched, &nes->cpu);
+
+    // --- The Great Connection ---
+    bus_connect_cartridge(&nes->bus, &nes->cart);
+    bus_connect_cpu(&nes->bus, &nes->cpu);
+    bus_connect_ppu(&nes->bus, &nes->ppu);
+    bus_connect_apu(&nes->bus, &nes->apu);
+    bus_connect_controllers(&nes->bus, nes->pads);
+    bus_connect_scheduler(&nes->bus, &nes->sched);
+    if (!mapper_init(&nes->mapper, &nes->cart, &nes->bus)) {
+        cartridge_free(&nes->cart);
+        return false;
+    }
+    bus_connect_mapper(&nes->bus, &nes->mapper);
+
+    // Now that the bus is fully connected, we can reset the components.
+    mapper_reset(&nes->mapper);
+    cpu_reset(&nes->cpu, &nes->bus);
+    ppu_reset(&nes->ppu, &nes->bus);
+    apu_reset(&nes->apu, &nes->bus);
+    return true;
+}
+
+void nes_free(NES* nes) { cartridge_free(&nes->cart); }
+
+void nes_set_framebuffer(NES* nes, u32* framebuffer) { ppu_set_framebuffer(&nes->ppu, framebuffer); }
+void nes_set_render_interval(NES* nes, u32 interval) { ppu_set_render_interval(&nes->ppu, interval); }
+
+void nes_set_input(NES* nes, int port, u8 buttons) { nes->pads[port & 1].buttons = buttons; }
+
+bool nes_run_frame(NES* nes) {
+    bool drawn = ppu_drawing(&nes->ppu);
+    scheduler_run_frame(&nes->sched, &nes->bus);
+    apu_end_frame(&nes->apu, &nes->bus);
+    profile_poll();
+    return drawn;
+}
+
+u32 nes_read_samples(NES* nes, s16* out, u32 max) { return apu_read_samples(&nes->apu, out, max); }
+const s16* nes_drain_samples(NES* nes, u32* count) { return apu_drain_samples(&nes->apu, count); }
+
+void nes_print_cartridge(const NES* nes) {
+    const RomImage* image = nes->cart.image;
+    const RomInfo* info = &image->info;
+    printf("Cartridge Loaded (%s%s):\n", rom_format_name(info->format), image->file.mapped ? ", mapped" : "");
+    printf("  PRG ROM size: %u KB\n", image->prg_rom_len / 1024);
+    printf("  CHR ROM size: %u KB\n", image->chr_rom_len / 1024);
+    // Only NES 2.0 headers have submappers.
+    if (info->format == ROM_FORMAT_NES2) { printf("  Mapper ID: %u (submapper %u)\n", image->mapper_id, info->submapper); }
+    else { printf("  Mapper ID: %u\n", image->mapper_id); }
+    printf("  PRG RAM: %u KB, NVRAM: %u KB\n", info->prg_ram_len / 1024, info->prg_nvram_len / 1024);
+    printf("  Board: %s\n", nes->mapper.ops->name);
+}
\ No newline at end of file
@@ -0,0 +1,67 @@
+#ifndef MYNES_C_NES_H
+#define MYNES_C_NES_H
+
+#include "common/types.h"
+#include "apu/apu.h"
+#include "bus/bus.h"
+#include "cartridge/cartridge.h"
+#include "controller/controller.h"
+#include "cpu/cpu.h"
+#include "mapper/mapper.h"
+#include "ppu/ppu.h"
+#include "scheduler/scheduler.h"
+
+// --- NES Context ---
+// One complete machine. Every piece of mutable emulator state lives in here (the core has no
+// global or static mutable variables), so any number of instances can run side by side on
+// different threads. The only thing instances share is their read-only RomImage.
+// The components point at each other, so an initialised NES must not be moved or copied.
+typedef struct NES {
+    Bus bus;
+    CPU cpu;
+    PPU ppu;
+    APU apu;
+    Scheduler sched;
+    Mapper mapper;
+    Cartridge cart;
+    Controller pads[2];
+} NES;
+
+// --- Function Prototypes ---
+
+/**
+ * @brief Builds a powered-on machine around a ROM image (taking a reference to it).
+ * @return false if the image's board is unsupported or allocation failed.
+ */
+bool nes_init(NES* nes, RomImage* image);
+
+// Prints what was loaded (format, ROM sizes, mapper, board) to stdout. The core itself only
+// ever prints errors, to stderr; front ends that want the banner call this after nes_init().
+void nes_print_cartridge(const NES* nes);
+
+// Releases the instance's memory and its reference to the ROM image.
+void nes_free(NES* nes);
+
+// The PPU renders into 'framebuffer' (PPU_SCREEN_WIDTH x PPU_SCREEN_HEIGHT ARGB pixels).
+void nes_set_framebuffer(NES* nes, u32* framebuffer);
+
+// Fast-forward: draws only 1 frame in 'interval' (1, the default, draws every frame). The
+// frames in between run exactly as if drawn; only the framebuffer is left alone.
+void nes_set_render_interval(NES* nes, u32 interval);
+
+// Sets the buttons held (BUTTON_* bits) on a controller port (0 or 1) for the frames that follow.
+void nes_set_input(NES* nes, int port, u8 buttons);
+
+// Runs until the end of the current frame. The frame's audio is then ready to be read.
+// Returns whether the frame was drawn into the framebuffer.
+bool nes_run_frame(NES* nes);
+
+// Moves up to 'max' audio samples (mono, signed 16-bit, APU_SAMPLE_RATE) into 'out' and
+// returns how many were moved. Samples not read within a few frames are dropped.
+u32 nes_read_samples(NES* nes, s16* out, u32 max);
+
+// Hands out every sample not yet read, in place, and counts them as read. The pointer and
+// '*count' samples behind it stay valid until the next nes_run_frame().
+const s16* nes_drain_samples(NES* nes, u32* count);
+
+#endif // MYNES_C_NES_H
\ No newline at end of file
@@ -2,40 +2,310 @@
 #include "ppu/ppu.h"
 
 #include "bus/bus.h"
+#include "cpu/cpu.h"
+#include "mapper/mapper.h"
+#include "scheduler/scheduler.h"
 #include <string.h>
 
+// First CPU cycle by which the given absolute PPU dot has been processed. Catching up to
+// cycle c runs every dot below c * 3.
+static u64 ppu_dot_to_cycle(u64 dot) { return dot / PPU_DOTS_PER_CPU_CYCLE + 1; }
+static inline bool ppu_rendering(const PPU* ppu) { return (ppu->ppumask & 0x18) != 0; }
+
+// Queues the vblank event of the current frame. It only forces a catch-up; the flag and the
+// NMI themselves are produced by ppu_catch_up() crossing scanline 241, dot 1.
+static void ppu_schedule_vblank(PPU* ppu, Bus* bus) {
+    u64 dot = ppu->frame_start_dot + (u64)PPU_VBLANK_SCANLINE * PPU_DOTS_PER_SCANLINE + 1;
+    scheduler_schedule(bus->sched, EVENT_PPU_VBLANK, ppu_dot_to_cycle(dot));
+}
+
 void ppu_init(PPU* ppu) {
     memset(ppu, 0, sizeof(PPU));
+    ppu_set_mirroring(ppu, MIRROR_HORIZONTAL);
+    ppu->palette_dirty = true;
+    ppu->render_interval = 1;
 }
 
-void ppu_reset(PPU* ppu) {
+void ppu_reset(PPU* ppu, Bus* bus) {
     ppu->ppuctrl = 0;
     ppu->ppumask = 0;
     ppu->ppustatus = 0;
     ppu->oamaddr = 0;
+    ppu->w = false;
+    ppu->data_buffer = 0;
+    ppu_schedule_vblank(ppu, bus);
 }
 
-void ppu_step(PPU* ppu, Bus* bus) {
-    (void)ppu;
-    (void)bus;
+void ppu_set_framebuffer(PPU* ppu, u32* framebuffer) { ppu->framebuffer = framebuffer; }
+void ppu_set_render_interval(PPU* ppu, u32 interval) { ppu->render_interval = interval ? interval : 1; }
+
+void ppu_set_mirroring(PPU* ppu, Mirroring mirroring) {
+    static const u8 layouts[][4] = {
+        [MIRROR_HORIZONTAL]  = { 0, 0, 1, 1 },
+        [MIRROR_VERTICAL]    = { 0, 1, 0, 1 },
+        [MIRROR_SINGLE_LOW]  = { 0, 0, 0, 0 },
+        [MIRROR_SINGLE_HIGH] = { 1, 1, 1, 1 },
+        // Four-screen boards add 2 KB of VRAM we do not model yet; fall back to vertical.
+        [MIRROR_FOUR_SCREEN] = { 0, 1, 0, 1 },
+    };
+    ppu->mirroring = mirroring;
+    for (int i = 0; i < 4; ++i) { ppu->nametables[i] = &ppu->vram[layouts[mirroring][i] * 0x400]; }
+}
+
+// --- PPU Memory Map ---
+static inline u8 ppu_palette_index(u16 addr) { u8 a = addr & 0x1F; return ((a & 0x13) == 0x10) ? (a & ~0x10) : a; }
+
+static u8 ppu_mem_read(PPU* ppu, Bus* bus, u16 addr) {
+    addr &= 0x3FFF;
+    if (addr < 0x2000) { return bus->mapper ? mapper_chr_read(bus->mapper, addr) : 0; }
+    if (addr < 0x3F00) { return ppu->nametables[(addr >> 10) & 3][addr & 0x3FF]; }
+    return ppu->palette_ram[ppu_palette_index(addr)];
 }
 
-u8 ppu_read(PPU* ppu, u16 address) {
+static void ppu_mem_write(PPU* ppu, Bus* bus, u16 addr, u8 data) {
+    addr &= 0x3FFF;
+    if (addr < 0x2000) {
+        if (bus->mapper) { mapper_chr_write(bus->mapper, addr, data); }
+    } else if (addr < 0x3F00) {
+        ppu->nametables[(addr >> 10) & 3][addr & 0x3FF] = data;
+    } else {
+        ppu->palette_ram[ppu_palette_index(addr)] = data & 0x3F;
+        ppu->palette_dirty = true;
+    }
+}
+
+// --- Scroll Register Updates ---
+static void ppu_increment_x(PPU* ppu) {
+    if ((ppu->v & 0x001F) == 31) { ppu->v &= ~0x001F; ppu->v ^= 0x0400; }
+    else { ppu->v++; }
+}
+
+static void ppu_increment_y(PPU* ppu) {
+    if ((ppu->v & 0x7000) != 0x7000) { ppu->v += 0x1000; return; }
+    ppu->v &= ~0x7000;
+    u16 y = (ppu->v & 0x03E0) >> 5;
+    if (y == 29) { y = 0; ppu->v ^= 0x0800; }
+    else if (y == 31) { y = 0; }
+    else { y++; }
+    ppu->v = (ppu->v & ~0x03E0) | (y << 5);
+}
+
+static inline void ppu_copy_x(PPU* ppu) { ppu->v = (ppu->v & ~0x041F) | (ppu->t & 0x041F); }
+static inline void ppu_copy_y(PPU* ppu) { ppu->v = (ppu->v & ~0x7BE0) | (ppu->t & 0x7BE0); }
+
+// --- Catch-up ---
+// Dot on which PPU A12 rises on each rendering scanline, or 0 if it never does. It rises when
+// fetches move from the $0000 to the $1000 pattern table: at the sprite fetches (dot 260) when
+// sprites use $1000 (or 8x16 sprites are on), or at the next line's background prefetch
+// (dot 324) when only the background does.
+static u16 ppu_a12_dot(const PPU* ppu) {
+    bool bg_high = ppu->ppuctrl & 0x10;
+    bool sprites_high = (ppu->ppuctrl & 0x08) || (ppu->ppuctrl & 0x20);
+    if (sprites_high && !bg_high) { return 260; }
+    if (bg_high && !sprites_high) { return 324; }
+    return sprites_high ? 260 : 0;
+}
+
+// The odd frame's pre-render line is one dot shorter while rendering is enabled.
+static u16 ppu_line_length(const PPU* ppu) {
+    if (ppu->scanline == PPU_PRERENDER_SCANLINE && (ppu->frame & 1) && ppu_rendering(ppu)) { return PPU_DOTS_PER_SCANLINE - 1; }
+    return PPU_DOTS_PER_SCANLINE;
+}
+
+// Applies the effects of dots [from, to) of the current scanline. Only the dots that change
+// observable state are checkpoints; the coarse X increments during the visible part of the
+// line are skipped because dot 257 reloads horizontal scroll from t anyway.
+static void ppu_run_span(PPU* ppu, Bus* bus, u16 from, u16 to) {
+    #define CROSSES(d) (from <= (d) && (d) < to)
+    u16 line = ppu->scanline;
+    if (line == PPU_VBLANK_SCANLINE && CROSSES(1)) {
+        ppu->ppustatus |= PPUSTATUS_VBLANK;
+        if (ppu->ppuctrl & 0x80) {
+            u64 vblank_dot = ppu->dot_clock + (1 - from);
+            scheduler_schedule(bus->sched, EVENT_NMI, ppu_dot_to_cycle(vblank_dot));
+        }
+    }
+    if (line == PPU_PRERENDER_SCANLINE && CROSSES(1)) {
+        ppu->ppustatus &= ~(PPUSTATUS_VBLANK | PPUSTATUS_SPRITE0 | PPUSTATUS_OVERFLOW);
+    }
+    if (line < PPU_VISIBLE_SCANLINES) {
+        // The whole line is drawn up front; the flags it produces still land on their own dots.
+        if (CROSSES(1)) { ppu_render_scanline(ppu, bus); }
+        if (ppu->sprite0_dot && CROSSES(ppu->sprite0_dot)) { ppu->ppustatus |= PPUSTATUS_SPRITE0; }
+        if (ppu->overflow_pending && CROSSES(256)) { ppu->ppustatus |= PPUSTATUS_OVERFLOW; }
+    }
+    if ((line < PPU_VISIBLE_SCANLINES || line == PPU_PRERENDER_SCANLINE) && ppu_rendering(ppu)) {
+        if (CROSSES(256)) { ppu_increment_y(ppu); }
+        if (CROSSES(257)) { ppu_copy_x(ppu); }
+        if (line == PPU_PRERENDER_SCANLINE && from <= 304 && to > 280) { ppu_copy_y(ppu); }
+        u16 a12 = ppu_a12_dot(ppu);
+        if (a12 && CROSSES(a12) && bus->mapper) {
+            // Move the position up to the edge first so the mapper sees a consistent PPU.
+            ppu->dot_clock += (u16)(a12 + 1) - ppu->dot;
+            ppu->dot = a12 + 1;
+            mapper_ppu_a12(bus->mapper);
+        }
+        if (CROSSES(328)) { ppu_increment_x(ppu); }
+        if (CROSSES(336)) { ppu_increment_x(ppu); }
+    }
+    #undef CROSSES
+}
+
+void ppu_catch_up(PPU* ppu, Bus* bus, u64 cycle) {
+    u64 target = cycle * PPU_DOTS_PER_CPU_CYCLE;
+    while (ppu->dot_clock < target) {
+        u16 len = ppu_line_length(ppu);
+        u64 remaining = target - ppu->dot_clock;
+        u16 to = (remaining < (u64)(len - ppu->dot)) ? (u16)(ppu->dot + remaining) : len;
+        ppu_run_span(ppu, bus, ppu->dot, to);
+        ppu->dot_clock += to - ppu->dot;
+        ppu->dot = to;
+        if (to < len) { break; }
+
+        ppu->dot = 0;
+        if (++ppu->scanline == PPU_SCANLINES_PER_FRAME) {
+            ppu->scanline = 0;
+            ppu->frame++;
+            ppu->frame_start_dot = ppu->dot_clock;
+            ppu_schedule_vblank(ppu, bus);
+        }
+    }
+}
+
+u64 ppu_frame_end_cycle(const PPU* ppu) {
+    return ppu_dot_to_cycle(ppu->frame_start_dot + PPU_DOTS_PER_FRAME - 1);
+}
+
+u64 ppu_a12_edge_cycle(const PPU* ppu, u32 count) {
+    u16 a12 = ppu_a12_dot(ppu);
+    if (!ppu_rendering(ppu) || !a12 || count == 0) { return SCHEDULER_NEVER; }
+    u64 line_start = ppu->dot_clock - ppu->dot;
+    u16 line = ppu->scanline;
+    u64 frame = ppu->frame;
+    bool current = true;
+    for (;;) {
+        bool rendering_line = line < PPU_VISIBLE_SCANLINES || line == PPU_PRERENDER_SCANLINE;
+        if (rendering_line && (!current || ppu->dot <= a12) && --count == 0) {
+            return ppu_dot_to_cycle(line_start + a12);
+        }
+        current = false;
+        line_start += (line == PPU_PRERENDER_SCANLINE && (frame & 1)) ? PPU_DOTS_PER_SCANLINE - 1 : PPU_DOTS_PER_SCANLINE;
+        if (++line == PPU_SCANLINES_PER_FRAME) { line = 0; frame++; }
+    }
+}
+
+u64 ppu_status_stable_until(const PPU* ppu) {
+    bool watch_sprites = ppu_rendering(ppu) && (ppu->ppustatus & (PPUSTATUS_SPRITE0 | PPUSTATUS_OVERFLOW)) != (PPUSTATUS_SPRITE0 | PPUSTATUS_OVERFLOW);
+    u64 line_start = ppu->dot_clock - ppu->dot;
+    u16 line = ppu->scanline;
+    u16 from = ppu->dot; // First dot of the line not processed yet
+    for (;;) {
+        if (line < PPU_VISIBLE_SCANLINES && watch_sprites) {
+            // Sprite 0 and overflow are only known once the line is drawn at dot 1.
+            if (from <= 1) { return ppu_dot_to_cycle(line_start + 1); }
+            u16 dot = 0;
+            if (ppu->sprite0_dot >= from) { dot = ppu->sprite0_dot; }
+            if (ppu->overflow_pending && from <= 256 && (!dot || dot > 256)) { dot = 256; }
+            if (dot) { return ppu_dot_to_cycle(line_start + dot); }
+        }
+        if ((line == PPU_VBLANK_SCANLINE || line == PPU_PRERENDER_SCANLINE) && from <= 1) {
+            return ppu_dot_to_cycle(line_start + 1);
+        }
+        line_start += (line == ppu->scanline) ? ppu_line_length(ppu) : PPU_DOTS_PER_SCANLINE;
+        from = 0;
+        if (++line == PPU_SCANLINES_PER_FRAME) { line = 0; }
+    }
+}
+
+void ppu_position_at(const PPU* ppu, u64 cycle, u16* scanline, u16* dot) {
+    u64 target = cycle * PPU_DOTS_PER_CPU_CYCLE;
+    u64 offset = target > ppu->frame_start_dot ? target - ppu->frame_start_dot : 0;
+    // Only the odd frames' pre-render line is short, so lines keep their length until the
+    // end of a frame; whole frames in between are stepped over.
+    for (u64 frame = ppu->frame;; ++frame) {
+        u64 length = PPU_DOTS_PER_FRAME - (((frame & 1) && ppu_rendering(ppu)) ? 1 : 0);
+        if (offset < length) { break; }
+        offset -= length;
+    }
+    *scanline = (u16)(offset / PPU_DOTS_PER_SCANLINE);
+    *dot = (u16)(offset % PPU_DOTS_PER_SCANLINE);
+}
+
+// --- CPU-facing Registers ---
+u8 ppu_read(PPU* ppu, Bus* bus, u16 address) {
+    ppu_catch_up(ppu, bus, bus->cpu->cycles);
     u16 mirrored_addr = 0x2000 | (address & 0x0007);
     switch (mirrored_addr) {
         case 0x2002: {
-            u8 data = (ppu->ppustatus & 0xE0);
-            ppu->ppustatus &= ~0x80; // Clear VBlank flag after reading
+            u8 data = (ppu->ppustatus & 0xE0) | (ppu->io_latch & 0x1F);
+            ppu->ppustatus &= ~PPUSTATUS_VBLANK; // Clear VBlank flag after reading
+            ppu->w = false;
+            return data;
+        }
+        case 0x2004:
+            return ppu->oam[ppu->oamaddr];
+        case 0x2007: {
+            u16 addr = ppu->v & 0x3FFF;
+            u8 data;
+            if (addr < 0x3F00) {
+                data = ppu->data_buffer;
+                ppu->data_buffer = ppu_mem_read(ppu, bus, addr);
+            } else {
+                // Palette reads are immediate; the buffer gets the nametable byte underneath.
+                data = (ppu_mem_read(ppu, bus, addr) & 0x3F) | (ppu->io_latch & 0xC0);
+                ppu->data_buffer = ppu_mem_read(ppu, bus, addr - 0x1000);
+            }
+            ppu->v += (ppu->ppuctrl & 0x04) ? 32 : 1;
             return data;
         }
     }
-    return 0;
+    return ppu->io_latch;
 }
 
-void ppu_write(PPU* ppu, u16 address, u8 data) {
+void ppu_write(PPU* ppu, Bus* bus, u16 address, u8 data) {
+    ppu_catch_up(ppu, bus, bus->cpu->cycles);
+    ppu->io_latch = data;
     u16 mirrored_addr = 0x2000 | (address & 0x0007);
     switch (mirrored_addr) {
-        case 0x2000: ppu->ppuctrl = data; break;
-        case 0x2001: ppu->ppumask = data; break;
+        case 0x2000: {
+            // Enabling NMI while the vblank flag is still set fires an NMI right away.
+            bool nmi_enabled = (data & 0x80) && !(ppu->ppuctrl & 0x80);
+            ppu->ppuctrl = data;
+            ppu->t = (ppu->t & ~0x0C00) | ((u16)(data & 0x03) << 10);
+            if (nmi_enabled && (ppu->ppustatus & PPUSTATUS_VBLANK)) {
+                scheduler_schedule(bus->sched, EVENT_NMI, bus->cpu->cycles);
+            }
+            if (bus->mapper) { mapper_resync(bus->mapper); }
+            break;
+        }
+        case 0x2001:
+            if ((ppu->ppumask ^ data) & 0x01) { ppu->palette_dirty = true; } // Greyscale toggled
+            ppu->ppumask = data;
+            if (bus->mapper) { mapper_resync(bus->mapper); }
+            break;
+        case 0x2003: ppu->oamaddr = data; break;
+        case 0x2004: ppu->oam[ppu->oamaddr++] = data; break;
+        case 0x2005:
+            if (!ppu->w) {
+                ppu->t = (ppu->t & ~0x001F) | (data >> 3);
+                ppu->fine_x = data & 0x07;
+            } else {
+                ppu->t = (ppu->t & ~0x73E0) | ((u16)(data & 0x07) << 12) | ((u16)(data & 0xF8) << 2);
+            }
+            ppu->w = !ppu->w;
+            break;
+        case 0x2006:
+            if (!ppu->w) {
+                ppu->t = (ppu->t & 0x00FF) | ((u16)(data & 0x3F) << 8);
+            } else {
+                ppu->t = (ppu->t & 0xFF00) | data;
+                ppu->v = ppu->t;
+            }
+            ppu->w = !ppu->w;
+            break;
+        case 0x2007:
+            ppu_mem_write(ppu, bus, ppu->v, data);
+            ppu->v += (ppu->ppuctrl & 0x04) ? 32 : 1;
+            break;
     }
 }
\ No newline at end of file
@@ -2,11 +2,32 @@
 #define MYNES_C_PPU_H
 
 #include "common/types.h"
+#include "cartridge/cartridge.h"
 
 // Forward declare Bus. PPU functions will receive it as a parameter.
 typedef struct Bus Bus;
 
-typedef struct {
+// --- NTSC Timing ---
+// The PPU draws 262 scanlines of 341 dots per frame, at three dots per CPU cycle.
+#define PPU_DOTS_PER_SCANLINE 341
+#define PPU_SCANLINES_PER_FRAME 262
+#define PPU_DOTS_PER_FRAME (PPU_DOTS_PER_SCANLINE * PPU_SCANLINES_PER_FRAME)
+#define PPU_DOTS_PER_CPU_CYCLE 3
+#define PPU_VISIBLE_SCANLINES 240
+#define PPU_VBLANK_SCANLINE 241
+#define PPU_PRERENDER_SCANLINE 261
+
+// --- Output ---
+// 256x240 pixels, one 32-bit ARGB8888 value (0xAARRGGBB) per pixel, rows packed.
+#define PPU_SCREEN_WIDTH 256
+#define PPU_SCREEN_HEIGHT 240
+
+// --- PPUSTATUS Bits ---
+#define PPUSTATUS_OVERFLOW 0x20
+#define PPUSTATUS_SPRITE0  0x40
+#define PPUSTATUS_VBLANK   0x80
+
+typedef struct PPU {
     u8 vram[2048];
     u8 palette_ram[32];
     u8 oam[256]; // Object Attribute Memory
@@ -16,16 +37,89 @@ typedef struct {
     u8 ppumask;
     u8 ppustatus;
     u8 oamaddr;
+
+    // Internal scroll/address registers: current and temporary VRAM address, fine X
+    // scroll and the shared $2005/$2006 write toggle.
+    u16 v, t;
+    u8 fine_x;
+    bool w;
+    u8 data_buffer; // PPUDATA read buffer
+    u8 io_latch;    // Last value written to any register; read back from write-only ones
+
+    // Nametable mirroring: the four logical 1 KB nametables point into vram.
+    u8* nametables[4];
+    Mirroring mirroring;
+
+    // --- Catch-up Timing ---
+    // The PPU is not stepped with the CPU. It remembers the absolute dot (CPU cycle * 3) it
+    // has reached and ppu_catch_up() advances it in bulk when something observes it.
+    u64 dot_clock;
+    u64 frame_start_dot; // Absolute dot at which the current frame started
+    u16 scanline;        // 0-239 visible, 240 post-render, 241-260 vblank, 261 pre-render
+    u16 dot;             // 0-340 within the scanline
+    u64 frame;
+
+    // --- Renderer ---
+    // Scanlines are drawn whole when catch-up reaches their first dot (see ppu_render.c).
+    u32* framebuffer;       // PPU_SCREEN_WIDTH * PPU_SCREEN_HEIGHT pixels, or NULL to draw nothing
+    u32 render_interval;    // Draw 1 frame in N; the others only produce what $2002 reports
+    u32 palette_rgba[32];   // palette_ram resolved to ARGB through the master palette
+    bool palette_dirty;     // palette_rgba must be rebuilt before the next line
+    u16 sprite0_dot;        // Dot of the current line on which sprite 0 hits, 0 if it does not
+    bool overflow_pending;  // More than 8 sprites on the current line
     // No Bus* pointer here anymore!
 } PPU;
 
 // --- Function Prototypes ---
 void ppu_init(PPU* ppu);
-void ppu_reset(PPU* ppu);
-void ppu_step(PPU* ppu, Bus* bus);
+// Resets the registers, applies the cartridge's mirroring and queues the first vblank.
+void ppu_reset(PPU* ppu, Bus* bus);
+void ppu_set_mirroring(PPU* ppu, Mirroring mirroring);
+
+// PPU I/O functions are now called BY the bus. Both catch the PPU up first.
+u8 ppu_read(PPU* ppu, Bus* bus, u16 address);
+void ppu_write(PPU* ppu, Bus* bus, u16 address, u8 data);
+
+/**
+ * @brief Advances the PPU to CPU cycle 'cycle'.
+ * Work is done a scanline (or a span up to the next timing checkpoint) at a time, so the
+ * cost depends on how often the PPU is observed rather than on the number of dots.
+ */
+void ppu_catch_up(PPU* ppu, Bus* bus, u64 cycle);
+
+// Points the renderer at a PPU_SCREEN_WIDTH * PPU_SCREEN_HEIGHT pixel buffer (NULL to disable).
+void ppu_set_framebuffer(PPU* ppu, u32* framebuffer);
+
+// Draws only every 'interval'-th frame (1 draws them all). Skipped frames leave the framebuffer
+// alone but still set the sprite 0 hit and overflow flags on the same dots, and vblank, NMI
+// and the A12 clocks do not depend on drawing at all, so the CPU cannot tell the difference.
+void ppu_set_render_interval(PPU* ppu, u32 interval);
+
+// Whether the current frame is drawn into the framebuffer.
+static inline bool ppu_drawing(const PPU* ppu) {
+    return ppu->framebuffer && ppu->frame % ppu->render_interval == 0;
+}
+
+// Draws the current visible scanline. Called by ppu_catch_up() on dot 1 of lines 0-239.
+void ppu_render_scanline(PPU* ppu, Bus* bus);
+
+// CPU cycle by which the current frame will have ended.
+u64 ppu_frame_end_cycle(const PPU* ppu);
+
+/**
+ * @brief Predicts the CPU cycle by which the 'count'-th upcoming A12 rising edge has happened,
+ * assuming PPUCTRL/PPUMASK stay as they are. Returns SCHEDULER_NEVER if there are none.
+ * Lets mappers with scanline counters schedule their IRQ instead of watching every line.
+ */
+u64 ppu_a12_edge_cycle(const PPU* ppu, u32 count);
+
+// First CPU cycle at which reading $2002 could return something other than it does now
+// (vblank set or cleared, sprite 0 hit, sprite overflow), assuming no PPU register writes.
+// Lets the CPU fast-forward loops that poll PPUSTATUS.
+u64 ppu_status_stable_until(const PPU* ppu);
 
-// PPU I/O functions are now called BY the bus.
-u8 ppu_read(PPU* ppu, u16 address);
-void ppu_write(PPU* ppu, u16 address, u8 data);
+// Scanline and dot the PPU is at on the given CPU cycle, without catching it up (the PPU may
+// lag the CPU by up to a frame). Used by the instruction trace.
+void ppu_position_at(const PPU* ppu, u64 cycle, u16* scanline, u16* dot);
 
 #endif // MYNES_C_PPU_H
\ No newline at end of file
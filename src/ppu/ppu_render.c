@@ -0,0 +1,238 @@
+// The Golden Rule: Include your own header first.
+#include "ppu/ppu.h"
+
+#include "bus/bus.h"
+#include "mapper/mapper.h"
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define PPU_RENDER_SSE2 1
+#endif
+
+// --- Master Palette ---
+// The 64 colours of the 2C02, as 0xRRGGBB.
+static const u32 nes_palette[64] = {
+    0x666666, 0x002A88, 0x1412A7, 0x3B00A4, 0x5C007E, 0x6E0040, 0x6C0600, 0x561D00,
+    0x333500, 0x0B4800, 0x005200, 0x004F08, 0x00404D, 0x000000, 0x000000, 0x000000,
+    0xADADAD, 0x155FD9, 0x4240FF, 0x7527FE, 0xA01ACC, 0xB71E7B, 0xB53120, 0x994E00,
+    0x6B6D00, 0x388700, 0x0C9300, 0x008F32, 0x007C8D, 0x000000, 0x000000, 0x000000,
+    0xFFFEFF, 0x64B0FF, 0x9290FF, 0xC676FF, 0xF36AFF, 0xFE6ECC, 0xFE8170, 0xEA9E22,
+    0xBCBE00, 0x88D800, 0x5CE430, 0x45E082, 0x48CDDE, 0x4F4F4F, 0x000000, 0x000000,
+    0xFFFEFF, 0xC0DFFF, 0xD3D2FF, 0xE8C8FF, 0xFBC2FF, 0xFEC4EA, 0xFECCC5, 0xF7D8A5,
+    0xE4E594, 0xCFEF96, 0xBDF4AB, 0xB3F3CC, 0xB5EBF2, 0xB8B8B8, 0x000000, 0x000000,
+};
+
+// Sprite line bytes: bits 0-4 are the palette index (0 when transparent), bit 7 puts the
+// pixel behind the background.
+#define SPRITE_BEHIND 0x80
+
+// Byte lanes for SWAR work on a row of 8 decoded pixels.
+#define LANES_01 0x0101010101010101ULL
+
+static void ppu_build_palette(PPU* ppu) {
+    u8 grey = (ppu->ppumask & 0x01) ? 0x30 : 0x3F;
+    for (int i = 0; i < 32; ++i) {
+        ppu->palette_rgba[i] = 0xFF000000u | nes_palette[ppu->palette_ram[i] & grey];
+    }
+    ppu->palette_dirty = false;
+}
+
+// Adds the palette bits to a row of 8 two-bit pixels, leaving transparent pixels at 0.
+static inline u64 ppu_colour_row(u64 row, u8 palette) {
+    u64 opaque = ((row | (row >> 1)) & LANES_01) * 0xFF;
+    return (row | (LANES_01 * palette)) & opaque;
+}
+
+static inline u64 ppu_mirror_row(u64 row) {
+    u8 px[8];
+    memcpy(px, &row, 8);
+    for (int i = 0; i < 4; ++i) { u8 tmp = px[i]; px[i] = px[7 - i]; px[7 - i] = tmp; }
+    memcpy(&row, px, 8);
+    return row;
+}
+
+// --- Background ---
+// Fetches tiles [first, last) of the 33 that overlap the line into 'out' (tile i at out + i * 8)
+// and returns the offset of pixel 0. v has already been advanced two tiles by the previous
+// line's prefetch, so step back.
+static int ppu_fetch_background(PPU* ppu, const Mapper* mapper, u8* out, int first, int last) {
+    u16 v = ppu->v;
+    u32 x = ((u32)((v >> 10) & 1) << 8 | (u32)(v & 0x1F) << 3) + 512 - 16 + (u32)first * 8;
+    u16 fine_y = (v >> 12) & 7;
+    u16 coarse_y = (v >> 5) & 31;
+    u16 nt_y = v & 0x0800;
+    u16 table = (ppu->ppuctrl & 0x10) ? 0x1000 : 0x0000;
+
+    for (int i = first; i < last; ++i, x += 8) {
+        u16 coarse_x = (x >> 3) & 31;
+        const u8* nt = ppu->nametables[(nt_y | ((x & 0x100) << 2)) >> 10 & 3];
+        u8 tile = nt[coarse_y * 32 + coarse_x];
+        u8 attr = nt[0x3C0 | (coarse_y >> 2) << 3 | (coarse_x >> 2)];
+        attr = (attr >> (((coarse_y & 2) << 1) | (coarse_x & 2))) & 3;
+        u64 row;
+        memcpy(&row, mapper_tile_row(mapper, table + tile * CHR_TILE_BYTES, fine_y), 8);
+        row = ppu_colour_row(row, (u8)(attr << 2));
+        memcpy(out + i * 8, &row, 8);
+    }
+    return ppu->fine_x;
+}
+
+// --- Sprites ---
+// Decodes the 8 pixels of sprite 's' on row 'row' (0 = top) of its 8 or 16 line tall box.
+static u64 ppu_sprite_row(const PPU* ppu, const Mapper* mapper, const u8* s, int row, int height) {
+    u8 attr = s[2];
+    if (attr & 0x80) { row = height - 1 - row; }
+    u16 tile_index;
+    if (height == 16) { tile_index = (u16)(((s[1] & 1) << 8) | (s[1] & 0xFE)); if (row >= 8) { tile_index++; row -= 8; } }
+    else { tile_index = (u16)(((ppu->ppuctrl & 0x08) ? 256 : 0) + s[1]); }
+
+    u64 bits;
+    memcpy(&bits, mapper_tile_row(mapper, tile_index * CHR_TILE_BYTES, row), 8);
+    if (attr & 0x40) { bits = ppu_mirror_row(bits); }
+    return ppu_colour_row(bits, (u8)(0x10 | (attr & 3) << 2));
+}
+
+// Evaluates OAM for the current line and draws up to 8 sprites into 'out'. Lower OAM indices
+// win, so a pixel is only written while still transparent. Returns sprite 0's x, or -1.
+static int ppu_draw_sprites(PPU* ppu, const Mapper* mapper, u8* out, u8* sprite0_row) {
+    int height = (ppu->ppuctrl & 0x20) ? 16 : 8;
+    int sprite0_x = -1;
+    int count = 0;
+    for (int i = 0; i < 64; ++i) {
+        const u8* s = &ppu->oam[i * 4];
+        int row = (int)ppu->scanline - (int)s[0] - 1;
+        if (row < 0 || row >= height) { continue; }
+        if (count == 8) { ppu->overflow_pending = true; break; }
+        count++;
+
+        u64 bits = ppu_sprite_row(ppu, mapper, s, row, height);
+        u8 px[8];
+        memcpy(px, &bits, 8);
+        if (i == 0) { sprite0_x = s[3]; memcpy(sprite0_row, px, 8); }
+
+        u8 behind = (s[2] & 0x20) ? SPRITE_BEHIND : 0;
+        for (int p = 0; p < 8; ++p) {
+            int x = s[3] + p;
+            if (x < PPU_SCREEN_WIDTH && px[p] && !out[x]) { out[x] = px[p] | behind; }
+        }
+    }
+    return sprite0_x;
+}
+
+// Sprite 0 hit: first opaque overlap, never at x = 255 or inside a clipped left edge. 'bg' is
+// indexed by screen x and only has to be valid under the sprite.
+static void ppu_sprite0_hit(PPU* ppu, int sprite0_x, const u8* sprite0_row, const u8* bg) {
+    int left = ((ppu->ppumask & 0x06) == 0x06) ? 0 : 8;
+    for (int p = 0; p < 8; ++p) {
+        int x = sprite0_x + p;
+        if (x >= 255) { break; }
+        if (x >= left && sprite0_row[p] && bg[x]) { ppu->sprite0_dot = (u16)(x + 1); break; }
+    }
+}
+
+// --- Composition ---
+// Picks the sprite pixel where it is opaque and either in front or over background colour 0.
+static void ppu_compose(const u8* bg, const u8* spr, u8* out) {
+    int x = 0;
+#if defined(__AVX2__) || defined(PPU_RENDER_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i colour_mask = _mm_set1_epi8(0x1F);
+    const __m128i behind_mask = _mm_set1_epi8((char)SPRITE_BEHIND);
+    for (; x < PPU_SCREEN_WIDTH; x += 16) {
+        __m128i b = _mm_loadu_si128((const __m128i*)(bg + x));
+        __m128i s = _mm_loadu_si128((const __m128i*)(spr + x));
+        __m128i colour = _mm_and_si128(s, colour_mask);
+        __m128i transparent = _mm_cmpeq_epi8(colour, zero);
+        __m128i in_front = _mm_cmpeq_epi8(_mm_and_si128(s, behind_mask), zero);
+        __m128i use_sprite = _mm_andnot_si128(transparent, _mm_or_si128(in_front, _mm_cmpeq_epi8(b, zero)));
+        _mm_storeu_si128((__m128i*)(out + x), _mm_or_si128(_mm_and_si128(use_sprite, colour), _mm_andnot_si128(use_sprite, b)));
+    }
+#endif
+    for (; x < PPU_SCREEN_WIDTH; ++x) {
+        u8 colour = spr[x] & 0x1F;
+        out[x] = (colour && (!(spr[x] & SPRITE_BEHIND) || !bg[x])) ? colour : bg[x];
+    }
+}
+
+// Resolves a line of palette indices to pixels through the 32-entry table.
+static void ppu_resolve(const u32* palette, const u8* line, u32* dst) {
+    int x = 0;
+#if defined(__AVX2__)
+    for (; x < PPU_SCREEN_WIDTH; x += 8) {
+        __m128i idx8 = _mm_loadl_epi64((const __m128i*)(line + x));
+        __m256i idx = _mm256_cvtepu8_epi32(idx8);
+        _mm256_storeu_si256((__m256i*)(dst + x), _mm256_i32gather_epi32((const int*)palette, idx, 4));
+    }
+#endif
+    for (; x < PPU_SCREEN_WIDTH; ++x) { dst[x] = palette[line[x]]; }
+}
+
+// --- Skipped Lines ---
+// A line that is not drawn still produces everything $2002 reports: the overflow flag needs
+// only the count of sprites in range, and the sprite 0 hit only sprite 0's row and the one or
+// two background tiles beneath it.
+static void ppu_evaluate_scanline(PPU* ppu, const Mapper* mapper) {
+    if (!(ppu->ppumask & 0x10)) { return; }
+    int height = (ppu->ppuctrl & 0x20) ? 16 : 8;
+    int count = 0;
+    for (int i = 0; i < 64; ++i) {
+        int row = (int)ppu->scanline - (int)ppu->oam[i * 4] - 1;
+        if (row < 0 || row >= height) { continue; }
+        if (count == 8) { ppu->overflow_pending = true; break; }
+        count++;
+    }
+
+    const u8* s = ppu->oam;
+    int row = (int)ppu->scanline - (int)s[0] - 1;
+    if (!(ppu->ppumask & 0x08) || row < 0 || row >= height) { return; }
+    u64 bits = ppu_sprite_row(ppu, mapper, s, row, height);
+    if (!bits) { return; }
+    u8 sprite0_row[8];
+    memcpy(sprite0_row, &bits, 8);
+
+    u8 bg_tiles[33 * 8];
+    int first = (ppu->fine_x + s[3]) >> 3;
+    int last = (ppu->fine_x + s[3] + 7) / 8 + 1;
+    int offset = ppu_fetch_background(ppu, mapper, bg_tiles, first, last < 33 ? last : 33);
+    ppu_sprite0_hit(ppu, s[3], sprite0_row, bg_tiles + offset);
+}
+
+void ppu_render_scanline(PPU* ppu, Bus* bus) {
+    ppu->sprite0_dot = 0;
+    ppu->overflow_pending = false;
+    Mapper* mapper = bus->mapper;
+    if (!mapper) { return; }
+    cartridge_refresh_chr(mapper->cart);
+    if (!ppu_drawing(ppu)) {
+        ppu_evaluate_scanline(ppu, mapper);
+        return;
+    }
+    if (ppu->palette_dirty) { ppu_build_palette(ppu); }
+
+    u8 bg_tiles[33 * 8];
+    u8 sprites[PPU_SCREEN_WIDTH];
+    u8 line[PPU_SCREEN_WIDTH];
+    const u8* bg = line; // All zero (backdrop) when the background is off
+    memset(line, 0, sizeof(line));
+    memset(sprites, 0, sizeof(sprites));
+
+    bool show_bg = (ppu->ppumask & 0x08) != 0;
+    bool show_sprites = (ppu->ppumask & 0x10) != 0;
+    if (show_bg) {
+        bg = bg_tiles + ppu_fetch_background(ppu, mapper, bg_tiles, 0, 33);
+        if (!(ppu->ppumask & 0x02)) { memset(bg_tiles + ppu->fine_x, 0, 8); }
+    }
+    if (show_sprites) {
+        u8 sprite0_row[8];
+        int sprite0_x = ppu_draw_sprites(ppu, mapper, sprites, sprite0_row);
+        if (!(ppu->ppumask & 0x04)) { memset(sprites, 0, 8); }
+
+        if (sprite0_x >= 0 && show_bg) { ppu_sprite0_hit(ppu, sprite0_x, sprite0_row, bg); }
+    }
+
+    ppu_compose(bg, sprites, line);
+    ppu_resolve(ppu->palette_rgba, line, ppu->framebuffer + ppu->scanline * PPU_SCREEN_WIDTH);
+}
\ No newline at end of file
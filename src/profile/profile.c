@@ -0,0 +1,246 @@
+// The Golden Rule: Include your own header first.
+#include "profile/profile.h"
+
+#if MYNES_PROFILE
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cpu/cpu.h"
+#include "cpu/cpu_opcodes.h"
+
+_Thread_local ProfileCounters* profile_thread;
+
+static pthread_mutex_t profile_lock = PTHREAD_MUTEX_INITIALIZER;
+static ProfileCounters* profile_threads; // Every block ever attached; never freed, so the
+                                         // counts of finished worker threads are kept.
+static const char* profile_json_path;
+static atomic_int profile_requested;
+
+// --- Opcode Metadata ---
+#define PROFILE_NAME(code, kind, op, mode, cyc) #op,
+static const char* const op_names[256] = { CPU_OPCODE_TABLE(PROFILE_NAME) };
+#undef PROFILE_NAME
+#define PROFILE_MODE(code, kind, op, mode, cyc) AM_##mode,
+static const u8 op_modes[256] = { CPU_OPCODE_TABLE(PROFILE_MODE) };
+#undef PROFILE_MODE
+
+#define PROFILE_MODE_COUNT (AM_IZY + 1)
+static const char* const mode_names[PROFILE_MODE_COUNT] = {
+    "IMP", "ACC", "IMM", "ZP0", "ZPX", "ZPY", "REL", "ABS", "ABX", "ABY", "IND", "IZX", "IZY",
+};
+static const char* const region_names[PROFILE_REGION_COUNT] = {
+    "ram", "ppu", "apu_io", "expansion", "prg_ram", "prg",
+};
+
+#define PROFILE_TOP_TEXT 20
+#define PROFILE_TOP_JSON 256
+
+ProfileCounters* profile_attach(void) {
+    ProfileCounters* p = calloc(1, sizeof(ProfileCounters));
+    if (!p) {
+        fprintf(stderr, "Profiler: out of memory.\n");
+        abort();
+    }
+    pthread_mutex_lock(&profile_lock);
+    p->next = profile_threads;
+    profile_threads = p;
+    pthread_mutex_unlock(&profile_lock);
+    profile_thread = p;
+    return p;
+}
+
+// --- Report ---
+typedef struct {
+    u32 key;
+    u64 count;
+    u64 cycles;
+} ProfileRow;
+
+static int compare_rows(const void* a, const void* b) {
+    const ProfileRow* x = a;
+    const ProfileRow* y = b;
+    if (x->cycles != y->cycles) { return x->cycles < y->cycles ? 1 : -1; }
+    return x->key < y->key ? -1 : x->key > y->key;
+}
+
+// Collects the non-zero entries of a counter pair, sorted by cycles (descending).
+static u32 collect_rows(ProfileRow* rows, const u64* count, const u64* cycles, u32 n) {
+    u32 used = 0;
+    for (u32 i = 0; i < n; ++i) {
+        if (count[i] == 0) { continue; }
+        rows[used++] = (ProfileRow){ i, count[i], cycles[i] };
+    }
+    qsort(rows, used, sizeof(ProfileRow), compare_rows);
+    return used;
+}
+
+static double share(u64 part, u64 whole) { return whole ? 100.0 * (double)part / (double)whole : 0.0; }
+
+static void write_text(FILE* out, const ProfileCounters* t, u32 threads, const ProfileRow* ops, u32 op_rows,
+                       const ProfileRow* modes, u32 mode_rows, const ProfileRow* pcs, u32 pc_rows,
+                       u64 instructions, u64 cycles) {
+    fprintf(out, "--- Profile: %llu instructions, %llu cycles, %llu idle-skipped cycles, %u thread(s) ---\n",
+            (unsigned long long)instructions, (unsigned long long)cycles, (unsigned long long)t->idle_cycles, threads);
+
+    fprintf(out, "Opcodes by cycles:\n    op  name mode       count        cycles   cyc%%  cyc/ins\n");
+    for (u32 i = 0; i < op_rows && i < PROFILE_TOP_TEXT; ++i) {
+        const ProfileRow* r = &ops[i];
+        fprintf(out, "    %02X  %-4s %-4s %12llu  %12llu  %5.1f  %7.2f\n", r->key, op_names[r->key],
+                mode_names[op_modes[r->key]], (unsigned long long)r->count, (unsigned long long)r->cycles,
+                share(r->cycles, cycles), (double)r->cycles / (double)r->count);
+    }
+
+    fprintf(out, "Addressing modes:\n    mode       count        cycles   cyc%%\n");
+    for (u32 i = 0; i < mode_rows; ++i) {
+        const ProfileRow* r = &modes[i];
+        fprintf(out, "    %-4s %12llu  %12llu  %5.1f\n", mode_names[r->key], (unsigned long long)r->count,
+                (unsigned long long)r->cycles, share(r->cycles, cycles));
+    }
+
+    fprintf(out, "Hot PCs:\n    pc          count        cycles   cyc%%\n");
+    for (u32 i = 0; i < pc_rows && i < PROFILE_TOP_TEXT; ++i) {
+        const ProfileRow* r = &pcs[i];
+        fprintf(out, "    $%04X %12llu  %12llu  %5.1f\n", r->key, (unsigned long long)r->count,
+                (unsigned long long)r->cycles, share(r->cycles, cycles));
+    }
+
+    fprintf(out, "Memory accesses:\n    region          reads        writes\n");
+    for (u32 i = 0; i < PROFILE_REGION_COUNT; ++i) {
+        fprintf(out, "    %-10s %12llu  %12llu\n", region_names[i], (unsigned long long)t->reads[i],
+                (unsigned long long)t->writes[i]);
+    }
+}
+
+static void write_json_rows(FILE* out, const char* name, const ProfileRow* rows, u32 count, bool opcodes) {
+    fprintf(out, "  \"%s\": [", name);
+    for (u32 i = 0; i < count; ++i) {
+        const ProfileRow* r = &rows[i];
+        fprintf(out, "%s\n    {", i ? "," : "");
+        if (opcodes) {
+            fprintf(out, "\"opcode\": %u, \"name\": \"%s\", \"mode\": \"%s\", ", r->key, op_names[r->key], mode_names[op_modes[r->key]]);
+        } else {
+            fprintf(out, "\"pc\": %u, ", r->key);
+        }
+        fprintf(out, "\"count\": %llu, \"cycles\": %llu}", (unsigned long long)r->count, (unsigned long long)r->cycles);
+    }
+    fprintf(out, "\n  ],\n");
+}
+
+static bool write_json(const char* path, const ProfileCounters* t, u32 threads, const ProfileRow* ops, u32 op_rows,
+                       const ProfileRow* modes, u32 mode_rows, const ProfileRow* pcs, u32 pc_rows,
+                       u64 instructions, u64 cycles) {
+    FILE* out = fopen(path, "w");
+    if (!out) {
+        perror(path);
+        return false;
+    }
+    fprintf(out, "{\n  \"threads\": %u,\n  \"instructions\": %llu,\n  \"cycles\": %llu,\n  \"idle_cycles\": %llu,\n",
+            threads, (unsigned long long)instructions, (unsigned long long)cycles, (unsigned long long)t->idle_cycles);
+    write_json_rows(out, "opcodes", ops, op_rows, true);
+    fprintf(out, "  \"modes\": [");
+    for (u32 i = 0; i < mode_rows; ++i) {
+        fprintf(out, "%s\n    {\"mode\": \"%s\", \"count\": %llu, \"cycles\": %llu}", i ? "," : "",
+                mode_names[modes[i].key], (unsigned long long)modes[i].count, (unsigned long long)modes[i].cycles);
+    }
+    fprintf(out, "\n  ],\n");
+    write_json_rows(out, "hot_pcs", pcs, pc_rows < PROFILE_TOP_JSON ? pc_rows : PROFILE_TOP_JSON, false);
+    fprintf(out, "  \"memory\": {");
+    for (u32 i = 0; i < PROFILE_REGION_COUNT; ++i) {
+        fprintf(out, "%s\n    \"%s\": {\"reads\": %llu, \"writes\": %llu}", i ? "," : "", region_names[i],
+                (unsigned long long)t->reads[i], (unsigned long long)t->writes[i]);
+    }
+    fprintf(out, "\n  }\n}\n");
+    bool ok = fclose(out) == 0;
+    if (!ok) { fprintf(stderr, "Failed to write profile to %s\n", path); }
+    return ok;
+}
+
+void profile_report(FILE* text, const char* json_path) {
+    ProfileCounters* total = calloc(1, sizeof(ProfileCounters));
+    ProfileRow* pcs = malloc(0x10000 * sizeof(ProfileRow));
+    if (!total || !pcs) {
+        free(total);
+        free(pcs);
+        fprintf(stderr, "Profiler: out of memory for the report.\n");
+        return;
+    }
+
+    // Merge every thread's counters. Threads still running keep counting meanwhile, so a
+    // report taken mid-run is a close snapshot rather than an exact one.
+    u32 threads = 0;
+    pthread_mutex_lock(&profile_lock);
+    for (const ProfileCounters* p = profile_threads; p; p = p->next, ++threads) {
+        for (u32 i = 0; i < 256; ++i) {
+            total->op_count[i] += p->op_count[i];
+            total->op_cycles[i] += p->op_cycles[i];
+        }
+        for (u32 i = 0; i < 0x10000; ++i) {
+            total->pc_count[i] += p->pc_count[i];
+            total->pc_cycles[i] += p->pc_cycles[i];
+        }
+        for (u32 i = 0; i < PROFILE_REGION_COUNT; ++i) {
+            total->reads[i] += p->reads[i];
+            total->writes[i] += p->writes[i];
+        }
+        total->idle_cycles += p->idle_cycles;
+    }
+    pthread_mutex_unlock(&profile_lock);
+
+    u64 instructions = 0;
+    u64 cycles = 0;
+    u64 mode_count[PROFILE_MODE_COUNT] = { 0 };
+    u64 mode_cycles[PROFILE_MODE_COUNT] = { 0 };
+    for (u32 i = 0; i < 256; ++i) {
+        instructions += total->op_count[i];
+        cycles += total->op_cycles[i];
+        mode_count[op_modes[i]] += total->op_count[i];
+        mode_cycles[op_modes[i]] += total->op_cycles[i];
+    }
+
+    ProfileRow ops[256];
+    ProfileRow modes[PROFILE_MODE_COUNT];
+    u32 op_rows = collect_rows(ops, total->op_count, total->op_cycles, 256);
+    u32 mode_rows = collect_rows(modes, mode_count, mode_cycles, PROFILE_MODE_COUNT);
+    u32 pc_rows = collect_rows(pcs, total->pc_count, total->pc_cycles, 0x10000);
+
+    if (text) {
+        write_text(text, total, threads, ops, op_rows, modes, mode_rows, pcs, pc_rows, instructions, cycles);
+        fflush(text);
+    }
+    if (json_path) { write_json(json_path, total, threads, ops, op_rows, modes, mode_rows, pcs, pc_rows, instructions, cycles); }
+    free(pcs);
+    free(total);
+}
+
+// --- Triggers ---
+static void profile_at_exit(void) {
+    profile_report(profile_json_path ? NULL : stderr, profile_json_path);
+}
+
+#ifdef SIGUSR1
+// Only raises the flag: the report is written from profile_poll(), outside the handler.
+static void profile_signal(int sig) {
+    (void)sig;
+    atomic_store(&profile_requested, 1);
+}
+#endif
+
+void profile_install(const char* json_path) {
+    static bool installed = false;
+    profile_json_path = json_path;
+    if (installed) { return; }
+    installed = true;
+    atexit(profile_at_exit);
+#ifdef SIGUSR1
+    signal(SIGUSR1, profile_signal);
+#endif
+}
+
+void profile_poll(void) {
+    if (atomic_load_explicit(&profile_requested, memory_order_relaxed) && atomic_exchange(&profile_requested, 0)) {
+        profile_report(profile_json_path ? NULL : stderr, profile_json_path);
+    }
+}
+#endif // MYNES_PROFILE
\ No newline at end of file
@@ -0,0 +1,90 @@
+#ifndef MYNES_C_PROFILE_H
+#define MYNES_C_PROFILE_H
+
+#include <stdio.h>
+#include "common/types.h"
+
+// --- Execution Profiler ---
+// Builds with -DMYNES_PROFILE=1 (make PROFILE=1) count, for every instruction executed,
+// its opcode and cycles and the PC it ran at, and every bus_read()/bus_write() by memory
+// region. Counters live in per-thread blocks (allocated on a thread's first instruction), so
+// instances running on different threads never share a cache line; the report merges all
+// threads. Addressing-mode totals are derived from the opcode counters when reporting.
+//
+// The report goes to stderr (or JSON to a file) at exit and whenever SIGUSR1 arrives; the
+// signal only raises a flag, and the dump happens at the next frame boundary. A dump taken
+// while other threads run is a snapshot that may be slightly behind them.
+//
+// With profiling off, the hooks below expand to nothing and the functions are empty inlines.
+#ifndef MYNES_PROFILE
+#define MYNES_PROFILE 0
+#endif
+
+typedef enum {
+    PROFILE_RAM,       // $0000-$1FFF
+    PROFILE_PPU,       // $2000-$3FFF
+    PROFILE_APU_IO,    // $4000-$401F
+    PROFILE_EXPANSION, // $4020-$5FFF
+    PROFILE_PRG_RAM,   // $6000-$7FFF
+    PROFILE_PRG,       // $8000-$FFFF: reads are PRG ROM, writes are mapper registers
+    PROFILE_REGION_COUNT
+} ProfileRegion;
+
+typedef struct ProfileCounters {
+    u64 op_count[256];
+    u64 op_cycles[256];
+    u64 pc_count[0x10000];
+    u64 pc_cycles[0x10000];
+    u64 reads[PROFILE_REGION_COUNT];
+    u64 writes[PROFILE_REGION_COUNT];
+    u64 idle_cycles;   // Cycles fast-forwarded by idle loop skipping (not in the counters above)
+    struct ProfileCounters* next; // Registry of every thread's block
+} ProfileCounters;
+
+#if MYNES_PROFILE
+extern _Thread_local ProfileCounters* profile_thread;
+// Allocates and registers the calling thread's counters.
+ProfileCounters* profile_attach(void);
+
+static inline ProfileCounters* profile_counters(void) {
+    ProfileCounters* p = profile_thread;
+    return p ? p : profile_attach();
+}
+
+static inline ProfileRegion profile_region(u16 address) {
+    static const u8 regions[8] = { PROFILE_RAM, PROFILE_PPU, PROFILE_APU_IO, PROFILE_PRG_RAM,
+                                   PROFILE_PRG, PROFILE_PRG, PROFILE_PRG, PROFILE_PRG };
+    if ((address >> 13) == 2 && address >= 0x4020) { return PROFILE_EXPANSION; }
+    return (ProfileRegion)regions[address >> 13];
+}
+
+static inline void profile_instruction(u8 opcode, u16 pc, u64 cycles) {
+    ProfileCounters* p = profile_counters();
+    p->op_count[opcode]++;
+    p->op_cycles[opcode] += cycles;
+    p->pc_count[pc]++;
+    p->pc_cycles[pc] += cycles;
+}
+
+#define PROFILE_READ(address) (profile_counters()->reads[profile_region(address)]++)
+#define PROFILE_WRITE(address) (profile_counters()->writes[profile_region(address)]++)
+#define PROFILE_IDLE(cycles) (profile_counters()->idle_cycles += (cycles))
+
+/**
+ * @brief Arranges for the report to be written at exit and on SIGUSR1.
+ * @param json_path Write JSON here instead of a text report on stderr (may be NULL).
+ */
+void profile_install(const char* json_path);
+// Writes the report now if SIGUSR1 asked for one. Called once per frame.
+void profile_poll(void);
+// Writes the merged report: as text to 'text' (if not NULL), and as JSON to 'json_path'.
+void profile_report(FILE* text, const char* json_path);
+#else
+#define PROFILE_READ(address) ((void)0)
+#define PROFILE_WRITE(address) ((void)0)
+#define PROFILE_IDLE(cycles) ((void)0)
+static inline void profile_install(const char* json_path) { (void)json_path; }
+static inline void profile_poll(void) {}
+#endif
+
+#endif // MYNES_C_PROFILE_H
\ No newline at end of file
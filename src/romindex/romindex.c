@@ -0,0 +1,135 @@
+// The Golden Rule: Include your own header first.
+#include "romindex/romindex.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cartridge/cartridge.h"
+#include "mapper/mapper.h"
+
+_Static_assert(sizeof(RomIndexEntry) == 64, "index entries are a fixed 64 bytes");
+
+bool rom_index_classify(RomIndexEntry* entry, const u8* data, size_t len) {
+    RomInfo info;
+    if (!rom_parse_header(data, len, &info)) { return false; }
+    const u8* rom = data + info.rom_offset;
+    size_t rom_len = (size_t)info.prg_rom_len + info.chr_rom_len;
+
+    entry->file_crc32 = crc32_update(0, data, len);
+    entry->crc32 = crc32_update(0, rom, rom_len);
+    Sha1 sha;
+    sha1_init(&sha);
+    sha1_update(&sha, rom, rom_len);
+    sha1_final(&sha, entry->sha1);
+
+    entry->prg_rom_len = info.prg_rom_len;
+    entry->chr_rom_len = info.chr_rom_len;
+    entry->mapper_id = info.mapper_id;
+    entry->submapper = info.submapper;
+    entry->format = (u8)info.format;
+    entry->mirroring = (u8)info.mirroring;
+    entry->timing = (u8)info.timing;
+    entry->flags = (info.has_battery ? ROM_INDEX_BATTERY : 0) | (info.has_trainer ? ROM_INDEX_TRAINER : 0) |
+                   (mapper_find(info.mapper_id) ? ROM_INDEX_SUPPORTED : 0);
+    return true;
+}
+
+// --- Writing ---
+typedef struct {
+    RomIndexEntry entry;
+    const char* path;
+} SortItem;
+
+static int compare_items(const void* a, const void* b) {
+    const SortItem* x = (const SortItem*)a;
+    const SortItem* y = (const SortItem*)b;
+    if (x->entry.crc32 != y->entry.crc32) { return x->entry.crc32 < y->entry.crc32 ? -1 : 1; }
+    return strcmp(x->path, y->path);
+}
+
+bool rom_index_write(const char* path, RomIndexEntry* entries, const char* const* paths, u32 count) {
+    SortItem* items = (SortItem*)malloc((count ? count : 1) * sizeof(SortItem));
+    if (!items) { return false; }
+    for (u32 i = 0; i < count; ++i) { items[i] = (SortItem){ entries[i], paths[i] }; }
+    qsort(items, count, sizeof(SortItem), compare_items);
+
+    RomIndexHeader header;
+    memcpy(header.magic, ROM_INDEX_MAGIC, 4);
+    header.version = ROM_INDEX_VERSION;
+    header.count = count;
+    header.strings_size = 0;
+    for (u32 i = 0; i < count; ++i) {
+        entries[i] = items[i].entry;
+        entries[i].path_offset = header.strings_size;
+        header.strings_size += (u32)strlen(items[i].path) + 1;
+    }
+
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        perror("Failed to open index for writing");
+        free(items);
+        return false;
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    if (ok && count) { ok = fwrite(entries, sizeof(RomIndexEntry), count, file) == count; }
+    for (u32 i = 0; ok && i < count; ++i) { ok = fwrite(items[i].path, strlen(items[i].path) + 1, 1, file) == 1; }
+    if (fclose(file) != 0) { ok = false; }
+    if (!ok) { fprintf(stderr, "Failed to write index %s\n", path); }
+    free(items);
+    return ok;
+}
+
+// --- Lookups ---
+bool rom_index_open(RomIndex* index, const char* path) {
+    memset(index, 0, sizeof(RomIndex));
+    if (!file_map_open(&index->file, path)) { return false; }
+    const u8* data = index->file.data;
+    size_t size = index->file.size;
+    RomIndexHeader header;
+    if (size >= sizeof(header)) { memcpy(&header, data, sizeof(header)); }
+    if (size < sizeof(header) || memcmp(header.magic, ROM_INDEX_MAGIC, 4) != 0 || header.version != ROM_INDEX_VERSION ||
+        (u64)header.count * sizeof(RomIndexEntry) + header.strings_size != size - sizeof(header) ||
+        (header.strings_size && data[size - 1] != '\0')) {
+        fprintf(stderr, "Not a compatible ROM index: %s\n", path);
+        rom_index_close(index);
+        return false;
+    }
+    index->entries = (const RomIndexEntry*)(data + sizeof(header));
+    index->count = header.count;
+    index->strings = (const char*)(index->entries + header.count);
+    index->strings_size = header.strings_size;
+    return true;
+}
+
+void rom_index_close(RomIndex* index) {
+    file_map_close(&index->file);
+    memset(index, 0, sizeof(RomIndex));
+}
+
+const char* rom_index_path(const RomIndex* index, const RomIndexEntry* entry) {
+    return entry->path_offset < index->strings_size ? index->strings + entry->path_offset : "";
+}
+
+const RomIndexEntry* rom_index_find_crc32(const RomIndex* index, u32 crc32) {
+    u32 lo = 0, hi = index->count;
+    while (lo < hi) {
+        u32 mid = lo + (hi - lo) / 2;
+        if (index->entries[mid].crc32 < crc32) { lo = mid + 1; }
+        else { hi = mid; }
+    }
+    return (lo < index->count && index->entries[lo].crc32 == crc32) ? &index->entries[lo] : NULL;
+}
+
+const RomIndexEntry* rom_index_find_sha1(const RomIndex* index, const u8 sha1[SHA1_DIGEST_SIZE]) {
+    for (u32 i = 0; i < index->count; ++i) {
+        if (memcmp(index->entries[i].sha1, sha1, SHA1_DIGEST_SIZE) == 0) { return &index->entries[i]; }
+    }
+    return NULL;
+}
+
+const RomIndexEntry* rom_index_find_path(const RomIndex* index, const char* path) {
+    for (u32 i = 0; i < index->count; ++i) {
+        if (strcmp(rom_index_path(index, &index->entries[i]), path) == 0) { return &index->entries[i]; }
+    }
+    return NULL;
+}
\ No newline at end of file
@@ -0,0 +1,83 @@
+#ifndef MYNES_C_ROMINDEX_H
+#define MYNES_C_ROMINDEX_H
+
+#include <stddef.h>
+#include "common/types.h"
+#include "common/file_map.h"
+#include "common/hash.h"
+
+// --- ROM Corpus Index ---
+// A compact on-disk catalogue of a ROM library: for every file, its checksums, header
+// classification and the size/mtime it had when it was hashed. The file is one header, an
+// array of fixed 64-byte entries sorted by ROM CRC32, and a string table of paths, all in
+// host byte order. It is memory-mapped for lookups, so finding a ROM by checksum is a binary
+// search over the mapping and never touches the ROM files themselves.
+#define ROM_INDEX_MAGIC "MNIX"
+#define ROM_INDEX_VERSION 1
+
+typedef struct RomIndexHeader {
+    char magic[4];
+    u32 version;
+    u32 count;        // Entries following the header
+    u32 strings_size; // Bytes of NUL-terminated paths following the entries
+} RomIndexHeader;
+
+enum {
+    ROM_INDEX_BATTERY = 0x01,
+    ROM_INDEX_TRAINER = 0x02,
+    ROM_INDEX_SUPPORTED = 0x04, // This emulator has the board
+};
+
+typedef struct RomIndexEntry {
+    u32 crc32;              // CRC32 of PRG + CHR ROM (header and trainer excluded), the database key
+    u32 file_crc32;         // CRC32 of the whole file
+    u8 sha1[SHA1_DIGEST_SIZE]; // SHA-1 of PRG + CHR ROM
+    u32 path_offset;        // Into the string table
+    u64 file_size;
+    s64 mtime;              // Modification time when hashed; with file_size, detects changes
+    u32 prg_rom_len;
+    u32 chr_rom_len;
+    u16 mapper_id;
+    u8 submapper;
+    u8 format;              // RomFormat
+    u8 mirroring;           // Mirroring
+    u8 timing;              // RomTiming
+    u8 flags;               // ROM_INDEX_*
+    u8 reserved;
+} RomIndexEntry;
+
+typedef struct RomIndex {
+    FileMap file;
+    const RomIndexEntry* entries;
+    u32 count;
+    const char* strings;
+    u32 strings_size;
+} RomIndex;
+
+// --- Function Prototypes ---
+
+/**
+ * @brief Hashes and classifies one ROM file's contents into 'entry'.
+ * The path, size and mtime fields are left to the caller.
+ * @return false if the data is not a valid .nes file.
+ */
+bool rom_index_classify(RomIndexEntry* entry, const u8* data, size_t len);
+
+/**
+ * @brief Writes an index of 'count' entries; paths[i] is the path of entries[i].
+ * Sorts 'entries' (and fills in their path offsets) as a side effect.
+ */
+bool rom_index_write(const char* path, RomIndexEntry* entries, const char* const* paths, u32 count);
+
+// Maps an index file for lookups. Returns false if it is missing or not a valid index.
+bool rom_index_open(RomIndex* index, const char* path);
+void rom_index_close(RomIndex* index);
+
+const char* rom_index_path(const RomIndex* index, const RomIndexEntry* entry);
+
+// The first entry with this ROM CRC32 (duplicates are adjacent), or NULL.
+const RomIndexEntry* rom_index_find_crc32(const RomIndex* index, u32 crc32);
+const RomIndexEntry* rom_index_find_sha1(const RomIndex* index, const u8 sha1[SHA1_DIGEST_SIZE]);
+const RomIndexEntry* rom_index_find_path(const RomIndex* index, const char* path);
+
+#endif // MYNES_C_ROMINDEX_H
\ No newline at end of file
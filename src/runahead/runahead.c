@@ -0,0 +1,91 @@
+// The Golden Rule: Include your own header first.
+#include "runahead/runahead.h"
+
+#include <string.h>
+#include <time.h>
+
+static double run_ahead_now(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+void run_ahead_init(RunAhead* ra, u32 frames) {
+    memset(ra, 0, sizeof(RunAhead));
+    run_ahead_set_frames(ra, frames);
+}
+
+void run_ahead_set_frames(RunAhead* ra, u32 frames) {
+    ra->frames = frames < RUN_AHEAD_MAX_FRAMES ? frames : RUN_AHEAD_MAX_FRAMES;
+}
+
+void run_ahead_reset_stats(RunAhead* ra) {
+    ra->count = 0;
+    ra->real_seconds = 0.0;
+    ra->ahead_seconds = 0.0;
+    ra->snapshot_seconds = 0.0;
+    ra->worst_seconds = 0.0;
+    ra->ahead_instructions = 0;
+}
+
+bool run_ahead_frame(RunAhead* ra, NES* nes) {
+    double start = run_ahead_now();
+    if (!ra->frames) {
+        bool drawn = nes_run_frame(nes);
+        double seconds = run_ahead_now() - start;
+        ra->real_seconds += seconds;
+        if (seconds > ra->worst_seconds) { ra->worst_seconds = seconds; }
+        ra->count++;
+        return drawn;
+    }
+
+    // The real frame: heard, not seen.
+    u32* framebuffer = nes->ppu.framebuffer;
+    nes_set_framebuffer(nes, NULL);
+    nes_run_frame(nes);
+    double real_end = run_ahead_now();
+    savestate_capture(&ra->state, &nes->bus);
+    double capture_end = run_ahead_now();
+
+    // The frames ahead: seen (the last one only), not heard.
+    apu_set_muted(&nes->apu, true);
+    bool drawn = false;
+    for (u32 i = 1; i <= ra->frames; ++i) {
+        if (i == ra->frames) { nes_set_framebuffer(nes, framebuffer); }
+        drawn = nes_run_frame(nes);
+    }
+    apu_set_muted(&nes->apu, false);
+    double ahead_end = run_ahead_now();
+    ra->ahead_instructions += nes->cpu.instructions - ra->state.cpu_instructions;
+
+    // Unmuted first, so the restore picks the sound up where the real frame left it.
+    savestate_restore(&ra->state, &nes->bus);
+    double end = run_ahead_now();
+
+    ra->real_seconds += real_end - start;
+    ra->ahead_seconds += ahead_end - capture_end;
+    ra->snapshot_seconds += (capture_end - real_end) + (end - ahead_end);
+    if (end - start > ra->worst_seconds) { ra->worst_seconds = end - start; }
+    ra->count++;
+    return drawn;
+}
+
+void run_ahead_report(const RunAhead* ra, RunAheadReport* report) {
+    memset(report, 0, sizeof(RunAheadReport));
+    if (!ra->count) { return; }
+    double count = (double)ra->count;
+    report->real_ms = ra->real_seconds / count * 1e3;
+    report->ahead_ms = ra->frames ? ra->ahead_seconds / count / ra->frames * 1e3 : 0.0;
+    report->snapshot_ms = ra->snapshot_seconds / count * 1e3;
+    report->total_ms = report->real_ms + report->ahead_ms * ra->frames + report->snapshot_ms;
+    report->worst_ms = ra->worst_seconds * 1e3;
+    report->budget_used = report->total_ms / (RUN_AHEAD_FRAME_PERIOD * 1e3);
+
+    // Until frames have been run ahead, a real frame (which also mixes sound) stands in for one.
+    double per_frame = ra->frames ? report->ahead_ms : report->real_ms;
+    double left = RUN_AHEAD_BUDGET * RUN_AHEAD_FRAME_PERIOD * 1e3 - report->real_ms - report->snapshot_ms;
+    if (left > 0.0 && per_frame > 0.0) {
+        double fit = left / per_frame;
+        report->max_frames = fit >= RUN_AHEAD_MAX_FRAMES ? RUN_AHEAD_MAX_FRAMES : (u32)fit;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,64 @@
+#ifndef MYNES_C_RUNAHEAD_H
+#define MYNES_C_RUNAHEAD_H
+
+#include "common/types.h"
+#include "nes/nes.h"
+#include "savestate/savestate.h"
+
+// --- Run-Ahead ---
+// Hides the lag a game builds into its own input handling. Each host frame runs the real
+// frame (its sound is kept, its picture is not), snapshots the machine, runs 'frames' more
+// frames silently with the same input, shows the last of them and restores the snapshot.
+// The screen is then where the game will be 'frames' frames from now if the buttons stay as
+// they are, so a press shows up that many frames sooner. The real timeline is untouched:
+// movies, rewind and save states see exactly what they would without run-ahead.
+//
+// The price is frames + 1 emulated frames and a capture/restore per host frame, all of which
+// must fit into one frame period. The timings below say how much of it is used.
+#define RUN_AHEAD_MAX_FRAMES 8
+#define RUN_AHEAD_FRAME_PERIOD (1.0 / 60.0988) // Seconds per NTSC frame
+// Share of the period run-ahead may use; the rest is left for presenting, audio and the OS.
+#define RUN_AHEAD_BUDGET 0.75
+
+typedef struct RunAhead {
+    SaveState state;  // The real timeline while the frames ahead run
+    u32 frames;       // Frames to run ahead, 0 to run normally
+
+    // --- Timings ---
+    // Host seconds per phase, summed over 'count' host frames since the last reset.
+    u64 count;
+    double real_seconds;     // The real frame
+    double ahead_seconds;    // The frames run ahead
+    double snapshot_seconds; // Capture and restore
+    double worst_seconds;    // Slowest single host frame
+    u64 ahead_instructions;  // CPU instructions in the frames ahead, which the restore rolls back
+} RunAhead;
+
+// Averages over the frames timed so far, in milliseconds.
+typedef struct RunAheadReport {
+    double real_ms;
+    double ahead_ms;         // Per frame run ahead
+    double snapshot_ms;
+    double total_ms;         // Per host frame
+    double worst_ms;
+    double budget_used;      // total_ms over the frame period (1.0 = all of it)
+    u32 max_frames;          // Most frames that fit in RUN_AHEAD_BUDGET of the period at this rate
+} RunAheadReport;
+
+// --- Function Prototypes ---
+
+// Sets up run-ahead by 'frames' (clamped to RUN_AHEAD_MAX_FRAMES). Does no allocation.
+void run_ahead_init(RunAhead* ra, u32 frames);
+void run_ahead_set_frames(RunAhead* ra, u32 frames);
+void run_ahead_reset_stats(RunAhead* ra);
+
+/**
+ * @brief Runs one host frame in place of nes_run_frame(), with the same input for the real
+ * frame and the frames ahead. With 'frames' at 0 this is just nes_run_frame().
+ * @return Whether a picture was drawn into the framebuffer.
+ */
+bool run_ahead_frame(RunAhead* ra, NES* nes);
+
+void run_ahead_report(const RunAhead* ra, RunAheadReport* report);
+
+#endif // MYNES_C_RUNAHEAD_H
\ No newline at end of file
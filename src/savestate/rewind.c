@@ -0,0 +1,191 @@
+// The Golden Rule: Include your own header first.
+#include "savestate/rewind.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// --- Delta Encoding ---
+// A state is encoded as its XOR against a reference (the keyframe, or nothing for keyframes)
+// in chunks of: u16 count of zero bytes, u16 count of literal bytes, the literal bytes.
+// Literal runs only end at 8+ zero bytes, so every chunk header pays for itself.
+#define RUN_LIMIT 0xFFFF
+#define MIN_ZERO_RUN 8
+
+static inline u8 diff_at(const u8* cur, const u8* ref, u32 i) { return ref ? (u8)(cur[i] ^ ref[i]) : cur[i]; }
+
+static u32 count_zero_run(const u8* cur, const u8* ref, u32 i, u32 n) {
+    u32 start = i;
+    u32 limit = (n - i > RUN_LIMIT) ? i + RUN_LIMIT : n;
+    if (ref) {
+        // Most of a state (RAM banks a board does not have, untouched memory) is unchanged:
+        // skip it in blocks before narrowing down to the first difference.
+        while (i + 256 <= limit && memcmp(cur + i, ref + i, 256) == 0) { i += 256; }
+        for (; i + 8 <= limit; i += 8) {
+            u64 a, b;
+            memcpy(&a, cur + i, 8);
+            memcpy(&b, ref + i, 8);
+            if (a != b) { break; }
+        }
+    }
+    while (i < limit && diff_at(cur, ref, i) == 0) { i++; }
+    return i - start;
+}
+
+static u32 rewind_encode(const u8* cur, const u8* ref, u32 n, u8* out) {
+    u8* p = out;
+    u32 i = 0;
+    while (i < n) {
+        u32 zeros = count_zero_run(cur, ref, i, n);
+        i += zeros;
+        u32 start = i;
+        while (i < n && i - start < RUN_LIMIT) {
+            if (diff_at(cur, ref, i) == 0) {
+                u32 run = count_zero_run(cur, ref, i, n < i + MIN_ZERO_RUN ? n : i + MIN_ZERO_RUN);
+                if (run >= MIN_ZERO_RUN || i + run == n) { break; }
+                i += run;
+            } else {
+                i++;
+            }
+        }
+        if (i - start > RUN_LIMIT) { i = start + RUN_LIMIT; }
+        u16 header[2] = { (u16)zeros, (u16)(i - start) };
+        memcpy(p, header, sizeof(header));
+        p += sizeof(header);
+        for (u32 k = start; k < i; ++k) { *p++ = diff_at(cur, ref, k); }
+    }
+    return (u32)(p - out);
+}
+
+static void rewind_decode(const u8* in, u32 size, const u8* ref, u8* out, u32 n) {
+    const u8* end = in + size;
+    u32 pos = 0;
+    while (in < end && pos < n) {
+        u16 header[2];
+        memcpy(header, in, sizeof(header));
+        in += sizeof(header);
+        if (ref) { memcpy(out + pos, ref + pos, header[0]); }
+        else { memset(out + pos, 0, header[0]); }
+        pos += header[0];
+        for (u32 k = 0; k < header[1]; ++k, ++pos) { out[pos] = ref ? (u8)(*in++ ^ ref[pos]) : *in++; }
+    }
+}
+
+// --- Pool Management ---
+static inline RewindEntry* rewind_entry(Rewind* rw, u32 i) { return &rw->entries[(rw->first + i) % rw->max_entries]; }
+
+static void rewind_evict_oldest(Rewind* rw) {
+    RewindEntry* e = rewind_entry(rw, 0);
+    if (e->seq == rw->key_seq) { rw->has_key = false; }
+    rw->first = (rw->first + 1) % rw->max_entries;
+    rw->count--;
+}
+
+// Evicts the oldest keyframe group (a keyframe and the deltas that follow it).
+static void rewind_evict_group(Rewind* rw) {
+    rewind_evict_oldest(rw);
+    while (rw->count && rewind_entry(rw, 0)->seq != rewind_entry(rw, 0)->key_seq) { rewind_evict_oldest(rw); }
+}
+
+// Finds room for 'size' bytes after the newest entry, dropping the oldest history as needed.
+static u32 rewind_alloc(Rewind* rw, u32 size) {
+    u32 pos = rw->head;
+    if (pos + size > rw->pool_size) {
+        // Wrap. Whatever lives past the head is older than everything before it.
+        while (rw->count && rewind_entry(rw, 0)->offset >= rw->head) { rewind_evict_group(rw); }
+        pos = 0;
+    }
+    while (rw->count) {
+        RewindEntry* e = rewind_entry(rw, 0);
+        bool overlaps = e->offset < pos + size && pos < e->offset + e->size;
+        if (!overlaps) { break; }
+        rewind_evict_group(rw);
+    }
+    if (rw->count == rw->max_entries) { rewind_evict_group(rw); }
+    return pos;
+}
+
+bool rewind_init(Rewind* rw, u32 pool_bytes, u32 keyframe_interval, u32 frame_interval) {
+    memset(rw, 0, sizeof(Rewind));
+    rw->scratch_size = (u32)sizeof(SaveState) + 4 * ((u32)sizeof(SaveState) / RUN_LIMIT + 2) + 16;
+    if (pool_bytes < 2 * rw->scratch_size) { pool_bytes = 2 * rw->scratch_size; }
+    rw->pool_size = pool_bytes;
+    // Even a fully unchanged state costs a 4 byte chunk header, so this bounds the count.
+    rw->max_entries = pool_bytes / 4 + 1;
+    rw->keyframe_interval = keyframe_interval ? keyframe_interval : 1;
+    rw->frame_interval = frame_interval ? frame_interval : 1;
+    rw->pool = (u8*)malloc(rw->pool_size);
+    rw->entries = (RewindEntry*)malloc((size_t)rw->max_entries * sizeof(RewindEntry));
+    rw->scratch = (u8*)malloc(rw->scratch_size);
+    if (!rw->pool || !rw->entries || !rw->scratch) {
+        rewind_free(rw);
+        return false;
+    }
+    return true;
+}
+
+void rewind_free(Rewind* rw) {
+    free(rw->pool);
+    free(rw->entries);
+    free(rw->scratch);
+    rw->pool = NULL;
+    rw->entries = NULL;
+    rw->scratch = NULL;
+    rw->count = 0;
+}
+
+void rewind_push(Rewind* rw, const SaveState* state) {
+    if (++rw->frame_counter < rw->frame_interval) { return; }
+    rw->frame_counter = 0;
+
+    bool keyframe = !rw->has_key || rw->since_key >= rw->keyframe_interval;
+    const u8* ref = keyframe ? NULL : (const u8*)&rw->key;
+    u32 size = rewind_encode((const u8*)state, ref, sizeof(SaveState), rw->scratch);
+    u32 pos = rewind_alloc(rw, size);
+    // Making room may have dropped this delta's own keyframe; start a new group next time.
+    if (!keyframe && !rw->has_key) { return; }
+
+    u64 seq = rw->next_seq++;
+    if (keyframe) {
+        memcpy(&rw->key, state, sizeof(SaveState));
+        rw->key_seq = seq;
+        rw->has_key = true;
+        rw->since_key = 0;
+    }
+    rw->since_key++;
+
+    memcpy(rw->pool + pos, rw->scratch, size);
+    *rewind_entry(rw, rw->count) = (RewindEntry){ pos, size, seq, rw->key_seq };
+    rw->count++;
+    rw->head = pos + size;
+}
+
+bool rewind_pop(Rewind* rw, SaveState* out) {
+    if (rw->count == 0) { return false; }
+    RewindEntry e = *rewind_entry(rw, rw->count - 1);
+
+    if (e.seq == e.key_seq) {
+        rewind_decode(rw->pool + e.offset, e.size, NULL, (u8*)out, sizeof(SaveState));
+        rw->has_key = false; // The group is gone; the next push starts a new one
+        rw->since_key = 0;
+    } else {
+        if (!rw->has_key || rw->key_seq != e.key_seq) {
+            // Rewound into an older group: decode its keyframe (the entry e.seq - e.key_seq back).
+            RewindEntry* key = rewind_entry(rw, rw->count - 1 - (u32)(e.seq - e.key_seq));
+            rewind_decode(rw->pool + key->offset, key->size, NULL, (u8*)&rw->key, sizeof(SaveState));
+            rw->key_seq = e.key_seq;
+            rw->has_key = true;
+        }
+        rewind_decode(rw->pool + e.offset, e.size, (const u8*)&rw->key, (u8*)out, sizeof(SaveState));
+        rw->since_key = (u32)(e.seq - e.key_seq);
+    }
+    rw->count--;
+    rw->head = e.offset;
+    rw->next_seq = e.seq;
+    return true;
+}
+
+u32 rewind_bytes_used(const Rewind* rw) {
+    u32 used = 0;
+    for (u32 i = 0; i < rw->count; ++i) { used += rw->entries[(rw->first + i) % rw->max_entries].size; }
+    return used;
+}
\ No newline at end of file
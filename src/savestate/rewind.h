@@ -0,0 +1,62 @@
+#ifndef MYNES_C_REWIND_H
+#define MYNES_C_REWIND_H
+
+#include "common/types.h"
+#include "savestate/savestate.h"
+
+// --- Rewind Buffer ---
+// Keeps recent save states in a fixed-size byte pool. Every 'keyframe_interval'-th state is
+// a keyframe; the others are stored as the XOR against their keyframe, which is mostly zero
+// bytes, with the zero runs squeezed out. When the pool is full the oldest keyframe and its
+// deltas are dropped together. All memory is allocated by rewind_init().
+
+typedef struct RewindEntry {
+    u32 offset;   // Position of the encoded state in the pool
+    u32 size;     // Encoded size in bytes
+    u64 seq;      // Sequence number of this state
+    u64 key_seq;  // Sequence number of its keyframe (== seq for keyframes)
+} RewindEntry;
+
+typedef struct Rewind {
+    u8* pool;
+    u32 pool_size;
+    u32 head;            // Next write position in the pool
+
+    RewindEntry* entries; // Ring of live entries, oldest at 'first'
+    u32 max_entries;
+    u32 first;
+    u32 count;
+    u64 next_seq;
+
+    u32 keyframe_interval; // States per keyframe group
+    u32 frame_interval;    // Only every n-th rewind_push() is recorded
+    u32 frame_counter;
+
+    SaveState key;        // Decoded keyframe that the newest deltas are relative to
+    u64 key_seq;
+    bool has_key;
+    u32 since_key;        // States pushed since 'key' was recorded
+
+    u8* scratch;          // Encoder output, worst case sized
+    u32 scratch_size;
+} Rewind;
+
+/**
+ * @brief Allocates a rewind buffer.
+ * @param pool_bytes Memory for encoded states; older history is dropped once it is full.
+ * @param keyframe_interval Recorded states per keyframe (e.g. 60).
+ * @param frame_interval Record one state every this many frames (1 = every frame).
+ */
+bool rewind_init(Rewind* rw, u32 pool_bytes, u32 keyframe_interval, u32 frame_interval);
+void rewind_free(Rewind* rw);
+
+// Offers the state of the frame that just finished. Does no allocation.
+void rewind_push(Rewind* rw, const SaveState* state);
+
+// Removes the newest recorded state and decodes it into 'out'. Returns false when empty.
+bool rewind_pop(Rewind* rw, SaveState* out);
+
+// Bytes of the pool currently holding live states.
+u32 rewind_bytes_used(const Rewind* rw);
+
+#endif // MYNES_C_REWIND_H
\ No newline at end of file
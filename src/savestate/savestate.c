@@ -0,0 +1,185 @@
+// The Golden Rule: Include your own header first.
+#include "savestate/savestate.h"
+
+#include <stdio.h>
+#include <string.h>
+#include "controller/controller.h"
+#include "cpu/cpu.h"
+#include "ppu/ppu.h"
+
+void savestate_capture(SaveState* state, const Bus* bus) {
+    const CPU* cpu = bus->cpu;
+    const PPU* ppu = bus->ppu;
+    const APU* apu = bus->apu;
+    const Mapper* mapper = bus->mapper;
+    const Cartridge* cart = bus->cart;
+    const Scheduler* sched = bus->sched;
+
+    // Clearing first keeps padding bytes stable, which keeps rewind deltas small.
+    memset(state, 0, sizeof(SaveState));
+    memcpy(state->magic, SAVESTATE_MAGIC, 4);
+    state->version = SAVESTATE_VERSION;
+    state->size = sizeof(SaveState);
+    state->prg_rom_len = cart->prg_rom_len;
+    state->chr_rom_len = cart->chr_rom_len;
+    state->prg_ram_len = cart->prg_ram_len;
+    state->mapper_id = cart->mapper_id;
+
+    state->cpu_a = cpu->a;
+    state->cpu_x = cpu->x;
+    state->cpu_y = cpu->y;
+    state->cpu_sp = cpu->sp;
+    state->cpu_status = cpu_get_status(cpu);
+    state->cpu_irq_lines = cpu->irq_lines;
+    state->cpu_pc = cpu->pc;
+    state->cpu_cycles = cpu->cycles;
+    state->cpu_instructions = cpu->instructions;
+
+    memcpy(state->ram, bus->ram, RAM_SIZE);
+    state->oam_dma_page = bus->oam_dma_page;
+
+    memcpy(state->vram, ppu->vram, sizeof(state->vram));
+    memcpy(state->palette_ram, ppu->palette_ram, sizeof(state->palette_ram));
+    memcpy(state->oam, ppu->oam, sizeof(state->oam));
+    state->ppuctrl = ppu->ppuctrl;
+    state->ppumask = ppu->ppumask;
+    state->ppustatus = ppu->ppustatus;
+    state->oamaddr = ppu->oamaddr;
+    state->v = ppu->v;
+    state->t = ppu->t;
+    state->fine_x = ppu->fine_x;
+    state->w = ppu->w;
+    state->data_buffer = ppu->data_buffer;
+    state->io_latch = ppu->io_latch;
+    state->mirroring = (u8)ppu->mirroring;
+    state->overflow_pending = ppu->overflow_pending;
+    state->sprite0_dot = ppu->sprite0_dot;
+    state->scanline = ppu->scanline;
+    state->dot = ppu->dot;
+    state->dot_clock = ppu->dot_clock;
+    state->frame_start_dot = ppu->frame_start_dot;
+    state->frame = ppu->frame;
+
+    memcpy(state->apu, &apu->pulse, SAVESTATE_APU_SIZE);
+
+    for (int i = 0; i < 2; ++i) {
+        state->pad_shift[i] = bus->pads[i].shift;
+        state->pad_strobe[i] = bus->pads[i].strobe;
+    }
+
+    memcpy(state->prg_ram, mapper->prg_ram, cart->prg_ram_len);
+    if (cart->chr_is_ram) { memcpy(state->chr_ram, cart->chr_rom, cart->chr_rom_len); }
+    memcpy(state->mapper_regs, &mapper->bank, SAVESTATE_MAPPER_REGS_SIZE);
+
+    state->event_count = sched->count;
+    for (u32 i = 0; i < sched->count; ++i) {
+        state->event_types[i] = (u8)sched->queue[i].type;
+        state->event_times[i] = sched->queue[i].time;
+    }
+}
+
+bool savestate_restore(const SaveState* state, Bus* bus) {
+    CPU* cpu = bus->cpu;
+    PPU* ppu = bus->ppu;
+    APU* apu = bus->apu;
+    Mapper* mapper = bus->mapper;
+    Cartridge* cart = bus->cart;
+    Scheduler* sched = bus->sched;
+
+    if (memcmp(state->magic, SAVESTATE_MAGIC, 4) != 0 || state->version != SAVESTATE_VERSION ||
+        state->size != sizeof(SaveState) || state->prg_rom_len != cart->prg_rom_len ||
+        state->chr_rom_len != cart->chr_rom_len || state->prg_ram_len != cart->prg_ram_len ||
+        state->mapper_id != cart->mapper_id ||
+        state->event_count > EVENT_COUNT) {
+        return false;
+    }
+
+    cpu->a = state->cpu_a;
+    cpu->x = state->cpu_x;
+    cpu->y = state->cpu_y;
+    cpu->sp = state->cpu_sp;
+    cpu_set_status(cpu, state->cpu_status);
+    cpu->irq_lines = state->cpu_irq_lines;
+    cpu->pc = state->cpu_pc;
+    cpu->cycles = state->cpu_cycles;
+    cpu->instructions = state->cpu_instructions;
+
+    // RAM and PRG RAM are about to change behind the bus: drop code decoded from them.
+    bus_flush_code(bus);
+    memcpy(bus->ram, state->ram, RAM_SIZE);
+    bus->oam_dma_page = state->oam_dma_page;
+
+    memcpy(ppu->vram, state->vram, sizeof(state->vram));
+    memcpy(ppu->palette_ram, state->palette_ram, sizeof(state->palette_ram));
+    memcpy(ppu->oam, state->oam, sizeof(state->oam));
+    ppu->ppuctrl = state->ppuctrl;
+    ppu->ppumask = state->ppumask;
+    ppu->ppustatus = state->ppustatus;
+    ppu->oamaddr = state->oamaddr;
+    ppu->v = state->v;
+    ppu->t = state->t;
+    ppu->fine_x = state->fine_x;
+    ppu->w = state->w;
+    ppu->data_buffer = state->data_buffer;
+    ppu->io_latch = state->io_latch;
+    ppu->overflow_pending = state->overflow_pending;
+    ppu->sprite0_dot = state->sprite0_dot;
+    ppu->scanline = state->scanline;
+    ppu->dot = state->dot;
+    ppu->dot_clock = state->dot_clock;
+    ppu->frame_start_dot = state->frame_start_dot;
+    ppu->frame = state->frame;
+    ppu->palette_dirty = true;
+
+    memcpy(&apu->pulse, state->apu, SAVESTATE_APU_SIZE);
+    apu_sync(apu);
+
+    for (int i = 0; i < 2; ++i) {
+        bus->pads[i].shift = state->pad_shift[i];
+        bus->pads[i].strobe = state->pad_strobe[i] != 0;
+    }
+
+    memcpy(mapper->prg_ram, state->prg_ram, cart->prg_ram_len);
+    cartridge_load_chr_ram(cart, state->chr_ram);
+    memcpy(&mapper->bank, state->mapper_regs, SAVESTATE_MAPPER_REGS_SIZE);
+
+    // Rebuild the queue before the mapper re-times its events against it.
+    sched->count = state->event_count;
+    for (u32 i = 0; i < state->event_count; ++i) {
+        sched->queue[i].type = (EventType)state->event_types[i];
+        sched->queue[i].time = state->event_times[i];
+    }
+
+    // Pointers are derived state: re-point the banks, then the nametables (MMC3 mirroring
+    // lives outside the bank registers, so the saved layout wins).
+    mapper_sync(mapper);
+    ppu_set_mirroring(ppu, (Mirroring)state->mirroring);
+    return true;
+}
+
+bool savestate_write_file(const SaveState* state, const char* path) {
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        perror("Failed to open save state for writing");
+        return false;
+    }
+    bool ok = fwrite(state, sizeof(SaveState), 1, file) == 1;
+    if (fclose(file) != 0) { ok = false; }
+    if (!ok) { fprintf(stderr, "Failed to write save state.\n"); }
+    return ok;
+}
+
+bool savestate_read_file(SaveState* state, const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        perror("Failed to open save state");
+        return false;
+    }
+    bool ok = fread(state, sizeof(SaveState), 1, file) == 1;
+    fclose(file);
+    if (!ok || memcmp(state->magic, SAVESTATE_MAGIC, 4) != 0 || state->version != SAVESTATE_VERSION) {
+        fprintf(stderr, "Not a compatible save state: %s\n", path);
+        return false;
+    }
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,96 @@
+#ifndef MYNES_C_SAVESTATE_H
+#define MYNES_C_SAVESTATE_H
+
+#include <stddef.h>
+#include "common/types.h"
+#include "apu/apu.h"
+#include "bus/bus.h"
+#include "cartridge/cartridge.h"
+#include "mapper/mapper.h"
+#include "scheduler/scheduler.h"
+
+// --- Save State Format ---
+// A save state is one fixed-size block of fixed-width fields with no pointers, so taking a
+// snapshot is a handful of memcpys into caller-owned memory (no allocation), and the file
+// format is the same block written out in host byte order. Any layout change must bump
+// SAVESTATE_VERSION; loading rejects other versions.
+#define SAVESTATE_MAGIC "MNSS"
+#define SAVESTATE_VERSION 5
+
+// Board registers are the Mapper's trailing register union, copied as raw bytes.
+#define SAVESTATE_MAPPER_REGS_SIZE (sizeof(Mapper) - offsetof(Mapper, bank))
+// Likewise the APU's machine state: everything after its host-side synthesiser.
+#define SAVESTATE_APU_SIZE (sizeof(APU) - offsetof(APU, pulse))
+
+typedef struct SaveState {
+    // --- Header ---
+    char magic[4];
+    u32 version;
+    u32 size;       // sizeof(SaveState)
+    u32 prg_rom_len; // Identifies the cartridge the state belongs to
+    u32 chr_rom_len;
+    u32 prg_ram_len;
+    u16 mapper_id;
+
+    // --- CPU ---
+    u8 cpu_a, cpu_x, cpu_y, cpu_sp, cpu_status, cpu_irq_lines;
+    u16 cpu_pc;
+    u64 cpu_cycles;
+    u64 cpu_instructions;
+
+    // --- Bus ---
+    u8 ram[RAM_SIZE];
+    u8 oam_dma_page;
+
+    // --- PPU ---
+    u8 vram[2048];
+    u8 palette_ram[32];
+    u8 oam[256];
+    u8 ppuctrl, ppumask, ppustatus, oamaddr;
+    u16 v, t;
+    u8 fine_x, w, data_buffer, io_latch;
+    u8 mirroring;
+    u8 overflow_pending;
+    u16 sprite0_dot;
+    u16 scanline, dot;
+    u64 dot_clock;
+    u64 frame_start_dot;
+    u64 frame;
+
+    // --- APU ---
+    u8 apu[SAVESTATE_APU_SIZE];
+
+    // --- Controllers ---
+    // The held buttons are input, not machine state; the front end sets them every frame.
+    u8 pad_shift[2];
+    u8 pad_strobe[2];
+
+    // --- Cartridge / Mapper ---
+    u8 prg_ram[PRG_RAM_MAX_SIZE];  // The first prg_ram_len bytes are used
+    u8 chr_ram[CHR_RAM_MAX_SIZE];  // CHR RAM boards only: the first chr_rom_len bytes
+    u8 mapper_regs[SAVESTATE_MAPPER_REGS_SIZE];
+
+    // --- Scheduler ---
+    u32 event_count;
+    u8 event_types[EVENT_COUNT];
+    u64 event_times[EVENT_COUNT];
+} SaveState;
+
+// --- Function Prototypes ---
+
+/**
+ * @brief Captures the whole machine reachable from 'bus' into 'state'.
+ * Call between frames (or between scheduler slices), never from inside cpu_run().
+ */
+void savestate_capture(SaveState* state, const Bus* bus);
+
+/**
+ * @brief Restores a state captured from the same cartridge.
+ * @return false (leaving the machine untouched) if the header does not match.
+ */
+bool savestate_restore(const SaveState* state, Bus* bus);
+
+bool savestate_write_file(const SaveState* state, const char* path);
+bool savestate_read_file(SaveState* state, const char* path);
+
+#endif // MYNES_C_SAVESTATE_H
\ No newline at end of file
@@ -0,0 +1,87 @@
+// The Golden Rule: Include your own header first.
+#include "scheduler/scheduler.h"
+
+#include <string.h>
+#include "apu/apu.h"
+#include "bus/bus.h"
+#include "cpu/cpu.h"
+#include "mapper/mapper.h"
+#include "ppu/ppu.h"
+
+void scheduler_init(Scheduler* sched, CPU* cpu) {
+    memset(sched, 0, sizeof(Scheduler));
+    sched->cpu = cpu;
+}
+
+void scheduler_cancel(Scheduler* sched, EventType type) {
+    for (u32 i = 0; i < sched->count; ++i) {
+        if (sched->queue[i].type == type) {
+            memmove(&sched->queue[i], &sched->queue[i + 1], (sched->count - i - 1) * sizeof(Event));
+            sched->count--;
+            return;
+        }
+    }
+}
+
+void scheduler_schedule(Scheduler* sched, EventType type, u64 time) {
+    scheduler_cancel(sched, type);
+    // Insertion sort: the queue never holds more than EVENT_COUNT entries.
+    u32 i = sched->count;
+    while (i > 0 && sched->queue[i - 1].time > time) {
+        sched->queue[i] = sched->queue[i - 1];
+        i--;
+    }
+    sched->queue[i] = (Event){ time, type };
+    sched->count++;
+    // If the CPU is mid-run, make it stop in time for the new event.
+    if (sched->cpu && time < sched->cpu->deadline) { sched->cpu->deadline = time; }
+}
+
+u64 scheduler_next_time(const Scheduler* sched) {
+    return sched->count ? sched->queue[0].time : SCHEDULER_NEVER;
+}
+
+static void scheduler_dispatch(Scheduler* sched, Bus* bus, EventType type) {
+    switch (type) {
+        case EVENT_NMI:           cpu_nmi(sched->cpu, bus); break;
+        case EVENT_PPU_VBLANK:    ppu_catch_up(bus->ppu, bus, sched->cpu->cycles); break;
+        // Catching up runs the A12 edges; the mapper raises the IRQ line itself.
+        case EVENT_MAPPER_IRQ:
+            ppu_catch_up(bus->ppu, bus, sched->cpu->cycles);
+            if (bus->mapper) { mapper_resync(bus->mapper); }
+            break;
+        // The APU raises its IRQ lines (and stalls the CPU for DMC fetches) while catching up.
+        case EVENT_APU_FRAME_IRQ:
+        case EVENT_APU_DMC:       apu_catch_up(bus->apu, bus, sched->cpu->cycles); break;
+        case EVENT_OAM_DMA:       bus_oam_dma(bus); break;
+        case EVENT_COUNT:         break;
+    }
+}
+
+void scheduler_run_until(Scheduler* sched, Bus* bus, u64 target) {
+    CPU* cpu = sched->cpu;
+    while (cpu->cycles < target) {
+        u64 next = scheduler_next_time(sched);
+        cpu->deadline = next < target ? next : target;
+        cpu_run(cpu, bus);
+
+        // Dispatch everything that has come due. Handlers may queue new events (including
+        // ones that are due immediately), so re-check the head each time.
+        while (sched->count && sched->queue[0].time <= cpu->cycles) {
+            EventType type = sched->queue[0].type;
+            memmove(&sched->queue[0], &sched->queue[1], (sched->count - 1) * sizeof(Event));
+            sched->count--;
+            scheduler_dispatch(sched, bus, type);
+        }
+        cpu_poll_irq(cpu, bus);
+    }
+}
+
+void scheduler_run_frame(Scheduler* sched, Bus* bus) {
+    PPU* ppu = bus->ppu;
+    u64 frame = ppu->frame;
+    while (ppu->frame == frame) {
+        scheduler_run_until(sched, bus, ppu_frame_end_cycle(ppu));
+        ppu_catch_up(ppu, bus, sched->cpu->cycles);
+    }
+}
\ No newline at end of file
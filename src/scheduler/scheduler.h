@@ -0,0 +1,57 @@
+#ifndef MYNES_C_SCHEDULER_H
+#define MYNES_C_SCHEDULER_H
+
+#include "common/types.h"
+
+// Forward declare the components the scheduler drives.
+typedef struct Bus Bus;
+typedef struct CPU CPU;
+
+// --- Master Clock ---
+// Event times are absolute CPU cycles (the NTSC master clock divided by 12). The PPU runs
+// at exactly three dots per CPU cycle, so PPU timing converts without rounding drift.
+#define SCHEDULER_NEVER UINT64_MAX
+
+// --- Event Types ---
+// At most one event of each type is pending; scheduling a type again moves it.
+typedef enum {
+    EVENT_NMI,              // Take an NMI at the next instruction boundary
+    EVENT_PPU_VBLANK,       // Scanline 241, dot 1: catch the PPU up so vblank (and NMI) happen
+    EVENT_MAPPER_IRQ,       // Predicted cartridge IRQ (MMC3 scanline counter): catch the PPU up
+    EVENT_APU_FRAME_IRQ,    // APU frame sequencer IRQ asserts: catch the APU up
+    EVENT_APU_DMC,          // DMC sample buffer needs a byte: catch the APU up to fetch it
+    EVENT_OAM_DMA,          // $4014 transfer: copy 256 bytes and stall the CPU
+    EVENT_COUNT
+} EventType;
+
+typedef struct {
+    u64 time;
+    EventType type;
+} Event;
+
+typedef struct Scheduler {
+    Event queue[EVENT_COUNT]; // Sorted by time, earliest first
+    u32 count;
+    CPU* cpu;
+} Scheduler;
+
+// --- Function Prototypes ---
+void scheduler_init(Scheduler* sched, CPU* cpu);
+void scheduler_schedule(Scheduler* sched, EventType type, u64 time);
+void scheduler_cancel(Scheduler* sched, EventType type);
+u64 scheduler_next_time(const Scheduler* sched);
+
+/**
+ * @brief Runs the machine until the CPU clock reaches 'target'.
+ * The CPU executes uninterrupted up to the earliest pending event (or target), then the
+ * due events are dispatched and pending interrupts are taken.
+ */
+void scheduler_run_until(Scheduler* sched, Bus* bus, u64 target);
+
+/**
+ * @brief Runs until the end of the PPU's current frame (the end of pre-render scanline 261)
+ * and catches the PPU up to it.
+ */
+void scheduler_run_frame(Scheduler* sched, Bus* bus);
+
+#endif // MYNES_C_SCHEDULER_H
\ No newline at end of file
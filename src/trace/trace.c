@@ -0,0 +1,113 @@
+// The Golden Rule: Include your own header first.
+#include "trace/trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+static void trace_init_header(Trace* trace, u32 capacity) {
+    memset(trace->header, 0, sizeof(TraceHeader));
+    memcpy(trace->header->magic, TRACE_MAGIC, 4);
+    trace->header->version = TRACE_VERSION;
+    trace->header->record_size = (u32)sizeof(TraceRecord);
+    trace->header->capacity = capacity;
+    trace->records = (TraceRecord*)(trace->header + 1);
+    trace->mask = capacity - 1;
+}
+
+// Maps the ring onto a file sized for all of it. Returns false if the platform or the file
+// system cannot do that, in which case the caller falls back to memory.
+static bool trace_map_file(Trace* trace, const char* path) {
+#ifdef _WIN32
+    (void)trace;
+    (void)path;
+    return false;
+#else
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        perror(path);
+        return false;
+    }
+    void* view = MAP_FAILED;
+    if (ftruncate(fd, (off_t)trace->size) == 0) {
+        view = mmap(NULL, trace->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd); // The mapping keeps the file referenced
+    if (view == MAP_FAILED) { return false; }
+    trace->header = (TraceHeader*)view;
+    trace->mapped = true;
+    return true;
+#endif
+}
+
+bool trace_open(Trace* trace, const char* path, u32 capacity) {
+    memset(trace, 0, sizeof(Trace));
+    u32 rounded = 1024;
+    while (rounded < capacity && rounded < (1u << 31)) { rounded <<= 1; }
+    trace->size = sizeof(TraceHeader) + (size_t)rounded * sizeof(TraceRecord);
+    if (!path || !trace_map_file(trace, path)) {
+        trace->header = (TraceHeader*)calloc(1, trace->size);
+        if (!trace->header) {
+            fprintf(stderr, "Failed to allocate the trace ring.\n");
+            return false;
+        }
+        trace->path = path;
+    }
+    trace_init_header(trace, rounded);
+    return true;
+}
+
+void trace_close(Trace* trace) {
+    if (!trace->header) { return; }
+#ifndef _WIN32
+    if (trace->mapped) {
+        munmap(trace->header, trace->size);
+        memset(trace, 0, sizeof(Trace));
+        return;
+    }
+#endif
+    if (trace->path) {
+        FILE* file = fopen(trace->path, "wb");
+        bool ok = file && fwrite(trace->header, trace->size, 1, file) == 1;
+        if (file && fclose(file) != 0) { ok = false; }
+        if (!ok) { fprintf(stderr, "Failed to write trace: %s\n", trace->path); }
+    }
+    free(trace->header);
+    memset(trace, 0, sizeof(Trace));
+}
+
+// --- Reading Traces ---
+bool trace_reader_open(TraceReader* reader, const char* path) {
+    memset(reader, 0, sizeof(TraceReader));
+    if (!file_map_open(&reader->file, path)) { return false; }
+    const TraceHeader* header = (const TraceHeader*)reader->file.data;
+    bool ok = reader->file.size >= sizeof(TraceHeader) && memcmp(header->magic, TRACE_MAGIC, 4) == 0 &&
+              header->version == TRACE_VERSION && header->record_size == sizeof(TraceRecord) &&
+              header->capacity && (header->capacity & (header->capacity - 1)) == 0 &&
+              reader->file.size >= sizeof(TraceHeader) + (size_t)header->capacity * sizeof(TraceRecord);
+    if (!ok) {
+        fprintf(stderr, "Not a compatible trace file: %s\n", path);
+        file_map_close(&reader->file);
+        return false;
+    }
+    reader->header = header;
+    reader->records = (const TraceRecord*)(header + 1);
+    reader->count = header->count < header->capacity ? header->count : header->capacity;
+    reader->first = header->count - reader->count;
+    return true;
+}
+
+void trace_reader_close(TraceReader* reader) {
+    if (reader->header) { file_map_close(&reader->file); }
+    memset(reader, 0, sizeof(TraceReader));
+}
+
+const TraceRecord* trace_reader_get(const TraceReader* reader, u64 i) {
+    return &reader->records[(reader->first + i) & (reader->header->capacity - 1)];
+}
\ No newline at end of file
@@ -0,0 +1,75 @@
+#ifndef MYNES_C_TRACE_H
+#define MYNES_C_TRACE_H
+
+#include <stddef.h>
+#include "common/types.h"
+#include "common/file_map.h"
+
+// --- Instruction Trace ---
+// The CPU can log one fixed-size binary record per instruction into a ring of records, to be
+// formatted (as nestest.log text) and compared offline by the trace tool. Recording is a
+// handful of stores; nothing is formatted while the emulator runs. With a path, the ring is
+// a memory-mapped file: records land in the page cache and survive a crash of the emulator.
+// Without one, it is plain memory and trace_close() writes nothing.
+//
+// The hook only exists in builds with -DCPU_TRACE=1 (make TRACE=1); otherwise the CPU has
+// no trace pointer and no check in its dispatch loop.
+#ifndef CPU_TRACE
+#define CPU_TRACE 0
+#endif
+
+#define TRACE_MAGIC "MNTR"
+#define TRACE_VERSION 1
+
+typedef struct TraceRecord {
+    u64 cycle;      // CPU cycle at the start of the instruction
+    u16 pc;
+    u16 scanline;   // PPU position at that cycle
+    u16 dot;
+    u8 bytes[3];    // Opcode and operand bytes (only the instruction's length is meaningful)
+    u8 a, x, y, p, sp;
+    u8 reserved[2];
+} TraceRecord;
+
+typedef struct TraceHeader {
+    char magic[4];
+    u32 version;
+    u32 record_size; // sizeof(TraceRecord)
+    u32 capacity;    // Records in the ring, a power of two
+    u64 count;       // Records ever written; record i lives in slot i % capacity
+} TraceHeader;
+
+typedef struct Trace {
+    TraceHeader* header;   // Start of the mapping (or heap block); the ring follows it
+    TraceRecord* records;
+    u64 mask;              // capacity - 1
+    size_t size;           // Bytes of header plus ring
+    bool mapped;
+    const char* path;      // Heap-backed traces with a path are written out on close
+} Trace;
+
+/**
+ * @brief Creates a trace ring of at least 'capacity' records.
+ * @param path File to map the ring onto (created or truncated), or NULL for memory only.
+ */
+bool trace_open(Trace* trace, const char* path, u32 capacity);
+void trace_close(Trace* trace);
+
+// Claims the slot for the next record, overwriting the oldest once the ring is full.
+static inline TraceRecord* trace_next(Trace* trace) { return &trace->records[trace->header->count++ & trace->mask]; }
+
+// --- Reading Traces ---
+typedef struct TraceReader {
+    FileMap file;
+    const TraceHeader* header;
+    const TraceRecord* records;
+    u64 first; // Sequence number of the oldest record still in the ring
+    u64 count; // Records available
+} TraceReader;
+
+bool trace_reader_open(TraceReader* reader, const char* path);
+void trace_reader_close(TraceReader* reader);
+// The i-th available record, oldest first (i < reader->count).
+const TraceRecord* trace_reader_get(const TraceReader* reader, u64 i);
+
+#endif // MYNES_C_TRACE_H
\ No newline at end of file
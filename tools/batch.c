@@ -0,0 +1,335 @@
+// =============================================================================
+// batch.c - Parallel batch runner for the MyNES-C core.
+//
+// Runs a list of jobs (a ROM plus an optional input movie or file) for a fixed
+// number of frames each, sharding them across a work-stealing thread pool. Each job gets
+// its own NES instance; jobs on the same ROM share one read-only ROM image.
+// Every job reports its final framebuffer hash, so runs can be compared
+// against each other and across builds.
+//
+// Jobs file: one job per line, "<rom> [<input>]". '#' starts a comment. The
+// input is either an input movie (.mnm, as recorded by MyNES-C-movie) or a raw
+// file. A movie drives both controller ports and is played to its end; its
+// state hashes are checked as it goes, and a job that falls out of sync fails.
+// A raw file holds one byte of port 1 buttons per frame; the last byte is held
+// once the file runs out. A job whose ROM or input cannot be loaded fails on its
+// own; the other jobs still run.
+// =============================================================================
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "common/types.h"
+#include "common/hash.h"
+#include "common/json.h"
+#include "common/thread_pool.h"
+#include "movie/movie.h"
+#include "nes/nes.h"
+
+typedef struct {
+    const char* jobs_path;
+    const char* json_path;
+    const char* profile_path; // Profile report as JSON (MYNES_PROFILE builds only)
+    u32 threads; // 0 = one per CPU
+    u64 frames;
+} BatchOptions;
+
+typedef struct {
+    char rom_path[512];
+    char input_path[512];
+    RomImage* image;   // Shared with every other job on the same ROM
+    u8* input;         // Per-frame port 1 buttons, or NULL
+    u32 input_len;
+    Movie* movie;      // Input movie instead of raw input, or NULL
+
+    // Results
+    bool ok;
+    const char* error; // Why the job failed, or NULL
+    u64 desync;        // 1 + the first frame whose state hash differs from the movie's
+    u64 frames;
+    u64 cycles;
+    u64 frame_hash;    // FNV-1a of the final framebuffer
+    double seconds;
+    u32 worker;
+} BatchJob;
+
+typedef struct {
+    BatchJob* job;
+    const BatchOptions* opt;
+    u32* framebuffers; // One per worker
+} BatchTask;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void print_usage(const char* prog) {
+    fprintf(stderr,
+        "Usage: %s [options] --jobs <file>\n"
+        "  --jobs <path>      Jobs file, one \"<rom> [<input>]\" per line\n"
+        "  --frames <n>       Frames to run per job without a movie (default: 600)\n"
+        "  --threads <n>      Worker threads (default: one per CPU)\n"
+        "  --json <path>      Also write per-job results as JSON to <path>\n"
+        "  --profile <path>   Write the profile report, merged over all workers, as JSON\n"
+        "                     instead of to stderr (make PROFILE=1 builds)\n",
+        prog);
+}
+
+static bool parse_options(int argc, char* argv[], BatchOptions* opt) {
+    opt->jobs_path = NULL;
+    opt->json_path = NULL;
+    opt->profile_path = NULL;
+    opt->threads = 0;
+    opt->frames = 600;
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const char* val = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (strcmp(arg, "--jobs") == 0 && val) { opt->jobs_path = val; ++i; }
+        else if (strcmp(arg, "--frames") == 0 && val) { opt->frames = strtoull(val, NULL, 10); ++i; }
+        else if (strcmp(arg, "--threads") == 0 && val) { opt->threads = (u32)strtoul(val, NULL, 10); ++i; }
+        else if (strcmp(arg, "--json") == 0 && val) { opt->json_path = val; ++i; }
+        else if (strcmp(arg, "--profile") == 0 && val) { opt->profile_path = val; ++i; }
+        else { print_usage(argv[0]); return false; }
+    }
+    if (!opt->jobs_path) {
+        print_usage(argv[0]);
+        return false;
+    }
+    return true;
+}
+
+static u8* read_file(const char* path, u32* len) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        perror(path);
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    u8* data = (u8*)malloc(size > 0 ? (size_t)size : 1);
+    if (data && size > 0 && fread(data, (size_t)size, 1, file) != 1) {
+        free(data);
+        data = NULL;
+    }
+    fclose(file);
+    *len = size > 0 ? (u32)size : 0;
+    return data;
+}
+
+static BatchJob* read_jobs(const char* path, u32* count) {
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        perror("Failed to open jobs file");
+        return NULL;
+    }
+    u32 capacity = 16;
+    BatchJob* jobs = (BatchJob*)calloc(capacity, sizeof(BatchJob));
+    char line[1100];
+    *count = 0;
+    while (jobs && fgets(line, sizeof(line), file)) {
+        char* hash = strchr(line, '#');
+        if (hash) { *hash = '\0'; }
+        char rom[512], input[512];
+        int fields = sscanf(line, "%511s %511s", rom, input);
+        if (fields < 1) { continue; }
+        if (*count == capacity) {
+            capacity *= 2;
+            BatchJob* grown = (BatchJob*)realloc(jobs, capacity * sizeof(BatchJob));
+            if (!grown) { free(jobs); jobs = NULL; break; }
+            jobs = grown;
+        }
+        BatchJob* job = &jobs[(*count)++];
+        memset(job, 0, sizeof(BatchJob));
+        strcpy(job->rom_path, rom);
+        if (fields == 2) { strcpy(job->input_path, input); }
+    }
+    fclose(file);
+    return jobs;
+}
+
+static const char ROM_ERROR[] = "cannot load ROM";
+static const char INPUT_ERROR[] = "cannot read input";
+static const char MOVIE_ROM_ERROR[] = "movie recorded with a different ROM";
+
+// Whether the file starts like an input movie.
+static bool is_movie(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (!file) { return false; }
+    char magic[4];
+    bool movie = fread(magic, sizeof(magic), 1, file) == 1 && memcmp(magic, MOVIE_MAGIC, sizeof(magic)) == 0;
+    fclose(file);
+    return movie;
+}
+
+static bool load_movie(BatchJob* job) {
+    job->movie = (Movie*)malloc(sizeof(Movie));
+    if (job->movie && movie_load(job->movie, job->input_path)) { return true; }
+    free(job->movie);
+    job->movie = NULL;
+    return false;
+}
+
+// Loads each distinct ROM once; jobs on the same path share the image. A job whose files
+// cannot be loaded gets an error and is left out of the run.
+static void load_images(BatchJob* jobs, u32 count) {
+    for (u32 i = 0; i < count; ++i) {
+        BatchJob* job = &jobs[i];
+        for (u32 j = 0; j < i && !job->image && !job->error; ++j) {
+            if (strcmp(jobs[j].rom_path, job->rom_path) != 0) { continue; }
+            if (jobs[j].image) {
+                job->image = jobs[j].image;
+                rom_image_retain(job->image);
+            } else if (jobs[j].error == ROM_ERROR) {
+                job->error = ROM_ERROR; // Already failed to load; don't retry
+            }
+        }
+        if (!job->image && !job->error && !(job->image = rom_image_load(job->rom_path))) { job->error = ROM_ERROR; }
+        if (job->error || !job->input_path[0]) { continue; }
+        if (is_movie(job->input_path)) {
+            if (!load_movie(job)) { job->error = INPUT_ERROR; }
+            else if (!movie_matches_rom(job->movie, job->image)) { job->error = MOVIE_ROM_ERROR; }
+        } else if (!(job->input = read_file(job->input_path, &job->input_len))) {
+            job->error = INPUT_ERROR;
+        }
+    }
+}
+
+static void run_job(void* arg, u32 worker) {
+    BatchTask* task = (BatchTask*)arg;
+    BatchJob* job = task->job;
+    job->worker = worker;
+    NES* nes = (NES*)malloc(sizeof(NES));
+    if (!nes || !nes_init(nes, job->image)) {
+        job->error = "cannot power on";
+        free(nes);
+        return;
+    }
+    u32* framebuffer = task->framebuffers + (size_t)worker * PPU_SCREEN_WIDTH * PPU_SCREEN_HEIGHT;
+    memset(framebuffer, 0, PPU_SCREEN_WIDTH * PPU_SCREEN_HEIGHT * sizeof(u32));
+    nes_set_framebuffer(nes, framebuffer);
+
+    double start = now_seconds();
+    u64 start_cycles = nes->cpu.cycles;
+    u64 frames = job->movie ? job->movie->header.frames : task->opt->frames;
+    u64 frame = 0;
+    while (frame < frames) {
+        if (job->movie) { movie_play_input(job->movie, nes); }
+        else if (job->input_len) { nes_set_input(nes, 0, job->input[frame < job->input_len ? frame : job->input_len - 1]); }
+        nes_run_frame(nes);
+        frame++;
+        if (job->movie && !movie_check_frame(job->movie, nes)) {
+            job->desync = frame;
+            job->error = "desync";
+            break;
+        }
+    }
+    job->seconds = now_seconds() - start;
+    job->frames = frame;
+    job->cycles = nes->cpu.cycles - start_cycles;
+    job->frame_hash = fnv1a64(framebuffer, PPU_SCREEN_WIDTH * PPU_SCREEN_HEIGHT * sizeof(u32));
+    job->ok = !job->desync;
+    nes_free(nes);
+    free(nes);
+}
+
+static bool write_json(const char* path, const BatchJob* jobs, u32 count, u32 threads, double seconds) {
+    FILE* f = fopen(path, "w");
+    if (!f) {
+        perror("Failed to open JSON output");
+        return false;
+    }
+    u64 frames = 0;
+    for (u32 i = 0; i < count; ++i) { frames += jobs[i].frames; }
+    fprintf(f, "{\n");
+    fprintf(f, "  \"threads\": %u,\n", threads);
+    fprintf(f, "  \"seconds\": %.6f,\n", seconds);
+    fprintf(f, "  \"frames_per_sec\": %.2f,\n", (double)frames / (seconds > 0.0 ? seconds : 1e-9));
+    fprintf(f, "  \"jobs\": [\n");
+    for (u32 i = 0; i < count; ++i) {
+        const BatchJob* job = &jobs[i];
+        fprintf(f, "    {\"rom\": ");
+        json_write_string(f, job->rom_path);
+        fprintf(f, ", \"input\": ");
+        json_write_string(f, job->input_path);
+        fprintf(f, ", \"ok\": %s, ", job->ok ? "true" : "false");
+        if (job->error) {
+            fprintf(f, "\"error\": ");
+            json_write_string(f, job->error);
+            fprintf(f, ", ");
+        }
+        if (job->desync) { fprintf(f, "\"desync_frame\": %llu, ", (unsigned long long)(job->desync - 1)); }
+        fprintf(f, "\"frames\": %llu, \"cycles\": %llu, \"frame_hash\": \"%016llx\", \"seconds\": %.6f}%s\n",
+                (unsigned long long)job->frames, (unsigned long long)job->cycles, (unsigned long long)job->frame_hash,
+                job->seconds, i + 1 < count ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+    fclose(f);
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    BatchOptions opt;
+    if (!parse_options(argc, argv, &opt)) { return 1; }
+    if (opt.profile_path && !MYNES_PROFILE) {
+        fprintf(stderr, "--profile needs a profiling build (make clean && make PROFILE=1).\n");
+        return 1;
+    }
+    profile_install(opt.profile_path);
+
+    u32 count = 0;
+    BatchJob* jobs = read_jobs(opt.jobs_path, &count);
+    if (!jobs) { return 1; }
+    load_images(jobs, count);
+
+    ThreadPool* pool = thread_pool_create(opt.threads);
+    u32 threads = pool ? thread_pool_size(pool) : 0;
+    BatchTask* tasks = (BatchTask*)calloc(count ? count : 1, sizeof(BatchTask));
+    u32* framebuffers = (u32*)malloc((size_t)(threads ? threads : 1) * PPU_SCREEN_WIDTH * PPU_SCREEN_HEIGHT * sizeof(u32));
+    bool ok = pool && tasks && framebuffers;
+
+    double start = now_seconds();
+    for (u32 i = 0; ok && i < count; ++i) {
+        if (jobs[i].error) { continue; }
+        tasks[i] = (BatchTask){ &jobs[i], &opt, framebuffers };
+        ok = thread_pool_submit(pool, run_job, &tasks[i]);
+    }
+    thread_pool_destroy(pool);
+    double seconds = now_seconds() - start;
+
+    u64 frames = 0;
+    u32 failed = 0;
+    for (u32 i = 0; i < count; ++i) {
+        const BatchJob* job = &jobs[i];
+        frames += job->frames;
+        if (!job->ok) { failed++; }
+        const char* input = job->input_path[0] ? job->input_path : "-";
+        if (job->desync) {
+            printf("%-40s %-24s FAIL (desync at frame %llu)\n", job->rom_path, input, (unsigned long long)(job->desync - 1));
+            continue;
+        }
+        if (job->error) {
+            printf("%-40s %-24s FAIL (%s)\n", job->rom_path, input, job->error);
+            continue;
+        }
+        printf("%-40s %-24s %s %016llx %8.3f s (worker %u)\n", job->rom_path, input, job->ok ? "ok  " : "FAIL",
+               (unsigned long long)job->frame_hash, job->seconds, job->worker);
+    }
+    printf("Batch: %u jobs, %u failed, %u threads, %.3f s, %.2f frames/sec\n", count, failed, threads, seconds,
+           (double)frames / (seconds > 0.0 ? seconds : 1e-9));
+    if (ok && opt.json_path) { ok = write_json(opt.json_path, jobs, count, threads, seconds); }
+
+    for (u32 i = 0; i < count; ++i) {
+        rom_image_release(jobs[i].image);
+        free(jobs[i].input);
+        if (jobs[i].movie) { movie_free(jobs[i].movie); }
+        free(jobs[i].movie);
+    }
+    free(framebuffers);
+    free(tasks);
+    free(jobs);
+    return (ok && failed == 0) ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,324 @@
+// =============================================================================
+// bench.c - Headless benchmark runner for the MyNES-C core.
+//
+// Links the emulator core without SDL, runs a ROM for a number of frames (or
+// until an instruction budget is used up, rounded up to a whole frame) and
+// reports the emulation throughput.
+// Results can also be written as JSON so that builds can be compared.
+// =============================================================================
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "common/types.h"
+#include "common/json.h"
+#include "nes/nes.h"
+#include "savestate/savestate.h"
+#include "savestate/rewind.h"
+#include "runahead/runahead.h"
+#include "trace/trace.h"
+
+// NTSC CPU clock: 21.477272 MHz master clock / 12.
+#define NTSC_CPU_HZ 1789773.0
+
+typedef struct {
+    const char* rom_path;
+    const char* json_path;
+    u64 instructions; // Instruction budget, rounded up to a whole frame (used when frames == 0)
+    u64 frames;       // Frame budget
+    int entry;        // Start address override, or -1 to use the reset vector
+    bool rewind;      // Capture a save state into a rewind buffer after every frame
+    bool interpret;   // Disable the CPU's decoded block cache
+    bool no_idle_skip; // Run spin-wait loops iteration by iteration
+    u32 render_interval; // Draw 1 frame in N (fast-forward); 1 draws every frame
+    u32 run_ahead;    // Frames to run ahead per host frame, 0 for none
+    const char* trace_path; // Log every instruction here (CPU_TRACE builds only)
+    const char* profile_path; // Profile report as JSON (MYNES_PROFILE builds only)
+} BenchOptions;
+
+typedef struct {
+    u64 instructions;        // Emulated on the real timeline, idle-skipped ones included
+    u64 executed;            // Actually run, frames ahead included: the basis of the rates
+    u64 idle_instructions;   // Fast-forwarded by idle skipping instead
+    u64 cycles;
+    double frames;
+    u64 frames_drawn;
+    double seconds;
+    double snapshot_seconds; // Time spent in savestate_capture() + rewind_push()
+    double block_hit_rate;   // Block cache lookups that found a decoded block
+    u64 idle_skips;          // Spin-wait fast-forwards taken
+    u64 idle_cycles;         // CPU cycles they accounted for
+    u32 rewind_bytes;        // Rewind pool in use at the end of the run
+    u32 rewind_states;
+} BenchResult;
+
+// Rewind settings for --rewind, matching the SDL front end.
+#define BENCH_REWIND_POOL_BYTES (8u << 20)
+#define BENCH_REWIND_KEYFRAME_INTERVAL 60
+// Trace ring for --trace: the newest 4M instructions (96 MB).
+#define BENCH_TRACE_RECORDS (1u << 22)
+
+static double now_seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void print_usage(const char* prog) {
+    fprintf(stderr,
+        "Usage: %s [options]\n"
+        "  --rom <path>          ROM to run (default: nestest.nes)\n"
+        "  --instructions <n>    Run whole frames until at least n CPU instructions have run\n"
+        "                        (default: 5000000)\n"
+        "  --frames <n>          Run n NTSC frames instead of an instruction budget\n"
+        "  --entry <hex>         Start at this address instead of the reset vector\n"
+        "  --rewind              Record a rewind snapshot after every frame\n"
+        "  --interpret           Run the CPU without its decoded block cache\n"
+        "  --no-idle-skip        Do not fast-forward spin-wait loops\n"
+        "  --render-interval <n> Draw only 1 frame in n, as fast-forward does (default: 1)\n"
+        "  --run-ahead <n>       Run n frames ahead every frame and report the time budget\n"
+        "  --trace <path>        Log every instruction to a binary trace (make TRACE=1 builds)\n"
+        "  --profile <path>      Write the profile report as JSON instead of to stderr\n"
+        "                        (make PROFILE=1 builds)\n"
+        "  --json <path>         Also write the results as JSON to <path>\n",
+        prog);
+}
+
+static bool parse_options(int argc, char* argv[], BenchOptions* opt) {
+    opt->rom_path = "nestest.nes";
+    opt->json_path = NULL;
+    opt->instructions = 5000000;
+    opt->frames = 0;
+    opt->entry = -1;
+    opt->rewind = false;
+    opt->interpret = false;
+    opt->no_idle_skip = false;
+    opt->render_interval = 1;
+    opt->run_ahead = 0;
+    opt->trace_path = NULL;
+    opt->profile_path = NULL;
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const char* val = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (strcmp(arg, "--rom") == 0 && val) { opt->rom_path = val; ++i; }
+        else if (strcmp(arg, "--instructions") == 0 && val) { opt->instructions = strtoull(val, NULL, 10); opt->frames = 0; ++i; }
+        else if (strcmp(arg, "--frames") == 0 && val) { opt->frames = strtoull(val, NULL, 10); ++i; }
+        else if (strcmp(arg, "--entry") == 0 && val) { opt->entry = (int)strtol(val, NULL, 16); ++i; }
+        else if (strcmp(arg, "--json") == 0 && val) { opt->json_path = val; ++i; }
+        else if (strcmp(arg, "--rewind") == 0) { opt->rewind = true; }
+        else if (strcmp(arg, "--interpret") == 0) { opt->interpret = true; }
+        else if (strcmp(arg, "--no-idle-skip") == 0) { opt->no_idle_skip = true; }
+        else if (strcmp(arg, "--render-interval") == 0 && val) { opt->render_interval = (u32)strtoul(val, NULL, 10); ++i; }
+        else if (strcmp(arg, "--run-ahead") == 0 && val) { opt->run_ahead = (u32)strtoul(val, NULL, 10); ++i; }
+        else if (strcmp(arg, "--trace") == 0 && val) { opt->trace_path = val; ++i; }
+        else if (strcmp(arg, "--profile") == 0 && val) { opt->profile_path = val; ++i; }
+        else { print_usage(argv[0]); return false; }
+    }
+    return true;
+}
+
+static SaveState bench_state;
+static Rewind bench_rewind;
+static Trace bench_trace;
+static RunAhead bench_run_ahead;
+
+static void run_frame(const BenchOptions* opt, NES* nes, BenchResult* res) {
+    if (run_ahead_frame(&bench_run_ahead, nes)) { res->frames_drawn++; }
+    if (opt->rewind) {
+        double start = now_seconds();
+        savestate_capture(&bench_state, &nes->bus);
+        rewind_push(&bench_rewind, &bench_state);
+        res->snapshot_seconds += now_seconds() - start;
+    }
+}
+
+// Runs whole frames through the scheduler, exactly as the SDL front end does. In instruction
+// mode the run stops at the first frame boundary after the instruction budget is reached.
+static void run_bench(const BenchOptions* opt, NES* nes, BenchResult* res) {
+    CPU* cpu = &nes->cpu;
+    u64 start_cycles = cpu->cycles;
+    u64 start_instructions = cpu->instructions;
+#if CPU_BLOCK_CACHE
+    u64 start_idle_instructions = cpu->idle.skipped_instructions;
+#endif
+    u64 frames = 0;
+    res->snapshot_seconds = 0.0;
+    res->frames_drawn = 0;
+    double start = now_seconds();
+    if (opt->frames > 0) {
+        for (; frames < opt->frames; ++frames) { run_frame(opt, nes, res); }
+    } else {
+        while (cpu->instructions - start_instructions < opt->instructions) {
+            run_frame(opt, nes, res);
+            frames++;
+        }
+    }
+    res->seconds = now_seconds() - start;
+    res->rewind_bytes = opt->rewind ? rewind_bytes_used(&bench_rewind) : 0;
+    res->rewind_states = opt->rewind ? bench_rewind.count : 0;
+    res->instructions = cpu->instructions - start_instructions;
+#if CPU_BLOCK_CACHE
+    u64 lookups = cpu->block_cache.hits + cpu->block_cache.misses;
+    res->block_hit_rate = lookups ? (double)cpu->block_cache.hits / (double)lookups : 0.0;
+    res->idle_skips = cpu->idle.skips;
+    res->idle_cycles = cpu->idle.skipped_cycles;
+    res->idle_instructions = cpu->idle.skipped_instructions - start_idle_instructions;
+#else
+    res->block_hit_rate = 0.0;
+    res->idle_skips = 0;
+    res->idle_cycles = 0;
+    res->idle_instructions = 0;
+#endif
+    res->executed = res->instructions + bench_run_ahead.ahead_instructions - res->idle_instructions;
+    res->cycles = cpu->cycles - start_cycles;
+    res->frames = (double)frames;
+}
+
+static bool write_json(const char* path, const BenchOptions* opt, const BenchResult* res) {
+    FILE* f = fopen(path, "w");
+    if (!f) {
+        perror("Failed to open JSON output");
+        return false;
+    }
+    double secs = res->seconds > 0.0 ? res->seconds : 1e-9;
+    fprintf(f, "{\n");
+    fprintf(f, "  \"rom\": ");
+    json_write_string(f, opt->rom_path);
+    fprintf(f, ",\n");
+    fprintf(f, "  \"mode\": \"%s\",\n", opt->frames > 0 ? "frames" : "instructions");
+    fprintf(f, "  \"instructions\": %llu,\n", (unsigned long long)res->instructions);
+    fprintf(f, "  \"executed_instructions\": %llu,\n", (unsigned long long)res->executed);
+    fprintf(f, "  \"idle_instructions\": %llu,\n", (unsigned long long)res->idle_instructions);
+    fprintf(f, "  \"cycles\": %llu,\n", (unsigned long long)res->cycles);
+    fprintf(f, "  \"frames\": %.2f,\n", res->frames);
+    fprintf(f, "  \"frames_drawn\": %llu,\n", (unsigned long long)res->frames_drawn);
+    fprintf(f, "  \"render_interval\": %u,\n", opt->render_interval);
+    fprintf(f, "  \"seconds\": %.6f,\n", res->seconds);
+    fprintf(f, "  \"instructions_per_sec\": %.0f,\n", (double)res->executed / secs);
+    fprintf(f, "  \"cycles_per_sec\": %.0f,\n", (double)res->cycles / secs);
+    fprintf(f, "  \"frames_per_sec\": %.2f,\n", res->frames / secs);
+    fprintf(f, "  \"ns_per_step\": %.3f,\n", res->executed ? secs * 1e9 / (double)res->executed : 0.0);
+    fprintf(f, "  \"block_cache\": %s,\n", opt->interpret ? "false" : "true");
+    fprintf(f, "  \"block_hit_rate\": %.4f,\n", res->block_hit_rate);
+    fprintf(f, "  \"idle_skips\": %llu,\n", (unsigned long long)res->idle_skips);
+    fprintf(f, "  \"idle_cycles\": %llu,\n", (unsigned long long)res->idle_cycles);
+    if (opt->rewind) {
+        fprintf(f, "  \"snapshot_us\": %.3f,\n", res->frames > 0 ? res->snapshot_seconds * 1e6 / res->frames : 0.0);
+        fprintf(f, "  \"rewind_bytes\": %u,\n", res->rewind_bytes);
+        fprintf(f, "  \"rewind_states\": %u,\n", res->rewind_states);
+    }
+    if (opt->run_ahead) {
+        RunAheadReport report;
+        run_ahead_report(&bench_run_ahead, &report);
+        fprintf(f, "  \"run_ahead\": %u,\n", bench_run_ahead.frames);
+        fprintf(f, "  \"run_ahead_real_ms\": %.4f,\n", report.real_ms);
+        fprintf(f, "  \"run_ahead_frame_ms\": %.4f,\n", report.ahead_ms);
+        fprintf(f, "  \"run_ahead_snapshot_ms\": %.4f,\n", report.snapshot_ms);
+        fprintf(f, "  \"run_ahead_total_ms\": %.4f,\n", report.total_ms);
+        fprintf(f, "  \"run_ahead_worst_ms\": %.4f,\n", report.worst_ms);
+        fprintf(f, "  \"run_ahead_budget_used\": %.4f,\n", report.budget_used);
+        fprintf(f, "  \"run_ahead_max_frames\": %u,\n", report.max_frames);
+    }
+    fprintf(f, "  \"realtime_factor\": %.3f\n", (double)res->cycles / secs / NTSC_CPU_HZ);
+    fprintf(f, "}\n");
+    fclose(f);
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions opt;
+    if (!parse_options(argc, argv, &opt)) { return 1; }
+    if (opt.profile_path && !MYNES_PROFILE) {
+        fprintf(stderr, "--profile needs a profiling build (make clean && make PROFILE=1).\n");
+        return 1;
+    }
+    profile_install(opt.profile_path);
+
+    RomImage* image = rom_image_load(opt.rom_path);
+    if (!image) { return 1; }
+    static NES nes;
+    bool ok = nes_init(&nes, image);
+    rom_image_release(image); // The instance keeps its own reference
+    if (!ok) { return 1; }
+    nes_print_cartridge(&nes);
+    static u32 framebuffer[PPU_SCREEN_WIDTH * PPU_SCREEN_HEIGHT];
+    nes_set_framebuffer(&nes, framebuffer);
+    nes_set_render_interval(&nes, opt.render_interval);
+    run_ahead_init(&bench_run_ahead, opt.run_ahead);
+    if (opt.entry >= 0) { nes.cpu.pc = (u16)opt.entry; }
+    if (opt.interpret) { cpu_set_block_cache(&nes.cpu, false); }
+    if (opt.no_idle_skip) { cpu_set_idle_skip(&nes.cpu, false); }
+    if (opt.trace_path) {
+#if CPU_TRACE
+        if (!trace_open(&bench_trace, opt.trace_path, BENCH_TRACE_RECORDS)) {
+            nes_free(&nes);
+            return 1;
+        }
+        cpu_set_trace(&nes.cpu, &bench_trace);
+#else
+        fprintf(stderr, "--trace needs a tracing build (make clean && make TRACE=1).\n");
+        nes_free(&nes);
+        return 1;
+#endif
+    }
+
+    if (opt.rewind && !rewind_init(&bench_rewind, BENCH_REWIND_POOL_BYTES, BENCH_REWIND_KEYFRAME_INTERVAL, 1)) {
+        fprintf(stderr, "Failed to allocate the rewind buffer.\n");
+        nes_free(&nes);
+        return 1;
+    }
+
+    BenchResult res;
+    run_bench(&opt, &nes, &res);
+
+    double secs = res.seconds > 0.0 ? res.seconds : 1e-9;
+    printf("Benchmark: %s\n", opt.rom_path);
+    printf("  Instructions:     %llu\n", (unsigned long long)res.instructions);
+    if (res.executed != res.instructions) {
+        printf("    Executed:       %llu (%llu idle-skipped%s)\n", (unsigned long long)res.executed,
+               (unsigned long long)res.idle_instructions, opt.run_ahead ? ", frames ahead included" : "");
+    }
+    printf("  Cycles:           %llu\n", (unsigned long long)res.cycles);
+    printf("  Frames:           %.2f\n", res.frames);
+    if (opt.render_interval > 1) { printf("  Frames drawn:     %llu (1 in %u)\n", (unsigned long long)res.frames_drawn, opt.render_interval); }
+    printf("  Time:             %.3f s\n", res.seconds);
+    printf("  Instructions/sec: %.0f (executed)\n", (double)res.executed / secs);
+    printf("  Cycles/sec:       %.0f (%.2fx real time)\n", (double)res.cycles / secs, (double)res.cycles / secs / NTSC_CPU_HZ);
+    printf("  Frames/sec:       %.2f\n", res.frames / secs);
+    printf("  ns per cpu_step:  %.3f\n", res.executed ? secs * 1e9 / (double)res.executed : 0.0);
+    if (!opt.interpret) { printf("  Block hit rate:   %.2f%%\n", res.block_hit_rate * 100.0); }
+    if (res.idle_skips && opt.run_ahead) {
+        // The CPU's counters also cover the frames run ahead, which 'cycles' does not.
+        printf("  Idle skipped:     %llu cycles in %llu skips (frames ahead included)\n", (unsigned long long)res.idle_cycles,
+               (unsigned long long)res.idle_skips);
+    } else if (res.idle_skips) {
+        printf("  Idle skipped:     %llu cycles in %llu skips (%.2f%% of cycles)\n", (unsigned long long)res.idle_cycles,
+               (unsigned long long)res.idle_skips, res.cycles ? 100.0 * (double)res.idle_cycles / (double)res.cycles : 0.0);
+    }
+    if (opt.rewind) {
+        printf("  Snapshot+rewind:  %.3f us/frame\n", res.frames > 0 ? res.snapshot_seconds * 1e6 / res.frames : 0.0);
+        printf("  Rewind pool:      %u states in %u bytes\n", res.rewind_states, res.rewind_bytes);
+    }
+    if (opt.run_ahead) {
+        RunAheadReport report;
+        run_ahead_report(&bench_run_ahead, &report);
+        printf("  Run-ahead:        %u frames\n", bench_run_ahead.frames);
+        printf("    Real frame:     %.3f ms\n", report.real_ms);
+        printf("    Frame ahead:    %.3f ms each\n", report.ahead_ms);
+        printf("    Snapshot:       %.3f ms (capture + restore)\n", report.snapshot_ms);
+        printf("    Host frame:     %.3f ms (worst %.3f) = %.1f%% of %.2f ms\n", report.total_ms, report.worst_ms,
+               report.budget_used * 100.0, RUN_AHEAD_FRAME_PERIOD * 1e3);
+        printf("    Fits:           up to %u frames ahead in %.0f%% of a frame\n", report.max_frames, RUN_AHEAD_BUDGET * 100.0);
+    }
+
+    if (opt.json_path && !write_json(opt.json_path, &opt, &res)) {
+        trace_close(&bench_trace);
+        nes_free(&nes);
+        return 1;
+    }
+    trace_close(&bench_trace);
+    rewind_free(&bench_rewind);
+    nes_free(&nes);
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,306 @@
+// =============================================================================
+// movie.c - Headless input movie recorder and player for the MyNES-C core.
+//
+// Records a movie from a raw input file (one byte of port 1 buttons per frame,
+// or two bytes, port 1 then port 2, with --ports 2; the last frame is held
+// once the file runs out), or replays one unthrottled and checks every state
+// hash it carries. A replay is bit-exact, so long recorded sessions double as
+// performance and regression workloads: the exit status is 0 only if the whole
+// movie played back in sync.
+//
+// Either mode can capture every frame and its sound for datasets: as Y4M, raw
+// RGB24 or per-frame hashes, and as WAV, to files or to stdout for piping into an
+// encoder. A writer thread does the conversion and I/O behind a bounded queue.
+// =============================================================================
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "capture/capture.h"
+#include "common/types.h"
+#include "common/json.h"
+#include "movie/movie.h"
+#include "nes/nes.h"
+#include "runahead/runahead.h"
+
+typedef struct {
+    const char* rom_path;
+    const char* record_path;  // Record into this movie
+    const char* input_path;   // ... from this raw input file
+    const char* play_path;    // Or replay this one
+    const char* json_path;
+    u64 frames;               // Frames to record (default: as many as the input has)
+    u32 ports;
+    u32 hash_interval;
+    u32 render_interval;      // Playback: draw 1 frame in n, 0 to draw nothing
+    u32 run_ahead;            // Playback: frames to run ahead, which must not change the result
+    bool no_check;            // Playback: ignore the recorded hashes
+    CaptureOptions capture;
+} MovieOptions;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void print_usage(const char* prog) {
+    fprintf(stderr,
+        "Usage: %s --rom <path> (--record <movie> --input <raw> | --play <movie>) [options]\n"
+        "  --record <path>         Write a movie recorded from --input\n"
+        "  --input <path>          Raw input, one byte per port per frame\n"
+        "  --frames <n>            Frames to record (default: the length of the input)\n"
+        "  --ports <n>             Ports in the input and the movie, 1 or 2 (default: 1)\n"
+        "  --hash-interval <n>     Store a state hash every n frames, 0 for none (default: 1)\n"
+        "  --play <path>           Replay a movie as fast as possible\n"
+        "  --render-interval <n>   Draw 1 frame in n while playing, 0 to draw none (default: 0)\n"
+        "  --run-ahead <n>         Run n frames ahead while playing (default: 0)\n"
+        "  --no-check              Do not compare the recorded state hashes\n"
+        "  --video <path>          Capture every frame to <path> ('-' for stdout)\n"
+        "  --video-format <fmt>    y4m (YUV 4:2:0), rgb (raw RGB24) or hash (one hash per\n"
+        "                          frame, as text) (default: y4m)\n"
+        "  --audio <path>          Capture the sound as WAV to <path> ('-' for stdout)\n"
+        "  --capture-queue <n>     Frames the capture queue holds (default: %d)\n"
+        "  --capture-drop          Drop frames when the writer falls behind instead of waiting\n"
+        "  --json <path>           Also write the results as JSON to <path>\n",
+        prog, CAPTURE_DEFAULT_QUEUE);
+}
+
+static bool parse_video_format(const char* name, CaptureVideoFormat* format) {
+    if (strcmp(name, "y4m") == 0) { *format = CAPTURE_VIDEO_Y4M; }
+    else if (strcmp(name, "rgb") == 0) { *format = CAPTURE_VIDEO_RGB; }
+    else if (strcmp(name, "hash") == 0) { *format = CAPTURE_VIDEO_HASH; }
+    else { return false; }
+    return true;
+}
+
+static bool parse_options(int argc, char* argv[], MovieOptions* opt) {
+    memset(opt, 0, sizeof(MovieOptions));
+    opt->ports = 1;
+    opt->hash_interval = 1;
+    opt->capture.video_format = CAPTURE_VIDEO_Y4M;
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const char* val = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (strcmp(arg, "--rom") == 0 && val) { opt->rom_path = val; ++i; }
+        else if (strcmp(arg, "--record") == 0 && val) { opt->record_path = val; ++i; }
+        else if (strcmp(arg, "--input") == 0 && val) { opt->input_path = val; ++i; }
+        else if (strcmp(arg, "--play") == 0 && val) { opt->play_path = val; ++i; }
+        else if (strcmp(arg, "--json") == 0 && val) { opt->json_path = val; ++i; }
+        else if (strcmp(arg, "--frames") == 0 && val) { opt->frames = strtoull(val, NULL, 10); ++i; }
+        else if (strcmp(arg, "--ports") == 0 && val) { opt->ports = (u32)strtoul(val, NULL, 10); ++i; }
+        else if (strcmp(arg, "--hash-interval") == 0 && val) { opt->hash_interval = (u32)strtoul(val, NULL, 10); ++i; }
+        else if (strcmp(arg, "--render-interval") == 0 && val) { opt->render_interval = (u32)strtoul(val, NULL, 10); ++i; }
+        else if (strcmp(arg, "--run-ahead") == 0 && val) { opt->run_ahead = (u32)strtoul(val, NULL, 10); ++i; }
+        else if (strcmp(arg, "--no-check") == 0) { opt->no_check = true; }
+        else if (strcmp(arg, "--video") == 0 && val) { opt->capture.video_path = val; ++i; }
+        else if (strcmp(arg, "--video-format") == 0 && val && parse_video_format(val, &opt->capture.video_format)) { ++i; }
+        else if (strcmp(arg, "--audio") == 0 && val) { opt->capture.audio_path = val; ++i; }
+        else if (strcmp(arg, "--capture-queue") == 0 && val) { opt->capture.queue_frames = (u32)strtoul(val, NULL, 10); ++i; }
+        else if (strcmp(arg, "--capture-drop") == 0) { opt->capture.drop_when_full = true; }
+        else {
+            print_usage(argv[0]);
+            return false;
+        }
+    }
+    bool record = opt->record_path && opt->input_path;
+    if (!opt->rom_path || record == (opt->play_path != NULL) || opt->ports < 1 || opt->ports > MOVIE_MAX_PORTS) {
+        print_usage(argv[0]);
+        return false;
+    }
+    return true;
+}
+
+static u8* read_file(const char* path, u64* len) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        perror(path);
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    u8* data = (u8*)malloc(size > 0 ? (size_t)size : 1);
+    if (data && size > 0 && fread(data, (size_t)size, 1, file) != 1) {
+        free(data);
+        data = NULL;
+    }
+    fclose(file);
+    *len = size > 0 ? (u64)size : 0;
+    return data;
+}
+
+// Points the PPU at the capture's first buffer, if frames are being captured.
+static void start_capture(const MovieOptions* opt, Capture* capture, NES* nes) {
+    if (!capture || !opt->capture.video_path) { return; }
+    nes_set_framebuffer(nes, capture_framebuffer(capture));
+    nes_set_render_interval(nes, 1);
+}
+
+// Hands the frame just run and its sound to the capture, and moves the PPU on to the next buffer.
+static void capture_step(const MovieOptions* opt, Capture* capture, NES* nes) {
+    if (!capture) { return; }
+    u32 count;
+    const s16* samples = nes_drain_samples(nes, &count);
+    u32* next = capture_frame(capture, samples, count);
+    if (opt->capture.video_path) { nes_set_framebuffer(nes, next); }
+}
+
+// Waits for the writer to finish and reports on the capture. Returns false if it failed.
+static bool finish_capture(Capture* capture, CaptureStats* stats) {
+    memset(stats, 0, sizeof(CaptureStats));
+    if (!capture) { return true; }
+    bool ok = capture_close(capture, stats);
+    printf("  Captured:         %llu frames (%llu dropped), %llu samples, %.1f MB\n",
+           (unsigned long long)stats->frames_written, (unsigned long long)stats->frames_dropped,
+           (unsigned long long)stats->samples_written, (double)stats->bytes_written / (1024.0 * 1024.0));
+    printf("  Writer stalls:    %llu (%.3f s waiting), queue peaked at %u frames\n", (unsigned long long)stats->stalls,
+           stats->stall_seconds, stats->max_queued);
+    if (!ok) { fprintf(stderr, "Capture failed: the output is incomplete.\n"); }
+    return ok;
+}
+
+static int record(const MovieOptions* opt, NES* nes, Capture* capture) {
+    u64 len;
+    u8* input = read_file(opt->input_path, &len);
+    u64 available = len / opt->ports;
+    u64 frames = opt->frames ? opt->frames : available;
+    if (input && (!available || !frames)) { fprintf(stderr, "%s holds no complete frame of input.\n", opt->input_path); }
+    if (!input || !available || !frames) {
+        free(input);
+        if (capture) { capture_close(capture, NULL); }
+        return 1;
+    }
+
+    Movie movie;
+    movie_record_begin(&movie, nes, opt->ports, opt->hash_interval);
+    start_capture(opt, capture, nes);
+    bool ok = true;
+    double start = now_seconds();
+    for (u64 frame = 0; ok && frame < frames; ++frame) {
+        const u8* buttons = input + (frame < available ? frame : available - 1) * opt->ports;
+        for (u32 port = 0; port < opt->ports; ++port) { nes_set_input(nes, (int)port, buttons[port]); }
+        nes_run_frame(nes);
+        ok = movie_record_frame(&movie, nes);
+        capture_step(opt, capture, nes);
+    }
+    double seconds = now_seconds() - start;
+    free(input);
+    ok = ok && movie_save(&movie, opt->record_path);
+    if (ok) {
+        printf("Recorded %llu frames in %.3f s: %llu bytes of input, %llu state hashes.\n",
+               (unsigned long long)movie.header.frames, seconds, (unsigned long long)movie.header.input_size,
+               (unsigned long long)movie.header.hash_count);
+    }
+    CaptureStats stats;
+    ok = finish_capture(capture, &stats) && ok;
+    movie_free(&movie);
+    return ok ? 0 : 1;
+}
+
+static int play(const MovieOptions* opt, NES* nes, Capture* capture) {
+    Movie movie;
+    bool loaded = movie_load(&movie, opt->play_path);
+    if (loaded && !movie_matches_rom(&movie, nes->cart.image)) {
+        fprintf(stderr, "%s was recorded with a different ROM.\n", opt->play_path);
+        movie_free(&movie);
+        loaded = false;
+    }
+    if (!loaded) {
+        if (capture) { capture_close(capture, NULL); }
+        return 1;
+    }
+    static u32 framebuffer[PPU_SCREEN_WIDTH * PPU_SCREEN_HEIGHT];
+    if (opt->render_interval) {
+        nes_set_framebuffer(nes, framebuffer);
+        nes_set_render_interval(nes, opt->render_interval);
+    }
+    start_capture(opt, capture, nes);
+
+    static RunAhead run_ahead;
+    run_ahead_init(&run_ahead, opt->run_ahead);
+
+    u64 desync = 0; // 1 + the first frame whose hash differs
+    u64 start_cycles = nes->cpu.cycles;
+    double start = now_seconds();
+    while (movie_play_input(&movie, nes)) {
+        run_ahead_frame(&run_ahead, nes);
+        capture_step(opt, capture, nes);
+        if (!opt->no_check && !movie_check_frame(&movie, nes)) {
+            desync = movie.frame;
+            break;
+        }
+    }
+    double seconds = now_seconds() - start;
+    double secs = seconds > 0.0 ? seconds : 1e-9;
+    u64 cycles = nes->cpu.cycles - start_cycles;
+    bool checked = !opt->no_check && movie.header.hash_count > 0;
+
+    printf("Movie: %s\n", opt->play_path);
+    printf("  Frames:           %llu of %llu\n", (unsigned long long)movie.frame, (unsigned long long)movie.header.frames);
+    printf("  Time:             %.3f s\n", seconds);
+    printf("  Frames/sec:       %.2f (%.2fx real time)\n", (double)movie.frame / secs, (double)cycles / secs / APU_CPU_CLOCK);
+    if (desync) { printf("  DESYNC at frame %llu\n", (unsigned long long)(desync - 1)); }
+    else { printf("  Result:           %s\n", checked ? "in sync" : "played (no hashes checked)"); }
+    CaptureStats stats;
+    bool captured = finish_capture(capture, &stats);
+
+    if (opt->json_path) {
+        FILE* f = fopen(opt->json_path, "w");
+        if (f) {
+            fprintf(f, "{\n");
+            fprintf(f, "  \"movie\": ");
+            json_write_string(f, opt->play_path);
+            fprintf(f, ",\n  \"rom\": ");
+            json_write_string(f, opt->rom_path);
+            fprintf(f, ",\n");
+            fprintf(f, "  \"frames\": %llu,\n", (unsigned long long)movie.frame);
+            fprintf(f, "  \"seconds\": %.6f,\n", seconds);
+            fprintf(f, "  \"frames_per_sec\": %.2f,\n", (double)movie.frame / secs);
+            fprintf(f, "  \"hashes_checked\": %s,\n", checked ? "true" : "false");
+            fprintf(f, "  \"in_sync\": %s,\n", desync ? "false" : "true");
+            fprintf(f, "  \"desync_frame\": %lld,\n", desync ? (long long)(desync - 1) : -1LL);
+            fprintf(f, "  \"capture\": %s,\n", capture ? "true" : "false");
+            fprintf(f, "  \"capture_ok\": %s,\n", captured ? "true" : "false");
+            fprintf(f, "  \"frames_captured\": %llu,\n", (unsigned long long)stats.frames_written);
+            fprintf(f, "  \"frames_dropped\": %llu,\n", (unsigned long long)stats.frames_dropped);
+            fprintf(f, "  \"samples_captured\": %llu,\n", (unsigned long long)stats.samples_written);
+            fprintf(f, "  \"capture_stalls\": %llu,\n", (unsigned long long)stats.stalls);
+            fprintf(f, "  \"capture_stall_seconds\": %.6f,\n", stats.stall_seconds);
+            fprintf(f, "  \"capture_max_queued\": %u,\n", stats.max_queued);
+            fprintf(f, "  \"capture_bytes\": %llu\n", (unsigned long long)stats.bytes_written);
+            fprintf(f, "}\n");
+            fclose(f);
+        } else {
+            perror("Failed to open JSON output");
+        }
+    }
+    movie_free(&movie);
+    return desync || !captured ? 1 : 0;
+}
+
+int main(int argc, char* argv[]) {
+    MovieOptions opt;
+    if (!parse_options(argc, argv, &opt)) { return 1; }
+
+    // Opened first: once the capture owns stdout, the messages below go to stderr.
+    Capture* capture = NULL;
+    if (opt.capture.video_path || opt.capture.audio_path) {
+        capture = capture_open(&opt.capture);
+        if (!capture) { return 1; }
+    }
+    RomImage* image = rom_image_load(opt.rom_path);
+    static NES nes;
+    bool ok = image && nes_init(&nes, image);
+    rom_image_release(image); // The instance keeps its own reference
+    if (!ok) {
+        if (capture) { capture_close(capture, NULL); }
+        return 1;
+    }
+    nes_print_cartridge(&nes);
+
+    int status = opt.play_path ? play(&opt, &nes, capture) : record(&opt, &nes, capture);
+    nes_free(&nes);
+    return status;
+}
\ No newline at end of file
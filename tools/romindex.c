@@ -0,0 +1,284 @@
+// =============================================================================
+// romindex.c - ROM corpus indexer for the MyNES-C core.
+//
+// Scans a directory tree for .nes files and hashes (CRC32, SHA-1) and
+// classifies (NES 2.0 header, board support) every ROM in parallel on a
+// thread pool, writing the results to a compact index (see romindex.h).
+// Files whose size and mtime match the previous index are not re-read, so
+// re-indexing a library only touches new or changed ROMs. The index can then
+// answer lookups by checksum or path without opening any ROM.
+// =============================================================================
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "common/types.h"
+#include "common/file_map.h"
+#include "common/thread_pool.h"
+#include "romindex/romindex.h"
+
+typedef struct {
+    const char* build_dir;
+    const char* index_path;
+    const char* lookup;
+    u32 threads;
+    bool list;
+} IndexOptions;
+
+typedef struct {
+    char* path;
+    RomIndexEntry entry;
+    bool valid;
+    bool reused;
+    const char* error; // Why the file was skipped, or NULL
+} ScanItem;
+
+typedef struct {
+    ScanItem* items;
+    u32 count;
+    u32 capacity;
+} ScanList;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void print_usage(const char* prog) {
+    fprintf(stderr,
+        "Usage: %s [options]\n"
+        "  --build <dir>        Index every .nes file under <dir> (recursively)\n"
+        "  --index <path>       Index file to write or query (default: roms.idx)\n"
+        "  --threads <n>        Hashing threads (default: one per CPU)\n"
+        "  --lookup <key>       Find a ROM by CRC32 (8 hex digits), SHA-1 (40) or path\n"
+        "  --list               Print every entry of the index\n",
+        prog);
+}
+
+static bool parse_options(int argc, char* argv[], IndexOptions* opt) {
+    memset(opt, 0, sizeof(IndexOptions));
+    opt->index_path = "roms.idx";
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const char* val = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (strcmp(arg, "--build") == 0 && val) { opt->build_dir = val; ++i; }
+        else if (strcmp(arg, "--index") == 0 && val) { opt->index_path = val; ++i; }
+        else if (strcmp(arg, "--threads") == 0 && val) { opt->threads = (u32)strtoul(val, NULL, 10); ++i; }
+        else if (strcmp(arg, "--lookup") == 0 && val) { opt->lookup = val; ++i; }
+        else if (strcmp(arg, "--list") == 0) { opt->list = true; }
+        else { print_usage(argv[0]); return false; }
+    }
+    if (!opt->build_dir && !opt->lookup && !opt->list) {
+        print_usage(argv[0]);
+        return false;
+    }
+    return true;
+}
+
+// --- Directory Scan ---
+static bool has_nes_extension(const char* name) {
+    size_t len = strlen(name);
+    if (len < 4) { return false; }
+    const char* ext = name + len - 4;
+    return ext[0] == '.' && tolower((unsigned char)ext[1]) == 'n' && tolower((unsigned char)ext[2]) == 'e' &&
+           tolower((unsigned char)ext[3]) == 's';
+}
+
+static bool scan_add(ScanList* list, const char* path, const struct stat* st) {
+    if (list->count == list->capacity) {
+        u32 capacity = list->capacity ? list->capacity * 2 : 256;
+        ScanItem* grown = (ScanItem*)realloc(list->items, capacity * sizeof(ScanItem));
+        if (!grown) { return false; }
+        list->items = grown;
+        list->capacity = capacity;
+    }
+    ScanItem* item = &list->items[list->count];
+    memset(item, 0, sizeof(ScanItem));
+    item->path = (char*)malloc(strlen(path) + 1);
+    if (!item->path) { return false; }
+    strcpy(item->path, path);
+    item->entry.file_size = (u64)st->st_size;
+    item->entry.mtime = (s64)st->st_mtime;
+    list->count++;
+    return true;
+}
+
+static bool scan_directory(ScanList* list, const char* dir) {
+    DIR* d = opendir(dir);
+    if (!d) {
+        perror(dir);
+        return false;
+    }
+    bool ok = true;
+    struct dirent* ent;
+    while (ok && (ent = readdir(d)) != NULL) {
+        if (strcmp(ent->d_name, ".") == 0 || strcmp(ent->d_name, "..") == 0) { continue; }
+        size_t len = strlen(dir) + strlen(ent->d_name) + 2;
+        char* path = (char*)malloc(len);
+        if (!path) { ok = false; break; }
+        snprintf(path, len, "%s/%s", dir, ent->d_name);
+        struct stat st;
+        if (stat(path, &st) == 0) {
+            if (S_ISDIR(st.st_mode)) { ok = scan_directory(list, path); }
+            else if (S_ISREG(st.st_mode) && has_nes_extension(ent->d_name)) { ok = scan_add(list, path, &st); }
+        }
+        free(path);
+    }
+    closedir(d);
+    return ok;
+}
+
+// --- Hashing ---
+static void hash_item(void* arg, u32 worker) {
+    (void)worker;
+    ScanItem* item = (ScanItem*)arg;
+    // A bad file only costs its own entry: every failure is recorded and the build goes on.
+    FileMap map;
+    if (!file_map_open(&map, item->path)) {
+        item->error = "cannot be read";
+        return;
+    }
+    // A file that shrank since the scan may have been mapped past its new end, where reads fault.
+    if (map.size != item->entry.file_size) {
+        item->error = "changed while indexing";
+        file_map_close(&map);
+        return;
+    }
+    u64 file_size = item->entry.file_size;
+    s64 mtime = item->entry.mtime;
+    item->valid = rom_index_classify(&item->entry, map.data, map.size);
+    if (!item->valid) { item->error = "bad header or truncated"; }
+    item->entry.file_size = file_size;
+    item->entry.mtime = mtime;
+    file_map_close(&map);
+}
+
+static int build_index(const IndexOptions* opt) {
+    ScanList list = { 0 };
+    double start = now_seconds();
+    if (!scan_directory(&list, opt->build_dir)) { return 1; }
+
+    // Reuse entries whose file is unchanged since the last run.
+    RomIndex previous;
+    struct stat st;
+    bool have_previous = stat(opt->index_path, &st) == 0 && rom_index_open(&previous, opt->index_path);
+    ThreadPool* pool = thread_pool_create(opt->threads);
+    if (!pool) {
+        fprintf(stderr, "Failed to start the thread pool.\n");
+        return 1;
+    }
+    u32 reused = 0;
+    u64 hashed_bytes = 0;
+    for (u32 i = 0; i < list.count; ++i) {
+        ScanItem* item = &list.items[i];
+        const RomIndexEntry* old = have_previous ? rom_index_find_path(&previous, item->path) : NULL;
+        if (old && old->file_size == item->entry.file_size && old->mtime == item->entry.mtime) {
+            item->entry = *old;
+            item->valid = true;
+            item->reused = true;
+            reused++;
+            continue;
+        }
+        hashed_bytes += item->entry.file_size;
+        thread_pool_submit(pool, hash_item, item);
+    }
+    thread_pool_wait(pool);
+    u32 threads = thread_pool_size(pool);
+    thread_pool_destroy(pool);
+    if (have_previous) { rom_index_close(&previous); }
+
+    // Compact the valid entries and write the index.
+    RomIndexEntry* entries = (RomIndexEntry*)malloc((list.count ? list.count : 1) * sizeof(RomIndexEntry));
+    const char** paths = (const char**)malloc((list.count ? list.count : 1) * sizeof(char*));
+    u32 count = 0, invalid = 0;
+    for (u32 i = 0; entries && paths && i < list.count; ++i) {
+        if (!list.items[i].valid) {
+            fprintf(stderr, "Skipping invalid ROM: %s (%s)\n", list.items[i].path,
+                    list.items[i].error ? list.items[i].error : "not indexed");
+            invalid++;
+            continue;
+        }
+        entries[count] = list.items[i].entry;
+        paths[count] = list.items[i].path;
+        count++;
+    }
+    bool ok = entries && paths && rom_index_write(opt->index_path, entries, paths, count);
+    double seconds = now_seconds() - start;
+
+    printf("Indexed %u ROMs into %s (%u reused, %u hashed, %u invalid) with %u threads\n", count, opt->index_path, reused,
+           list.count - reused - invalid, invalid, threads);
+    printf("  %.3f s, %.1f MB/s hashed\n", seconds, (double)hashed_bytes / (1024.0 * 1024.0) / (seconds > 0.0 ? seconds : 1e-9));
+
+    for (u32 i = 0; i < list.count; ++i) { free(list.items[i].path); }
+    free(list.items);
+    free(entries);
+    free(paths);
+    return ok ? 0 : 1;
+}
+
+// --- Queries ---
+static void print_entry(const RomIndex* index, const RomIndexEntry* e) {
+    static const char* formats[] = { "iNES", "NES2.0", "archaic" };
+    static const char* mirrorings[] = { "H", "V", "1L", "1H", "4" };
+    static const char* timings[] = { "NTSC", "PAL", "multi", "Dendy" };
+    printf("%08x ", e->crc32);
+    for (int i = 0; i < SHA1_DIGEST_SIZE; ++i) { printf("%02x", e->sha1[i]); }
+    printf(" %-7s mapper %3u.%-2u PRG %4uK CHR %4uK %-2s %-5s%s%s%s %s\n", formats[e->format % 3], e->mapper_id, e->submapper,
+           e->prg_rom_len / 1024, e->chr_rom_len / 1024, mirrorings[e->mirroring % 5], timings[e->timing & 3],
+           (e->flags & ROM_INDEX_BATTERY) ? " battery" : "", (e->flags & ROM_INDEX_TRAINER) ? " trainer" : "",
+           (e->flags & ROM_INDEX_SUPPORTED) ? "" : " unsupported", rom_index_path(index, e));
+}
+
+static bool parse_hex(const char* s, u8* out, size_t bytes) {
+    if (strlen(s) != bytes * 2) { return false; }
+    for (size_t i = 0; i < bytes; ++i) {
+        unsigned int v;
+        if (!isxdigit((unsigned char)s[2 * i]) || !isxdigit((unsigned char)s[2 * i + 1]) || sscanf(s + 2 * i, "%2x", &v) != 1) { return false; }
+        out[i] = (u8)v;
+    }
+    return true;
+}
+
+static int query_index(const IndexOptions* opt) {
+    RomIndex index;
+    if (!rom_index_open(&index, opt->index_path)) { return 1; }
+    int status = 0;
+    if (opt->list) {
+        for (u32 i = 0; i < index.count; ++i) { print_entry(&index, &index.entries[i]); }
+    }
+    if (opt->lookup) {
+        u8 key[SHA1_DIGEST_SIZE];
+        const RomIndexEntry* e = NULL;
+        if (parse_hex(opt->lookup, key, 4)) {
+            u32 crc = (u32)key[0] << 24 | (u32)key[1] << 16 | (u32)key[2] << 8 | key[3];
+            // Duplicates (the same ROM under several names) are adjacent.
+            for (e = rom_index_find_crc32(&index, crc); e && e < index.entries + index.count && e->crc32 == crc; ++e) { print_entry(&index, e); }
+            e = rom_index_find_crc32(&index, crc);
+        } else if (parse_hex(opt->lookup, key, SHA1_DIGEST_SIZE)) {
+            if ((e = rom_index_find_sha1(&index, key)) != NULL) { print_entry(&index, e); }
+        } else if ((e = rom_index_find_path(&index, opt->lookup)) != NULL) {
+            print_entry(&index, e);
+        }
+        if (!e) {
+            fprintf(stderr, "No match for %s\n", opt->lookup);
+            status = 1;
+        }
+    }
+    rom_index_close(&index);
+    return status;
+}
+
+int main(int argc, char* argv[]) {
+    IndexOptions opt;
+    if (!parse_options(argc, argv, &opt)) { return 1; }
+    if (opt.build_dir) {
+        int status = build_index(&opt);
+        if (status != 0) { return status; }
+    }
+    return (opt.lookup || opt.list) ? query_index(&opt) : 0;
+}
\ No newline at end of file
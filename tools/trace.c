@@ -0,0 +1,264 @@
+// =============================================================================
+// trace.c - Offline formatter and differ for MyNES-C instruction traces.
+//
+// Reads a binary trace written by a CPU_TRACE build (e.g. the bench tool's
+// --trace option) and prints it in the layout of the reference nestest.log:
+//
+//   C000  4C F5 C5  JMP $C5F5                       A:00 X:00 Y:00 P:24 SP:FD PPU:  0, 21 CYC:7
+//
+// or compares it line by line against such a log. The comparison checks PC, A,
+// X, Y, P, SP and CYC (and the PPU position with --ppu); the disassembly text
+// is not compared, since the reference annotates operands with memory values
+// that a trace does not record. The first mismatch is shown with the lines
+// leading up to it.
+// =============================================================================
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/types.h"
+#include "cpu/cpu.h"
+#include "cpu/cpu_opcodes.h"
+#include "trace/trace.h"
+
+typedef struct {
+    const char* trace_path;
+    const char* diff_path;
+    const char* out_path;
+    u32 context;     // Lines shown before a mismatch
+    u32 max_errors;  // Stop after this many mismatches
+    bool ppu;        // Also compare the PPU position
+} TraceOptions;
+
+// --- Disassembly ---
+#define TRACE_NAME(code, kind, op, mode, cyc) #op,
+static const char* const op_names[256] = { CPU_OPCODE_TABLE(TRACE_NAME) };
+#undef TRACE_NAME
+#define TRACE_MODE(code, kind, op, mode, cyc) AM_##mode,
+static const u8 op_modes[256] = { CPU_OPCODE_TABLE(TRACE_MODE) };
+#undef TRACE_MODE
+
+static const u8 mode_lengths[] = {
+    [AM_IMP] = 1, [AM_ACC] = 1, [AM_IMM] = 2, [AM_ZP0] = 2, [AM_ZPX] = 2, [AM_ZPY] = 2, [AM_REL] = 2,
+    [AM_ABS] = 3, [AM_ABX] = 3, [AM_ABY] = 3, [AM_IND] = 3, [AM_IZX] = 2, [AM_IZY] = 2,
+};
+
+// nestest.log marks unofficial opcodes with '*', including the duplicate NOPs and SBC.
+static bool is_official(u8 opcode) {
+    static const char* const unofficial[] = {
+        "ign", "lax", "sax", "dcp", "isb", "slo", "rla", "sre", "rra", "anc", "alr",
+        "arr", "axs", "lxa", "xaa", "las", "shy", "shx", "sha", "tas", "jam",
+    };
+    const char* name = op_names[opcode];
+    for (size_t i = 0; i < sizeof(unofficial) / sizeof(unofficial[0]); ++i) {
+        if (strcmp(name, unofficial[i]) == 0) { return false; }
+    }
+    if (strcmp(name, "nop") == 0) { return opcode == 0xEA; }
+    if (strcmp(name, "sbc") == 0) { return opcode != 0xEB; }
+    return true;
+}
+
+static void format_operand(const TraceRecord* r, char* out, size_t size) {
+    u8 lo = r->bytes[1];
+    u16 word = (u16)(r->bytes[1] | r->bytes[2] << 8);
+    switch (op_modes[r->bytes[0]]) {
+        case AM_ACC: snprintf(out, size, " A"); break;
+        case AM_IMM: snprintf(out, size, " #$%02X", lo); break;
+        case AM_ZP0: snprintf(out, size, " $%02X", lo); break;
+        case AM_ZPX: snprintf(out, size, " $%02X,X", lo); break;
+        case AM_ZPY: snprintf(out, size, " $%02X,Y", lo); break;
+        case AM_REL: snprintf(out, size, " $%04X", (u16)(r->pc + 2 + (s8)lo)); break;
+        case AM_ABS: snprintf(out, size, " $%04X", word); break;
+        case AM_ABX: snprintf(out, size, " $%04X,X", word); break;
+        case AM_ABY: snprintf(out, size, " $%04X,Y", word); break;
+        case AM_IND: snprintf(out, size, " ($%04X)", word); break;
+        case AM_IZX: snprintf(out, size, " ($%02X,X)", lo); break;
+        case AM_IZY: snprintf(out, size, " ($%02X),Y", lo); break;
+        default: out[0] = '\0'; break;
+    }
+}
+
+// Formats one record as a nestest.log line (without the newline).
+static void format_record(const TraceRecord* r, char* line, size_t size) {
+    u8 opcode = r->bytes[0];
+    u8 length = mode_lengths[op_modes[opcode]];
+    char bytes[9];
+    snprintf(bytes, sizeof(bytes), length == 1 ? "%02X" : length == 2 ? "%02X %02X" : "%02X %02X %02X",
+             r->bytes[0], r->bytes[1], r->bytes[2]);
+
+    char mnemonic[4];
+    const char* name = strcmp(op_names[opcode], "ign") == 0 ? "nop" : op_names[opcode];
+    for (int i = 0; i < 3; ++i) { mnemonic[i] = (char)(name[i] - 'a' + 'A'); }
+    mnemonic[3] = '\0';
+    char operand[16];
+    format_operand(r, operand, sizeof(operand));
+    char text[32];
+    snprintf(text, sizeof(text), "%s%s", mnemonic, operand);
+
+    snprintf(line, size, "%04X  %-8s %c%-32sA:%02X X:%02X Y:%02X P:%02X SP:%02X PPU:%3u,%3u CYC:%llu",
+             r->pc, bytes, is_official(opcode) ? ' ' : '*', text, r->a, r->x, r->y, r->p, r->sp,
+             r->scanline, r->dot, (unsigned long long)r->cycle);
+}
+
+// --- Reference Log ---
+typedef struct {
+    u16 pc;
+    u8 a, x, y, p, sp;
+    unsigned scanline, dot;
+    unsigned long long cycle;
+    bool has_ppu, has_cycle;
+} LogLine;
+
+static bool parse_log_line(const char* line, LogLine* out) {
+    memset(out, 0, sizeof(LogLine));
+    char* end;
+    unsigned long pc = strtoul(line, &end, 16);
+    const char* regs = strstr(line, "A:");
+    if (end == line || !regs) { return false; }
+    out->pc = (u16)pc;
+    if (sscanf(regs, "A:%hhx X:%hhx Y:%hhx P:%hhx SP:%hhx", &out->a, &out->x, &out->y, &out->p, &out->sp) != 5) { return false; }
+    const char* ppu = strstr(regs, "PPU:");
+    out->has_ppu = ppu && sscanf(ppu, "PPU:%u,%u", &out->scanline, &out->dot) == 2;
+    const char* cyc = strstr(regs, "CYC:");
+    out->has_cycle = cyc && sscanf(cyc, "CYC:%llu", &out->cycle) == 1;
+    return true;
+}
+
+// Names the first field in which the record differs from the reference, or NULL.
+static const char* compare(const TraceRecord* r, const LogLine* ref, bool ppu) {
+    if (r->pc != ref->pc) { return "PC"; }
+    if (r->a != ref->a) { return "A"; }
+    if (r->x != ref->x) { return "X"; }
+    if (r->y != ref->y) { return "Y"; }
+    if (r->p != ref->p) { return "P"; }
+    if (r->sp != ref->sp) { return "SP"; }
+    if (ref->has_cycle && r->cycle != ref->cycle) { return "CYC"; }
+    if (ppu && ref->has_ppu && (r->scanline != ref->scanline || r->dot != ref->dot)) { return "PPU"; }
+    return NULL;
+}
+
+static int diff_trace(const TraceReader* reader, const TraceOptions* opt, FILE* out) {
+    FILE* log = fopen(opt->diff_path, "r");
+    if (!log) {
+        perror(opt->diff_path);
+        return 1;
+    }
+    char ref_line[256];
+    char our_line[160];
+    u64 line_no = 0;
+    // A wrapped ring starts part-way into the run: skip the reference lines it lost.
+    while (line_no < reader->first && fgets(ref_line, sizeof(ref_line), log)) { line_no++; }
+
+    u64 compared = 0;
+    u32 errors = 0;
+    for (u64 i = 0; i < reader->count && fgets(ref_line, sizeof(ref_line), log); ++i) {
+        line_no++;
+        ref_line[strcspn(ref_line, "\r\n")] = '\0';
+        LogLine ref;
+        if (!parse_log_line(ref_line, &ref)) {
+            fprintf(stderr, "%s:%llu: unrecognised line\n", opt->diff_path, (unsigned long long)line_no);
+            fclose(log);
+            return 1;
+        }
+        const TraceRecord* r = trace_reader_get(reader, i);
+        if (out) {
+            format_record(r, our_line, sizeof(our_line));
+            fprintf(out, "%s\n", our_line);
+        }
+        compared++;
+        const char* field = compare(r, &ref, opt->ppu);
+        if (!field) { continue; }
+
+        printf("Mismatch in %s at line %llu:\n", field, (unsigned long long)line_no);
+        u64 from = i > opt->context ? i - opt->context : 0;
+        for (u64 k = from; k < i; ++k) {
+            format_record(trace_reader_get(reader, k), our_line, sizeof(our_line));
+            printf("        %s\n", our_line);
+        }
+        format_record(r, our_line, sizeof(our_line));
+        printf("  got   %s\n  want  %s\n", our_line, ref_line);
+        if (++errors >= opt->max_errors) { break; }
+    }
+    fclose(log);
+    if (errors == 0) {
+        printf("%llu lines match", (unsigned long long)compared);
+        if (compared < reader->count) { printf(" (the reference log ends before the trace)"); }
+        printf(".\n");
+    }
+    return errors ? 1 : 0;
+}
+
+static void print_usage(const char* prog) {
+    fprintf(stderr,
+        "Usage: %s [options] <trace.bin>\n"
+        "  --diff <log>       Compare against a nestest.log-style reference\n"
+        "  --out <path>       Write the formatted trace to <path> (default: stdout\n"
+        "                     unless --diff is given)\n"
+        "  --ppu              Also compare the PPU scanline and dot\n"
+        "  --context <n>      Trace lines shown before a mismatch (default: 5)\n"
+        "  --max-errors <n>   Mismatches reported before stopping (default: 1)\n",
+        prog);
+}
+
+static bool parse_options(int argc, char* argv[], TraceOptions* opt) {
+    memset(opt, 0, sizeof(TraceOptions));
+    opt->context = 5;
+    opt->max_errors = 1;
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const char* val = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (strcmp(arg, "--diff") == 0 && val) { opt->diff_path = val; ++i; }
+        else if (strcmp(arg, "--out") == 0 && val) { opt->out_path = val; ++i; }
+        else if (strcmp(arg, "--ppu") == 0) { opt->ppu = true; }
+        else if (strcmp(arg, "--context") == 0 && val) { opt->context = (u32)strtoul(val, NULL, 10); ++i; }
+        else if (strcmp(arg, "--max-errors") == 0 && val) { opt->max_errors = (u32)strtoul(val, NULL, 10); ++i; }
+        else if (arg[0] != '-' && !opt->trace_path) { opt->trace_path = arg; }
+        else {
+            print_usage(argv[0]);
+            return false;
+        }
+    }
+    if (!opt->trace_path) {
+        print_usage(argv[0]);
+        return false;
+    }
+    if (opt->max_errors == 0) { opt->max_errors = 1; }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    TraceOptions opt;
+    if (!parse_options(argc, argv, &opt)) { return 1; }
+
+    TraceReader reader;
+    if (!trace_reader_open(&reader, opt.trace_path)) { return 1; }
+    if (reader.first) {
+        fprintf(stderr, "Trace ring wrapped: the oldest %llu records were overwritten.\n", (unsigned long long)reader.first);
+    }
+
+    FILE* out = NULL;
+    if (opt.out_path) {
+        out = fopen(opt.out_path, "w");
+        if (!out) {
+            perror(opt.out_path);
+            trace_reader_close(&reader);
+            return 1;
+        }
+    } else if (!opt.diff_path) {
+        out = stdout;
+    }
+
+    int status = 0;
+    if (opt.diff_path) {
+        status = diff_trace(&reader, &opt, out);
+    } else {
+        char line[160];
+        for (u64 i = 0; i < reader.count; ++i) {
+            format_record(trace_reader_get(&reader, i), line, sizeof(line));
+            fprintf(out, "%s\n", line);
+        }
+    }
+    if (out && out != stdout) { fclose(out); }
+    trace_reader_close(&reader);
+    return status;
+}
\ No newline at end of file